@@ -17,8 +17,8 @@
 #pragma once
 
 #ifdef VIA_ENABLE
-/* VIA configuration. */
-#    define DYNAMIC_KEYMAP_LAYER_COUNT 6
+/* VIA configuration: one EEPROM copy per layer of `keymaps`, none to spare. */
+#    define DYNAMIC_KEYMAP_LAYER_COUNT 5
 #endif // VIA_ENABLE
 
 #ifndef __arm__
@@ -26,12 +26,22 @@
 #    define NO_ACTION_ONESHOT
 #endif // __arm__
 
-#define SPLIT_LAYER_STATE_ENABLE  // comm overhead
-#define SPLIT_MODS_ENABLE
-#define SPLIT_LED_STATE_ENABLE
+// Layers, mods, caps-lock/word and maccel flags reach the other half in one
+// change-driven packet (see `user_state_task()` in `keymap.c`), instead of:
+// #define SPLIT_LAYER_STATE_ENABLE  // comm overhead
+// #define SPLIT_MODS_ENABLE
+// #define SPLIT_LED_STATE_ENABLE
+#ifdef SPLIT_MOTION_ENABLE
+#    define SPLIT_TRANSACTION_IDS_USER USER_SYNC_STATE, SPLIT_MOTION_SYNC
+#else
+#    define SPLIT_TRANSACTION_IDS_USER USER_SYNC_STATE
+#endif
+// #define USER_SYNC_HEARTBEAT_MS 250  // resend unchanged state this often
 
 #define CAPS_WORD_INVERT_ON_SHIFT
 
+#define LOCK_CHORD_KEYS 7 // the thumbs, and the partners of `keymap.c`
+
 // Home row mods settings
 #define TAPPING_TERM 200
 #define TAPPING_TERM_PER_KEY
@@ -50,38 +60,76 @@
 
 /* Charybdis-specific features. */
 
-#ifdef COMBO_ENABLE
-    #define COMBO_COUNT 9
-    #define COMBO_TERM 20
-    #define COMBO_ONLY_FROM_LAYER 0
-#endif
-
 #ifdef POINTING_DEVICE_ENABLE
 
-//#define CHARYBDIS_DRAGSCROLL_REVERSE_Y      // mimic up/down movement: scroll towards drag
-
-// Drag-scroll changes DPI on activation, but this causes issues,
-// better keep both identical (400).  So have to compensate drag-scroll divider
-//  (`CHARYBDIS_DRAGSCROLL_BUFFER_SIZE`)
-//
 // #define CHARYBDIS_MINIMUM_DEFAULT_DPI 400        // default(400)
 // #define CHARYBDIS_MINIMUM_SNIPING_DPI 200        // default(200)
 // #define CHARYBDIS_DEFAULT_DPI_CONFIG_STEP 200    // default(200)
 // #define CHARYBDIS_SNIPING_DPI_CONFIG_STEP 100    // default(100)
+
+// Drag-scroll is done by maccel (`DRGSCRL`/`DRG_TOG` are intercepted in `keymap.c`),
+// at the pointer DPI, with its own acceleration and no motion lost to the divider.
+#define MACCEL_USE_DRAGSCROLL
+#define MACCEL_DRAGSCROLL_DIVISOR 20                // counts per wheel step when slow
+// #define MACCEL_DRAGSCROLL_OFFSET 2.0             // counts/ms where scroll acceleration starts
+// #define MACCEL_DRAGSCROLL_GROWTH_RATE 0.25       // factor gained per count/ms past the offset
+// #define MACCEL_DRAGSCROLL_LIMIT 4.0              // maximum scroll acceleration factor
+// #define MACCEL_DRAGSCROLL_INTERVAL_MS 8          // wheel steps are sent at most this often
+// #define MACCEL_DRAGSCROLL_REVERSE_Y              // mimic up/down movement: scroll towards drag
+// High-resolution wheel: on hosts applying the HID resolution multiplier (Linux, Windows,
+// told apart by OS detection in `keymap.c`), drag-scroll sends 1/120 detents with every
+// report, instead of whole detents every `MACCEL_DRAGSCROLL_INTERVAL_MS`.
+#define POINTING_DEVICE_HIRES_SCROLL_ENABLE
+// #define POINTING_DEVICE_HIRES_SCROLL_MULTIPLIER 120 // default(120), steps per detent
+#define WHEEL_EXTENDED_REPORT                       // 16-bit wheel, or fast scrolls top out at 127/120 detents per report
+
+// Only used by charybdis' own drag-scroll, without `MACCEL_USE_DRAGSCROLL`.
 #define CHARYBDIS_DRAGSCROLL_DPI 400                // default(100)
 #define CHARYBDIS_DRAGSCROLL_BUFFER_SIZE 20         // default(6)
-
-// Send coalesced events with scroll values above ±1 (vs queueing ±1 events)?
 #define CHARYBDIS_DRAGSCROLL_SEND_COALESCE
 
+// The sensor is read adaptively by `pointing_scheduler.c` (`POINTING_SCHEDULER_ENABLE`
+// in `rules.mk`): slowly at rest, once per USB frame while moving, spaced out only while
+// the main loop runs over budget, and reports are coalesced per frame.  So the pointing
+// task is not throttled:
+#ifdef POINTING_SCHEDULER_ENABLE
+#    undef  POINTING_DEVICE_TASK_THROTTLE_MS
+#    define DEVICE_CPI_PARAM 0.087                  // maccel: the PMW3360, now behind a custom driver
+// (maccel keeps its PMW3360 `set_cpi` workaround under `POINTING_SCHEDULER_ENABLE` too)
+// #define POINTING_SCHEDULER_IDLE_INTERVAL_US 4000  // sensor read period at rest
+// #define POINTING_SCHEDULER_IDLE_TIMEOUT_MS 200    // no motion for this long slows reads down
+// #define POINTING_SCHEDULER_LOOP_BUDGET_US 1000    // main loop pass above which reads back off
+// #define POINTING_SCHEDULER_BACKOFF_MAX_US 4000    // longest spacing of reads while moving
+// #define POINTING_SCHEDULER_REPORT_INTERVAL_US 1000 // one report per USB frame, 0 for every pass
+#else
 // If need, reduce mouse events frequency to cope with MCU load;
 // note that it delays (but smoothens) drag-scrolling, particularly when
 // queued (ie. `CHARYBDIS_DRAGSCROLL_SEND_COALESCE` undefined).
 // #undef  POINTING_DEVICE_TASK_THROTTLE_MS
 // #define POINTING_DEVICE_TASK_THROTTLE_MS 5
-
-// For "maccel" configs, see `keymap.c` file.
-
-#define EECONFIG_USER_DATA_SIZE 20
+#endif // POINTING_SCHEDULER_ENABLE
+
+// With `SPLIT_MOTION_ENABLE` in `rules.mk`, and USB on the half without the trackball,
+// maccel runs on the trackball half and the master polls it once per USB frame over one
+// RPC (see `split_motion.h`), in place of QMK's split pointing sync:
+#ifdef SPLIT_MOTION_ENABLE
+#    undef SPLIT_POINTING_ENABLE
+// #define SPLIT_MOTION_RAW                         // send counts, accelerate on the master (with the sensor's timing)
+#endif // SPLIT_MOTION_ENABLE
+
+// For "maccel" tuning notes, see `keymap.c` file; the curves in use are these
+// profiles, picked by layer and sniping in `keymap.c` (`maccel_profile_update()`):
+// MACCEL_CONFIG(takeoff, growth rate, offset, limit)
+#define MACCEL_PROFILE_COUNT 3
+#define MACCEL_PROFILE_POINTING 0                   // everyday pointing
+#define MACCEL_PROFILE_PRECISE 1                    // sniping, navigation layer: gentler
+#define MACCEL_PROFILE_TRAVEL 2                     // pointer layer: long throws across monitors
+#define MACCEL_PROFILES {                                             \
+    [MACCEL_PROFILE_POINTING] = MACCEL_CONFIG(1.18, 0.56, 3.6, 9.0),  \
+    [MACCEL_PROFILE_PRECISE]  = MACCEL_CONFIG(1.18, 0.40, 6.0, 3.0),  \
+    [MACCEL_PROFILE_TRAVEL]   = MACCEL_CONFIG(1.50, 0.80, 2.5, 12.0), \
+}
+
+#define EECONFIG_USER_DATA_SIZE 36                  // maccel: 5 + 10 per profile
 
 #endif // POINTING_DEVICE_ENABLE
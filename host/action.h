@@ -0,0 +1,42 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/* action.h: key events as the keymap's process_record hooks see them */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint8_t col;
+    uint8_t row;
+} keypos_t;
+
+typedef struct {
+    keypos_t key;
+    bool     pressed;
+    uint16_t time;
+} keyevent_t;
+
+typedef struct {
+    bool    interrupted : 1;
+    uint8_t count : 3; // 0 once held, 1 when tapped
+} tap_t;
+
+typedef struct {
+    keyevent_t event;
+    tap_t      tap;
+} keyrecord_t;
@@ -0,0 +1,20 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/* atomic_util.h: on the host nothing interrupts, the block only runs once */
+
+#define ATOMIC_BLOCK_FORCEON for (int atomic_once_ = 1; atomic_once_; atomic_once_ = 0)
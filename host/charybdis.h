@@ -0,0 +1,194 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/* Stand-in for `QMK_KEYBOARD_H` (charybdis 3x6), so `keymap.c` itself compiles on a Linux host.
+ *
+ * Keycodes follow QMK's current numbering, and only those the keymap uses are here.
+ * The globals and APIs below are implemented in `keymap_stubs.c`.
+ */
+
+#include "quantum.h"
+#include "action.h"
+#include "report.h"
+
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+
+/* matrix: left half rows 0-3, right half rows 4-7 (columns mirrored) */
+#define MATRIX_ROWS 8
+#define MATRIX_COLS 6
+typedef uint8_t matrix_row_t;
+
+// clang-format off
+#define LAYOUT(                                                                         \
+    k00, k01, k02, k03, k04, k05,   k45, k44, k43, k42, k41, k40,                       \
+    k10, k11, k12, k13, k14, k15,   k55, k54, k53, k52, k51, k50,                       \
+    k20, k21, k22, k23, k24, k25,   k65, k64, k63, k62, k61, k60,                       \
+                   k33, k34, k35,   k73, k74)                                           \
+    {                                                                                   \
+        {k00, k01, k02, k03, k04, k05}, {k10, k11, k12, k13, k14, k15},                 \
+        {k20, k21, k22, k23, k24, k25}, {0, 0, 0, k33, k34, k35},                       \
+        {k40, k41, k42, k43, k44, k45}, {k50, k51, k52, k53, k54, k55},                 \
+        {k60, k61, k62, k63, k64, k65}, {0, 0, 0, k73, k74, 0},                         \
+    }
+// clang-format on
+
+/* keycodes.h: basic keycodes */
+enum {
+    KC_NO = 0x00,
+    KC_TRNS,
+    KC_A = 0x04, KC_B, KC_C, KC_D, KC_E, KC_F, KC_G, KC_H, KC_I, KC_J, KC_K, KC_L, KC_M,
+    KC_N, KC_O, KC_P, KC_Q, KC_R, KC_S, KC_T, KC_U, KC_V, KC_W, KC_X, KC_Y, KC_Z,
+    KC_1, KC_2, KC_3, KC_4, KC_5, KC_6, KC_7, KC_8, KC_9, KC_0,
+    KC_ENT, KC_ESC, KC_BSPC, KC_TAB, KC_SPC, KC_MINS, KC_EQL, KC_LBRC, KC_RBRC, KC_BSLS,
+    KC_NUHS, KC_SCLN, KC_QUOT, KC_GRV, KC_COMM, KC_DOT, KC_SLSH, KC_CAPS,
+    KC_F1, KC_F2, KC_F3, KC_F4, KC_F5, KC_F6, KC_F7, KC_F8, KC_F9, KC_F10, KC_F11, KC_F12,
+    KC_PSCR, KC_SCRL, KC_PAUS, KC_INS, KC_HOME, KC_PGUP, KC_DEL, KC_END, KC_PGDN,
+    KC_RGHT, KC_LEFT, KC_DOWN, KC_UP,
+    KC_APP = 0x65,
+    KC_BTN1 = 0xD1, KC_BTN2, KC_BTN3, KC_BTN4, KC_BTN5,
+    KC_LCTL = 0xE0, KC_LSFT, KC_LALT, KC_LGUI, KC_RCTL, KC_RSFT, KC_RALT, KC_RGUI,
+};
+#define XXXXXXX KC_NO
+#define _______ KC_TRNS
+
+/* modifiers.h: 5-bit mods of mod-taps and modded keycodes, bit 4 picks the right hand */
+enum {
+    MOD_LCTL = 0x01,
+    MOD_LSFT = 0x02,
+    MOD_LALT = 0x04,
+    MOD_LGUI = 0x08,
+    MOD_RCTL = 0x11,
+    MOD_RSFT = 0x12,
+    MOD_RALT = 0x14,
+    MOD_RGUI = 0x18,
+};
+#define MOD_BIT(code) (1 << ((code)&0x07))
+
+/* quantum_keycodes.h: ranges and the encodings the keymap's macros expand to */
+#define QK_MODS 0x0100
+#define QK_MODS_MAX 0x1FFF
+#define QK_MOD_TAP 0x2000
+#define QK_MOD_TAP_MAX 0x3FFF
+#define QK_LAYER_TAP 0x4000
+#define QK_LAYER_TAP_MAX 0x4FFF
+#define QK_TOGGLE_LAYER 0x5260
+#define QK_TOGGLE_LAYER_MAX 0x527F
+#define QK_CAPS_WORD_TOGGLE 0x7C73
+#define QK_KB 0x7E00
+#define QK_USER 0x7E40
+
+#define LCTL(kc) (QK_MODS | (MOD_LCTL << 8) | (kc))
+#define LSFT(kc) (QK_MODS | (MOD_LSFT << 8) | (kc))
+#define MT(mod, kc) (QK_MOD_TAP | (((mod)&0x1F) << 8) | ((kc)&0xFF))
+#define LT(layer, kc) (QK_LAYER_TAP | (((layer)&0x0F) << 8) | ((kc)&0xFF))
+#define TG(layer) (QK_TOGGLE_LAYER | ((layer)&0x1F))
+#define CW_TOGG QK_CAPS_WORD_TOGGLE
+
+#define LCTL_T(kc) MT(MOD_LCTL, kc)
+#define LSFT_T(kc) MT(MOD_LSFT, kc)
+#define LALT_T(kc) MT(MOD_LALT, kc)
+#define LGUI_T(kc) MT(MOD_LGUI, kc)
+#define RCTL_T(kc) MT(MOD_RCTL, kc)
+#define RSFT_T(kc) MT(MOD_RSFT, kc)
+
+#define IS_QK_MODS(kc) ((kc) >= QK_MODS && (kc) <= QK_MODS_MAX)
+#define IS_QK_MOD_TAP(kc) ((kc) >= QK_MOD_TAP && (kc) <= QK_MOD_TAP_MAX)
+#define IS_QK_LAYER_TAP(kc) ((kc) >= QK_LAYER_TAP && (kc) <= QK_LAYER_TAP_MAX)
+#define IS_QK_TOGGLE_LAYER(kc) ((kc) >= QK_TOGGLE_LAYER && (kc) <= QK_TOGGLE_LAYER_MAX)
+#define QK_MODS_GET_MODS(kc) (((kc) >> 8) & 0x1F)
+#define QK_MODS_GET_BASIC_KEYCODE(kc) ((kc)&0xFF)
+#define QK_LAYER_TAP_GET_LAYER(kc) (((kc) >> 8) & 0x0F)
+
+/* keymap_us.h: shifted symbols */
+#define KC_TILD LSFT(KC_GRV)
+#define KC_EXLM LSFT(KC_1)
+#define KC_AT LSFT(KC_2)
+#define KC_HASH LSFT(KC_3)
+#define KC_DLR LSFT(KC_4)
+#define KC_PERC LSFT(KC_5)
+#define KC_CIRC LSFT(KC_6)
+#define KC_AMPR LSFT(KC_7)
+#define KC_ASTR LSFT(KC_8)
+#define KC_LPRN LSFT(KC_9)
+#define KC_RPRN LSFT(KC_0)
+#define KC_UNDS LSFT(KC_MINS)
+#define KC_PLUS LSFT(KC_EQL)
+#define KC_LCBR LSFT(KC_LBRC)
+#define KC_RCBR LSFT(KC_RBRC)
+#define KC_PIPE LSFT(KC_BSLS)
+#define KC_COLN LSFT(KC_SCLN)
+#define KC_LABK LSFT(KC_COMM)
+#define KC_RABK LSFT(KC_DOT)
+#define KC_QUES LSFT(KC_SLSH)
+#define KC_UNDERSCORE KC_UNDS
+#define KC_QUESTION KC_QUES
+#define KC_LEFT_ANGLE_BRACKET KC_LABK
+#define KC_RIGHT_ANGLE_BRACKET KC_RABK
+
+/* charybdis.h */
+enum charybdis_keycodes {
+    POINTER_DEFAULT_DPI_FORWARD = QK_KB,
+    POINTER_DEFAULT_DPI_REVERSE,
+    POINTER_SNIPING_DPI_FORWARD,
+    POINTER_SNIPING_DPI_REVERSE,
+    SNIPING_MODE,
+    SNIPING_MODE_TOGGLE,
+    DRAGSCROLL_MODE,
+    DRAGSCROLL_MODE_TOGGLE,
+};
+#define DPI_MOD POINTER_DEFAULT_DPI_FORWARD
+#define DPI_RMOD POINTER_DEFAULT_DPI_REVERSE
+#define S_D_MOD POINTER_SNIPING_DPI_FORWARD
+#define S_D_RMOD POINTER_SNIPING_DPI_REVERSE
+#define SNIPING SNIPING_MODE
+#define SNP_TOG SNIPING_MODE_TOGGLE
+#define DRGSCRL DRAGSCROLL_MODE
+#define DRG_TOG DRAGSCROLL_MODE_TOGGLE
+
+bool charybdis_get_pointer_sniping_enabled(void);
+
+/* action_layer.h, modifiers, led state, caps word, split, timer, debug */
+extern layer_state_t layer_state;
+extern layer_state_t default_layer_state;
+void                 layer_on(uint8_t layer);
+void                 layer_off(uint8_t layer);
+bool                 layer_state_is(uint8_t layer);
+
+uint8_t get_mods(void);
+void    set_mods(uint8_t mods);
+void    add_weak_mods(uint8_t mods);
+
+typedef struct {
+    bool caps_lock : 1;
+} led_t;
+led_t host_keyboard_led_state(void);
+
+bool is_caps_word_on(void);
+bool is_keyboard_master(void);
+
+uint32_t timer_read32(void);
+uint32_t timer_elapsed32(uint32_t last);
+
+extern bool debug_enable;
+extern bool debug_matrix;
+extern bool debug_keyboard;
+
+/* Host-only: what the stubs above report, driven by the simulator. */
+extern uint32_t host_time_ms;
+extern bool     host_caps_word;
+/* Host-only: reads of `keymaps` by `keycode_at_keymap_location()`. */
+extern uint64_t host_keymap_reads;
@@ -0,0 +1,30 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+RGB      host_leds[RGB_MATRIX_LED_COUNT];
+uint32_t host_ticks;
+
+uint8_t get_highest_layer(layer_state_t state) {
+    return state ? 31 - __builtin_clz(state) : 0;
+}
+
+void rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
+    if (index >= 0 && index < RGB_MATRIX_LED_COUNT) {
+        host_leds[index] = (RGB){red, green, blue};
+    }
+}
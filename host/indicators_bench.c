@@ -0,0 +1,269 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Per-frame cost of the RGB indicators: the previous renderer (kept below as it was in
+ * `keymap.c`) against `indicators_render()`.
+ *
+ * Frames are replayed with state changing every `-c` frames on average (mods, layers,
+ * caps), as while typing. Every frame of both renderers is first compared LED by LED,
+ * then each is timed on its own.
+ */
+
+#include <getopt.h>
+#include <time.h>
+#include "quantum.h"
+#include "layers.h"
+#include "indicators.h"
+
+/* State the previous renderer read from QMK globals. */
+typedef struct {
+    bool caps_lock;
+} led_t;
+
+static layer_state_t layer_state, default_layer_state;
+static uint8_t       state_mods;
+static bool          state_caps_lock, state_caps_word;
+
+static uint8_t get_mods(void) {
+    return state_mods;
+}
+static led_t host_keyboard_led_state(void) {
+    return (led_t){.caps_lock = state_caps_lock};
+}
+static bool is_caps_word_on(void) {
+    return state_caps_word;
+}
+
+/* ---- previous renderer, unchanged apart from the state accessors ---- */
+
+const int8_t caps_lock_leds[] = {
+    20, // right-inner-top
+    49, // right-inner-top
+    -1
+};
+const int8_t caps_word_leds[] = {
+    21, // inner-2nd, on the other half
+    50, // left-inner-2nd
+    51, // left-inner-3rd
+    -1
+};
+
+const int8_t mod_shift_leds[] = {
+    28, // left-3rd-thumb
+    54, // right-2nd-thumb
+    -1
+};
+const int8_t mod_ctrl_leds[] = {
+    27, // left-2nd-thumb
+    53, // right-1st-thumb
+    -1
+};
+const int8_t mod_alt_leds[] = {
+    26, // left-1st-thumb
+    55, // right-bottom-thumb
+    -1
+};
+
+bool inarray(const int8_t *arr, int8_t led) {
+    while (*arr != -1 && *arr != led) arr++;
+    return *arr == led;
+}
+
+void rgb_matrix_colorify_led(uint8_t led, uint8_t mods, bool caps_lock, bool caps_word) {
+    RGB color = { 0, 0, 0 };
+    bool color_set = false;
+
+    void set_color(int r, int g, int b) {
+        color.r = r;
+        color.g = g;
+        color.b = b;
+        color_set = true;
+    }
+
+    if (led == 7 || led == 36) {  // 2nd top-outers combine mod colors
+        if (mods & MOD_MASK_SHIFT) {
+            color.g = 0xff;
+            color_set = true;
+        }
+        if (mods & MOD_MASK_CTRL) {
+            color.r = 0xff;
+            color_set = true;
+        }
+        if (mods & MOD_MASK_ALT) {
+            color.b = 0xff;
+            color_set = true;
+        }
+    } else if (caps_lock && inarray(caps_lock_leds, led)) {
+        set_color(RGB_WHITE);
+    }
+    else if (caps_word && inarray(caps_word_leds, led)) {
+        set_color(RGB_WHITE);
+    }
+    else if ((mods & (MOD_MASK_SHIFT | MOD_MASK_GUI)) && inarray(mod_shift_leds, led)) {
+        set_color(RGB_GREEN);
+    }
+    else if ((mods & (MOD_MASK_CTRL | MOD_MASK_GUI)) && inarray(mod_ctrl_leds, led)) {
+        set_color(RGB_RED);
+    }
+    else if ((mods & (MOD_MASK_ALT | MOD_MASK_GUI)) && inarray(mod_alt_leds, led)) {
+        set_color(RGB_BLUE);
+    }
+    else {
+        switch (get_highest_layer(layer_state | default_layer_state)) {
+        case LAYER_POINTER:
+            set_color(RGB_YELLOW);
+            break;
+        //case LAYER_FUNCTION:
+        //    set_color(RGB_MAGENTA);
+        //    break;
+        case LAYER_NAVIGATION:
+            set_color(RGB_CYAN);
+            break;
+        case LAYER_NUMERAL:
+            set_color(RGB_BLUE);
+            break;
+        case LAYER_SYMBOLS:
+            set_color(RGB_CORAL);
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (color_set) {
+        rgb_matrix_set_color(led, color.r, color.g, color.b);
+    }
+}
+
+static bool legacy_indicators(uint8_t led_min, uint8_t led_max) {
+    uint8_t mods = get_mods();
+    bool caps_lock = host_keyboard_led_state().caps_lock;
+    bool caps_word = is_caps_word_on();
+
+    for (uint8_t led = led_min; led <= led_max; led++) {
+        rgb_matrix_colorify_led(led, mods, caps_lock, caps_word);
+    }
+
+    return false;
+}
+
+/* ---- benchmark ---- */
+
+static uint32_t xorshift32(uint32_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+// the state to show in each frame: mostly unchanged, with a change every `change_every` frames on average
+static void next_state(uint32_t *rng, uint32_t change_every) {
+    if (xorshift32(rng) % change_every) {
+        return;
+    }
+    switch (xorshift32(rng) % 4) {
+        case 0:
+            state_mods = xorshift32(rng) & 0xFF;
+            break;
+        case 1:
+            layer_state = (layer_state_t)1 << (xorshift32(rng) % (LAYER_SYMBOLS + 1));
+            break;
+        case 2:
+            state_caps_lock = !state_caps_lock;
+            break;
+        default:
+            state_caps_word = !state_caps_word;
+            break;
+    }
+}
+
+// what the effect paints before the indicators, to see which LEDs they leave alone
+static void effect_frame(void) {
+    memset(host_leds, 0x11, sizeof(host_leds));
+}
+
+static void legacy_frame(void) {
+    effect_frame();
+    legacy_indicators(0, RGB_MATRIX_LED_COUNT - 1); // it treated `led_max` as inclusive
+}
+
+static void table_frame(void) {
+    effect_frame();
+    indicators_render(0, RGB_MATRIX_LED_COUNT, layer_state | default_layer_state, state_mods, state_caps_lock, state_caps_word);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double time_frames(void (*frame)(void), uint32_t frames, uint32_t change_every) {
+    uint32_t     rng   = 1;
+    const double start = now_ns();
+    for (uint32_t i = 0; i < frames; i++) {
+        next_state(&rng, change_every);
+        frame();
+    }
+    return (now_ns() - start) / frames;
+}
+
+int main(int argc, char **argv) {
+    uint32_t frames       = 1000000;
+    uint32_t change_every = 60; // a key event every ~60 frames
+    int      opt;
+    while ((opt = getopt(argc, argv, "n:c:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                frames = strtoul(optarg, NULL, 0);
+                break;
+            case 'c':
+                change_every = strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr,
+                        "usage: %s [-n FRAMES] [-c CHANGE_EVERY]\n"
+                        "  -n FRAMES        frames to render (default 1000000)\n"
+                        "  -c CHANGE_EVERY  state changes every that many frames on average (default 60)\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+    if (change_every == 0) {
+        change_every = 1;
+    }
+
+    RGB      expected[RGB_MATRIX_LED_COUNT];
+    uint32_t rng = 1;
+    for (uint32_t i = 0; i < frames; i++) {
+        next_state(&rng, change_every);
+        legacy_frame();
+        memcpy(expected, host_leds, sizeof(expected));
+        table_frame();
+        for (uint8_t led = 0; led < RGB_MATRIX_LED_COUNT; led++) {
+            if (memcmp(&expected[led], &host_leds[led], sizeof(RGB)) != 0) {
+                fprintf(stderr, "frame %u, led %u: previous %02X%02X%02X, table %02X%02X%02X\n", i, led, expected[led].r, expected[led].g, expected[led].b, host_leds[led].r, host_leds[led].g, host_leds[led].b);
+                return 1;
+            }
+        }
+    }
+    printf("%u frames match\n", frames);
+
+    const double legacy_ns = time_frames(legacy_frame, frames, change_every);
+    const double table_ns  = time_frames(table_frame, frames, change_every);
+    printf("previous: %.1f ns/frame, table: %.1f ns/frame (%.1fx)\n", legacy_ns, table_ns, legacy_ns / table_ns);
+    return 0;
+}
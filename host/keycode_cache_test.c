@@ -0,0 +1,242 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks of `keycode_cache.c` against QMK's layer walk, then what it saves per key event.
+ *
+ * The keymap is a random one: a full base layer and mostly transparent overlays, more of
+ * them than fit the sparse copy this is built with.  Key events are resolved the way QMK's
+ * `get_event_keycode()` does, through `keymap_key_to_keycode()`, and compared with the same
+ * walk over the keymap itself while layers change, releases read the layer of their press,
+ * and VIA edits keys.
+ */
+
+#include <getopt.h>
+#include <time.h>
+#include "charybdis.h"
+#include "keymap_introspection.h"
+#include "keycode_cache.h"
+#include "via.h"
+
+#define LAYERS 6
+
+bool via_command_kb(uint8_t *data, uint8_t length);
+
+static uint16_t keymap[LAYERS][MATRIX_ROWS][MATRIX_COLS];
+static uint64_t reads;
+static uint32_t read_spins; // busy loop per read, standing in for an EEPROM access
+
+layer_state_t layer_state;
+layer_state_t default_layer_state = 1;
+
+uint8_t keymap_layer_count(void) {
+    return LAYERS;
+}
+
+uint16_t keycode_at_keymap_location(uint8_t layer_num, uint8_t row, uint8_t column) {
+    reads++;
+    for (volatile uint32_t spin = 0; spin < read_spins; spin++) {
+    }
+    return layer_num < LAYERS ? keymap[layer_num][row][column] : KC_TRNS;
+}
+
+static int failures;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+static uint32_t rng_state = 1;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// a keycode of its own on one key in `density` of an overlay
+static uint16_t random_keycode(uint8_t layer, uint8_t density) {
+    if (layer > 0 && rng() % 100 >= density) {
+        return KC_TRNS;
+    }
+    return KC_A + rng() % (KC_SLSH - KC_A);
+}
+
+static void random_keymap(uint8_t density) {
+    for (uint8_t layer = 0; layer < LAYERS; layer++) {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                keymap[layer][row][col] = random_keycode(layer, density);
+            }
+        }
+    }
+}
+
+// QMK's `layer_switch_get_layer()`
+static uint8_t switch_layer(keypos_t key, uint16_t (*read)(uint8_t, keypos_t)) {
+    const layer_state_t state = layer_state | default_layer_state;
+    for (int8_t layer = LAYERS - 1; layer >= 0; layer--) {
+        if ((state & ((layer_state_t)1 << layer)) && read(layer, key) != KC_TRNS) {
+            return layer;
+        }
+    }
+    return get_highest_layer(default_layer_state);
+}
+
+static uint16_t read_keymap(uint8_t layer, keypos_t key) {
+    return keycode_at_keymap_location(layer, key.row, key.col);
+}
+
+static keypos_t random_key(void) {
+    return (keypos_t){.row = rng() % MATRIX_ROWS, .col = rng() % MATRIX_COLS};
+}
+
+static void via_edit(uint8_t layer, keypos_t key, uint16_t keycode) {
+    uint8_t data[32] = {id_dynamic_keymap_set_keycode, layer, key.row, key.col, keycode >> 8, keycode & 0xFF};
+    CHECK(!via_command_kb(data, sizeof(data)));
+    keymap[layer][key.row][key.col] = keycode;
+}
+
+static void check_against_walk(uint32_t events) {
+    keypos_t held[4];
+    uint8_t  held_layer[4];
+    for (uint8_t i = 0; i < 4; i++) {
+        held[i]       = random_key();
+        held_layer[i] = switch_layer(held[i], keymap_key_to_keycode);
+    }
+    for (uint32_t i = 0; i < events; i++) {
+        switch (rng() % 8) {
+            case 0:
+                layer_state = rng() & (((layer_state_t)1 << LAYERS) - 1);
+                break;
+            case 1:
+                default_layer_state = (layer_state_t)1 << (rng() % 2);
+                break;
+            case 2:
+                via_edit(rng() % LAYERS, random_key(), random_keycode(1, 50));
+                break;
+        }
+        // a press: its layer and keycode, as the walk over the keymap finds them
+        const keypos_t key   = random_key();
+        const uint8_t  layer = switch_layer(key, keymap_key_to_keycode);
+        CHECK(layer == switch_layer(key, read_keymap));
+        CHECK(keymap_key_to_keycode(layer, key) == read_keymap(layer, key));
+
+        // a release, of a key pressed before the layers changed, reads its press's layer
+        const uint8_t slot = rng() % 4;
+        CHECK(keymap_key_to_keycode(held_layer[slot], held[slot]) == read_keymap(held_layer[slot], held[slot]));
+        held[slot]       = key;
+        held_layer[slot] = layer;
+
+        // and whatever else reads the keymap, any layer, active or not
+        const keypos_t other       = random_key();
+        const uint8_t  other_layer = rng() % LAYERS;
+        CHECK(keymap_key_to_keycode(other_layer, other) == read_keymap(other_layer, other));
+    }
+    // positions outside the matrix
+    CHECK(keymap_key_to_keycode(0, (keypos_t){.row = 0xFF, .col = 0xFF}) == KC_NO);
+    layer_state         = 0;
+    default_layer_state = 1;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// key events of typing that changes layers every `per_layer` events: reads and time each
+static void time_events(const char *label, uint16_t (*read)(uint8_t, keypos_t), uint32_t events, uint32_t per_layer) {
+    volatile uint16_t sink = 0;
+    const uint64_t    from = reads;
+    rng_state              = 1;
+    const double start     = now_ns();
+    for (uint32_t i = 0; i < events; i++) {
+        if (i % per_layer == 0) {
+            layer_state = (layer_state_t)1 << (rng() % LAYERS);
+        }
+        const keypos_t key = random_key();
+        sink ^= read(switch_layer(key, read), key);
+    }
+    const double ns = (now_ns() - start) / (events ? events : 1);
+    (void)sink;
+    printf("  %-10s %6.2f keymap reads, %5.1f ns per event\n", label, (double)(reads - from) / (events ? events : 1), ns);
+    layer_state = 0;
+}
+
+// busy loop iterations that take `ns`
+static uint32_t spins_for(uint32_t ns) {
+    const uint32_t calibration = 10000000;
+    if (ns == 0) {
+        return 0;
+    }
+    const double start = now_ns();
+    for (volatile uint32_t spin = 0; spin < calibration; spin++) {
+    }
+    return (uint32_t)(ns * (double)calibration / (now_ns() - start));
+}
+
+int main(int argc, char **argv) {
+    uint32_t events  = 1000000;
+    uint32_t read_ns = 0;
+    int      opt;
+    while ((opt = getopt(argc, argv, "n:e:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                events = strtoul(optarg, NULL, 0);
+                break;
+            case 'e':
+                read_ns = strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr,
+                        "usage: %s [-n EVENTS] [-e NS]\n"
+                        "  -n EVENTS  key events to time (default 1000000)\n"
+                        "  -e NS      make each keymap read take this much longer, as VIA's EEPROM copy does (default 0)\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+
+    // sparse overlays, then denser ones than the copy has room for, then VIA filling it all
+    random_keymap(25);
+    keycode_cache_keymap_changed();
+    keycode_cache_init();
+    check_against_walk(100000);
+    random_keymap(60);
+    keycode_cache_keymap_changed();
+    check_against_walk(100000);
+    if (failures) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("keycode cache checks pass\n");
+
+    random_keymap(25);
+    keycode_cache_keymap_changed();
+    keycode_cache_init();
+    read_spins = spins_for(read_ns);
+    for (uint32_t per_layer = 4; per_layer <= 64; per_layer *= 4) {
+        printf("layer change every %u key events:\n", per_layer);
+        time_events("walk", read_keymap, events, per_layer);
+        time_events("cached", keymap_key_to_keycode, events, per_layer);
+    }
+    return 0;
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include "charybdis.h"
+
+/* keymap_introspection.h / keymap_common.h: the keymap as QMK reads it, from `keymaps` or
+ * VIA's EEPROM copy; on the host from whatever the simulator or test links in */
+uint8_t  keymap_layer_count(void);
+uint16_t keycode_at_keymap_location(uint8_t layer_num, uint8_t row, uint8_t column);
+uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key);
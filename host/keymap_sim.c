@@ -0,0 +1,824 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Keystroke simulator: replays timestamped key events through `keymap.c` and a model of
+ * QMK's tap-hold core, and reports how long each press waits for its decision and how
+ * often a dual-role key (home row mod, layer-tap thumb) resolves the wrong way.
+ *
+ *   keymap_sim [options] [script]
+ *
+ * A script has one event per line, times in ms (absolute, non-decreasing), `#` comments:
+ *
+ *   <time> down|up <key> [tap|hold]
+ *
+ * where <key> is a matrix position `row,col`, a character on the base layer (by its tap
+ * keycode) or one of `spc ent tab bspc esc del`.  The optional intent of a press is
+ * what the typist meant a dual-role key to do; misfires are counted against it.
+ *
+ * Without a script, typing is synthesized from text (`-t file`, or a built-in sample):
+ * deterministic for a seed, at a given speed, with shifted characters typed through the
+ * opposite hand's shift mod and other layers held on their layer-tap thumb.
+ *
+ *   -t file  text to type           -w wpm   typing speed (70)      -s seed  (1)
+ *   -n count type the text n times  -o file  write the script out, to edit or replay later
+ *   -p       PERMISSIVE_HOLD        -k       HOLD_ON_OTHER_KEY_PRESS
+ *   -q ms    QUICK_TAP_TERM (TAPPING_TERM)
+ *   -r count replay this many times, for the replay speed   -v  log decisions and HID events
+ *
+ * The core is modelled on QMK's `action_tapping.c` with its current defaults, which
+ * behave as the keymap's `IGNORE_MOD_TAP_INTERRUPT` asks for: a dual-role key is held once
+ * its term runs out, tapped when released before, and the keys pressed meanwhile wait in an
+ * 8-event buffer until it is decided.  Latency is from the physical press to that decision,
+ * when the key's HID event (or layer change) goes out.
+ */
+
+#include "charybdis.h"
+#include "keymap_introspection.h"
+#include "layers.h"
+#include <getopt.h>
+#include <time.h>
+
+extern const uint16_t keymaps[][MATRIX_ROWS][MATRIX_COLS];
+
+uint16_t      get_tapping_term(uint16_t keycode, keyrecord_t *record);
+bool          pre_process_record_user(uint16_t keycode, keyrecord_t *record);
+bool          process_record_user(uint16_t keycode, keyrecord_t *record);
+void          post_process_record_user(uint16_t keycode, keyrecord_t *record);
+layer_state_t layer_state_set_user(layer_state_t state);
+void          keyboard_post_init_user(void);
+void          housekeeping_task_user(void);
+
+#define LAYER_COUNT (LAYER_SYMBOLS + 1)
+#define WAITING_BUFFER_SIZE 8 // as QMK's
+
+enum {
+    INTENT_NONE,
+    INTENT_TAP,
+    INTENT_HOLD,
+};
+
+typedef struct {
+    uint64_t time_us;
+    uint8_t  row;
+    uint8_t  col;
+    bool     pressed;
+    uint8_t  intent;
+} sim_event_t;
+
+typedef struct {
+    sim_event_t *events;
+    size_t       count;
+    size_t       capacity;
+} script_t;
+
+static struct {
+    bool     permissive_hold;
+    bool     hold_on_other_key_press;
+    uint32_t quick_tap_term_ms;
+    bool     verbose;
+} options = {.quick_tap_term_ms = TAPPING_TERM};
+
+/* core state */
+
+enum {
+    KEY_UP,
+    KEY_DOWN, // not dual-role
+    KEY_TAP,
+    KEY_HOLD,
+};
+
+typedef struct {
+    uint16_t keycode; // looked up at press, so the release matches it whatever the layers did since
+    uint8_t  state;
+    uint8_t  tap_count;
+} sim_key_t;
+
+static sim_key_t keys[MATRIX_ROWS][MATRIX_COLS];
+static uint64_t  now_us; // when the core runs; behind the events while a decision is pending
+
+static struct {
+    bool        active;
+    sim_event_t press;
+    uint16_t    keycode;
+    uint64_t    deadline_us;
+    sim_event_t waiting[WAITING_BUFFER_SIZE];
+    uint8_t     waiting_count;
+} tapping;
+
+static struct {
+    bool     valid;
+    uint8_t  row;
+    uint8_t  col;
+    uint64_t release_us;
+} last_tap;
+
+/* statistics */
+
+enum {
+    LATENCY_KEY,
+    LATENCY_TAP,
+    LATENCY_HOLD,
+    LATENCY_KINDS,
+};
+
+typedef struct {
+    uint32_t *us;
+    size_t    count;
+    size_t    capacity;
+} latencies_t;
+
+static latencies_t latencies[LATENCY_KINDS];
+
+static struct {
+    uint32_t presses;
+    uint32_t dual_role;
+    uint32_t false_holds; // meant as a tap
+    uint32_t false_taps;  // meant as a hold
+    uint32_t no_intent;
+    uint32_t hid_events;
+    uint32_t dropped;
+} stats;
+
+static bool collect; // only the first of several replays is counted
+
+static void *grow(void *array, size_t *capacity, size_t size) {
+    *capacity = *capacity ? *capacity * 2 : 1024;
+    array     = realloc(array, *capacity * size);
+    if (!array) {
+        perror("realloc");
+        exit(1);
+    }
+    return array;
+}
+
+/* keycodes */
+
+static bool is_dual_role(uint16_t keycode) {
+    return IS_QK_MOD_TAP(keycode) || IS_QK_LAYER_TAP(keycode);
+}
+
+static uint8_t mods_to_8bit(uint8_t mods) {
+    return mods & 0x10 ? (mods & 0x0F) << 4 : mods & 0x0F;
+}
+
+// characters of basic keycodes KC_A..KC_SLSH, 0 where there is none to type
+static const char key_chars[][2] = {
+    {'a', 'A'}, {'b', 'B'}, {'c', 'C'}, {'d', 'D'}, {'e', 'E'}, {'f', 'F'}, {'g', 'G'}, {'h', 'H'},
+    {'i', 'I'}, {'j', 'J'}, {'k', 'K'}, {'l', 'L'}, {'m', 'M'}, {'n', 'N'}, {'o', 'O'}, {'p', 'P'},
+    {'q', 'Q'}, {'r', 'R'}, {'s', 'S'}, {'t', 'T'}, {'u', 'U'}, {'v', 'V'}, {'w', 'W'}, {'x', 'X'},
+    {'y', 'Y'}, {'z', 'Z'}, {'1', '!'}, {'2', '@'}, {'3', '#'}, {'4', '$'}, {'5', '%'}, {'6', '^'},
+    {'7', '&'}, {'8', '*'}, {'9', '('}, {'0', ')'}, {'\n', 0},  {0, 0},     {0, 0},     {'\t', 0},
+    {' ', 0},   {'-', '_'}, {'=', '+'}, {'[', '{'}, {']', '}'}, {'\\', '|'}, {0, 0},    {';', ':'},
+    {'\'', '"'}, {'`', '~'}, {',', '<'}, {'.', '>'}, {'/', '?'},
+};
+
+static const struct {
+    uint8_t     keycode;
+    const char *name;
+} key_names[] = {
+    {KC_SPC, "spc"}, {KC_ENT, "ent"}, {KC_TAB, "tab"}, {KC_BSPC, "bspc"}, {KC_ESC, "esc"}, {KC_DEL, "del"},
+};
+
+static uint8_t char_keycode(char c, bool *shift) {
+    for (uint8_t i = 0; i < ARRAY_SIZE(key_chars); i++) {
+        for (uint8_t shifted = 0; shifted < 2; shifted++) {
+            if (c && key_chars[i][shifted] == c) {
+                *shift = shifted;
+                return KC_A + i;
+            }
+        }
+    }
+    return KC_NO;
+}
+
+static const char *keycode_name(uint8_t keycode) {
+    static char name[8];
+    for (uint8_t i = 0; i < ARRAY_SIZE(key_names); i++) {
+        if (key_names[i].keycode == keycode) {
+            return key_names[i].name;
+        }
+    }
+    if (keycode >= KC_A && keycode < KC_A + ARRAY_SIZE(key_chars) && key_chars[keycode - KC_A][0] > ' ') {
+        snprintf(name, sizeof(name), "%c", key_chars[keycode - KC_A][0]);
+    } else {
+        snprintf(name, sizeof(name), "0x%02X", keycode);
+    }
+    return name;
+}
+
+// as QMK's `layer_switch_get_layer()` and `get_event_keycode()`, through `keymap_key_to_keycode()`
+static uint16_t keymap_keycode(uint8_t row, uint8_t col) {
+    const layer_state_t state = layer_state | default_layer_state;
+    const keypos_t      key   = {.col = col, .row = row};
+    for (int8_t layer = LAYER_COUNT - 1; layer >= 0; layer--) {
+        if ((state & ((layer_state_t)1 << layer)) && keymap_key_to_keycode(layer, key) != KC_TRNS) {
+            return keymap_key_to_keycode(layer, key);
+        }
+    }
+    return keymap_key_to_keycode(get_highest_layer(default_layer_state), key);
+}
+
+/** Position of `keycode` on `layer`, also as the tap keycode of a dual-role key with `tap`. */
+static bool keymap_find(uint8_t layer, uint16_t keycode, bool tap, keypos_t *key) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            const uint16_t found = pgm_read_word(&keymaps[layer][row][col]);
+            if (found == keycode || (tap && is_dual_role(found) && QK_MODS_GET_BASIC_KEYCODE(found) == keycode)) {
+                *key = (keypos_t){.row = row, .col = col};
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/* the core, after `process_record_user()` let a keycode through */
+
+static void hid_key(uint8_t keycode, bool pressed) {
+    if (collect) {
+        stats.hid_events++;
+    }
+    if (options.verbose) {
+        printf("%10.3f  %c%s\n", now_us / 1000.0, pressed ? '+' : '-', keycode_name(keycode));
+    }
+}
+
+static void hid_mods(uint8_t mods, bool pressed) {
+    set_mods(pressed ? get_mods() | mods : get_mods() & ~mods);
+    if (collect) {
+        stats.hid_events++;
+    }
+    if (options.verbose) {
+        printf("%10.3f  mods 0x%02X\n", now_us / 1000.0, get_mods());
+    }
+}
+
+static void layer_update(layer_state_t state) {
+    layer_state = layer_state_set_user(state);
+}
+
+static void action_exec(uint16_t keycode, bool pressed, bool hold) {
+    if (is_dual_role(keycode) && hold) {
+        if (IS_QK_MOD_TAP(keycode)) {
+            hid_mods(mods_to_8bit(QK_MODS_GET_MODS(keycode)), pressed);
+        } else {
+            const layer_state_t layer = (layer_state_t)1 << QK_LAYER_TAP_GET_LAYER(keycode);
+            layer_update(pressed ? layer_state | layer : layer_state & ~layer);
+        }
+    } else if (is_dual_role(keycode)) {
+        hid_key(QK_MODS_GET_BASIC_KEYCODE(keycode), pressed);
+    } else if (IS_QK_MODS(keycode)) {
+        hid_mods(mods_to_8bit(QK_MODS_GET_MODS(keycode)), pressed);
+        hid_key(QK_MODS_GET_BASIC_KEYCODE(keycode), pressed);
+    } else if (IS_QK_TOGGLE_LAYER(keycode)) {
+        if (pressed) {
+            layer_update(layer_state ^ ((layer_state_t)1 << (keycode & 0x1F)));
+        }
+    } else if (keycode == CW_TOGG) {
+        if (pressed) {
+            host_caps_word = !host_caps_word;
+        }
+    } else if (keycode >= KC_LCTL && keycode <= KC_RGUI) {
+        hid_mods(MOD_BIT(keycode) << (keycode >= KC_RCTL ? 4 : 0), pressed);
+    } else if (keycode > KC_TRNS && keycode <= 0xFF) {
+        hid_key(keycode, pressed);
+    }
+}
+
+static void process_key(uint8_t row, uint8_t col, bool pressed) {
+    const sim_key_t *key    = &keys[row][col];
+    keyrecord_t      record = {
+        .event = {.key = {.col = col, .row = row}, .pressed = pressed, .time = (uint16_t)(now_us / 1000)},
+        .tap   = {.count = key->tap_count},
+    };
+    host_time_ms = now_us / 1000;
+    if (process_record_user(key->keycode, &record)) {
+        action_exec(key->keycode, pressed, key->state == KEY_HOLD);
+    }
+    post_process_record_user(key->keycode, &record);
+}
+
+static void latency_add(uint8_t kind, uint32_t us) {
+    latencies_t *list = &latencies[kind];
+    if (list->count == list->capacity) {
+        list->us = grow(list->us, &list->capacity, sizeof(*list->us));
+    }
+    list->us[list->count++] = us;
+}
+
+static void key_decided(const sim_event_t *event, uint16_t keycode, uint8_t state, uint8_t tap_count) {
+    sim_key_t *key = &keys[event->row][event->col];
+    key->keycode   = keycode;
+    key->state     = state;
+    key->tap_count = tap_count;
+    if (collect) {
+        stats.presses++;
+        latency_add(state == KEY_DOWN ? LATENCY_KEY : state == KEY_TAP ? LATENCY_TAP : LATENCY_HOLD, now_us - event->time_us);
+        if (state != KEY_DOWN) {
+            stats.dual_role++;
+            if (event->intent == INTENT_NONE) {
+                stats.no_intent++;
+            } else if (event->intent == INTENT_TAP && state == KEY_HOLD) {
+                stats.false_holds++;
+            } else if (event->intent == INTENT_HOLD && state == KEY_TAP) {
+                stats.false_taps++;
+            }
+        }
+    }
+    if (options.verbose && state != KEY_DOWN) {
+        printf("%10.3f  %u,%u %s after %.3f ms%s\n", now_us / 1000.0, event->row, event->col, state == KEY_TAP ? "tap" : "hold", (now_us - event->time_us) / 1000.0, (event->intent == INTENT_TAP && state == KEY_HOLD) || (event->intent == INTENT_HOLD && state == KEY_TAP) ? "  MISFIRE" : "");
+    }
+    process_key(event->row, event->col, true);
+}
+
+static void key_down(const sim_event_t *event) {
+    const uint16_t keycode = keymap_keycode(event->row, event->col);
+    // a dual-role key pressed again right after its tap repeats the tap, instead of holding
+    const bool quick_tap = last_tap.valid && last_tap.row == event->row && last_tap.col == event->col && event->time_us - last_tap.release_us < options.quick_tap_term_ms * 1000ull;
+    last_tap.valid       = false;
+    if (!is_dual_role(keycode)) {
+        key_decided(event, keycode, KEY_DOWN, 0);
+    } else if (quick_tap) {
+        key_decided(event, keycode, KEY_TAP, 2);
+    } else {
+        keyrecord_t record = {.event = {.key = {.col = event->col, .row = event->row}, .pressed = true, .time = (uint16_t)(event->time_us / 1000)}};
+        tapping.active      = true;
+        tapping.press       = *event;
+        tapping.keycode     = keycode;
+        tapping.deadline_us = event->time_us + get_tapping_term(keycode, &record) * 1000ull;
+    }
+}
+
+static void key_up(const sim_event_t *event) {
+    sim_key_t *key = &keys[event->row][event->col];
+    if (key->state == KEY_UP) {
+        return; // its press was dropped
+    }
+    if (key->state == KEY_TAP) {
+        last_tap.valid      = true;
+        last_tap.row        = event->row;
+        last_tap.col        = event->col;
+        last_tap.release_us = event->time_us;
+    }
+    process_key(event->row, event->col, false);
+    key->state = KEY_UP;
+}
+
+static void event_handle(const sim_event_t *event);
+
+static void tapping_resolve(bool hold) {
+    sim_event_t   waiting[WAITING_BUFFER_SIZE];
+    const uint8_t waiting_count = tapping.waiting_count;
+    memcpy(waiting, tapping.waiting, sizeof(waiting));
+    tapping.active        = false;
+    tapping.waiting_count = 0;
+    key_decided(&tapping.press, tapping.keycode, hold ? KEY_HOLD : KEY_TAP, hold ? 0 : 1);
+    for (uint8_t i = 0; i < waiting_count; i++) {
+        event_handle(&waiting[i]);
+    }
+}
+
+static void tapping_expire(uint64_t time_us) {
+    while (tapping.active && tapping.deadline_us <= time_us) {
+        if (now_us < tapping.deadline_us) {
+            now_us = tapping.deadline_us;
+        }
+        tapping_resolve(true);
+    }
+}
+
+static void event_handle(const sim_event_t *event) {
+    tapping_expire(event->time_us);
+    if (now_us < event->time_us) {
+        now_us = event->time_us;
+    }
+    if (!tapping.active) {
+        if (event->pressed) {
+            key_down(event);
+        } else {
+            key_up(event);
+        }
+        return;
+    }
+    if (!event->pressed && event->row == tapping.press.row && event->col == tapping.press.col) {
+        // released within its term: a tap, then what waited on it, then this release
+        tapping_resolve(false);
+        event_handle(event);
+        return;
+    }
+    if (tapping.waiting_count == WAITING_BUFFER_SIZE) {
+        if (collect) {
+            stats.dropped++;
+        }
+        return;
+    }
+    tapping.waiting[tapping.waiting_count++] = *event;
+    if (event->pressed && options.hold_on_other_key_press) {
+        tapping_resolve(true);
+    } else if (!event->pressed && options.permissive_hold) {
+        // a key pressed and released within the term of the one held around it
+        for (uint8_t i = 0; i < tapping.waiting_count - 1; i++) {
+            if (tapping.waiting[i].pressed && tapping.waiting[i].row == event->row && tapping.waiting[i].col == event->col) {
+                tapping_resolve(true);
+                break;
+            }
+        }
+    }
+}
+
+static void sim_run(const script_t *script) {
+    memset(keys, 0, sizeof(keys));
+    memset(&tapping, 0, sizeof(tapping));
+    memset(&last_tap, 0, sizeof(last_tap));
+    now_us              = 0;
+    host_time_ms        = 0;
+    host_caps_word      = false;
+    default_layer_state = 1;
+    set_mods(0);
+    keyboard_post_init_user();
+    layer_update(0);
+    for (size_t i = 0; i < script->count; i++) {
+        const sim_event_t *event = &script->events[i];
+        // as QMK's `action_exec()`, before the tap-hold core, which has timed out what it could
+        tapping_expire(event->time_us);
+        keyrecord_t record = {.event = {.key = {.col = event->col, .row = event->row}, .pressed = event->pressed, .time = (uint16_t)(event->time_us / 1000)}};
+        if (pre_process_record_user(keymap_keycode(event->row, event->col), &record)) {
+            event_handle(event);
+        }
+        housekeeping_task_user();
+    }
+    tapping_expire(UINT64_MAX);
+}
+
+/* scripts */
+
+static void script_add(script_t *script, uint64_t time_us, keypos_t key, bool pressed, uint8_t intent) {
+    if (script->count == script->capacity) {
+        script->events = grow(script->events, &script->capacity, sizeof(*script->events));
+    }
+    script->events[script->count++] = (sim_event_t){.time_us = time_us, .row = key.row, .col = key.col, .pressed = pressed, .intent = intent};
+}
+
+static bool parse_key(const char *name, keypos_t *key) {
+    unsigned row, col;
+    char     end;
+    if (sscanf(name, "%u,%u%c", &row, &col, &end) == 2) {
+        *key = (keypos_t){.row = row, .col = col};
+        return row < MATRIX_ROWS && col < MATRIX_COLS;
+    }
+    for (uint8_t i = 0; i < ARRAY_SIZE(key_names); i++) {
+        if (strcmp(name, key_names[i].name) == 0) {
+            return keymap_find(LAYER_BASE, key_names[i].keycode, true, key);
+        }
+    }
+    bool          shift;
+    const uint8_t keycode = strlen(name) == 1 ? char_keycode(name[0], &shift) : KC_NO;
+    return keycode != KC_NO && !shift && keymap_find(LAYER_BASE, keycode, true, key);
+}
+
+static void script_read(script_t *script, const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        exit(1);
+    }
+    char     line[256];
+    unsigned number = 0;
+    while (fgets(line, sizeof(line), file)) {
+        number++;
+        char *comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        double   time_ms;
+        char     action[8], name[16], intent[8] = "";
+        keypos_t key;
+        int      fields = sscanf(line, "%lf %7s %15s %7s", &time_ms, action, name, intent);
+        if (fields <= 0) {
+            continue;
+        }
+        const uint64_t time_us = time_ms * 1000 + 0.5;
+        if (fields < 3 || time_ms < 0 || (strcmp(action, "down") && strcmp(action, "up")) || !parse_key(name, &key) || (*intent && strcmp(intent, "tap") && strcmp(intent, "hold"))) {
+            fprintf(stderr, "%s:%u: expected <time> down|up <key> [tap|hold]\n", path, number);
+            exit(1);
+        }
+        if (script->count && time_us < script->events[script->count - 1].time_us) {
+            fprintf(stderr, "%s:%u: time goes backwards\n", path, number);
+            exit(1);
+        }
+        script_add(script, time_us, key, action[0] == 'd', *intent == 't' ? INTENT_TAP : *intent == 'h' ? INTENT_HOLD : INTENT_NONE);
+    }
+    fclose(file);
+}
+
+static void script_write(const script_t *script, const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        perror(path);
+        exit(1);
+    }
+    fprintf(file, "# time_ms down|up row,col intent\n");
+    for (size_t i = 0; i < script->count; i++) {
+        const sim_event_t *event = &script->events[i];
+        fprintf(file, "%.3f %s %u,%u%s\n", event->time_us / 1000.0, event->pressed ? "down" : "up", event->row, event->col, event->intent == INTENT_TAP ? " tap" : event->intent == INTENT_HOLD ? " hold" : "");
+    }
+    fclose(file);
+}
+
+/* synthesized typing */
+
+static const char sample_text[] =
+    "The quick brown fox jumps over the lazy dog; then it naps. Pack my box with five dozen liquor jugs!\n"
+    "Sphinx of black quartz, judge my vow. How vexingly quick daft zebras jump (said Ms. Brown).\n"
+    "In 2024 we typed 38 of 50 drafts on home row mods, at 75 words a minute, with \"few\" misfires.\n"
+    "Write code that reads well: short names, small functions, and tests for the hard parts.\n";
+
+/** How a character is typed: its key, and the shift or layer key held around it. */
+typedef struct {
+    bool     valid;
+    keypos_t key;
+    bool     has_modifier;
+    keypos_t modifier;
+} char_plan_t;
+
+static char_plan_t char_plans[128];
+
+static void char_plans_init(void) {
+    keypos_t shifts[2];
+    bool     has_shift[2] = {false, false};
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            const uint16_t keycode = pgm_read_word(&keymaps[LAYER_BASE][row][col]);
+            if (IS_QK_MOD_TAP(keycode) && (QK_MODS_GET_MODS(keycode) & 0x0F) == MOD_LSFT) {
+                const uint8_t hand = row >= MATRIX_ROWS / 2;
+                shifts[hand]       = (keypos_t){.row = row, .col = col};
+                has_shift[hand]    = true;
+            }
+        }
+    }
+    for (uint8_t c = 1; c < ARRAY_SIZE(char_plans); c++) {
+        char_plan_t  *plan = &char_plans[c];
+        bool          shift;
+        const uint8_t keycode = char_keycode(c, &shift);
+        if (keycode == KC_NO) {
+            continue;
+        }
+        const uint16_t exact = shift ? LSFT(keycode) : keycode;
+        if (keymap_find(LAYER_BASE, exact, true, &plan->key)) {
+            plan->valid = true;
+            continue;
+        }
+        if (shift && keymap_find(LAYER_BASE, keycode, true, &plan->key)) {
+            const uint8_t other = plan->key.row < MATRIX_ROWS / 2;
+            if (has_shift[other] || has_shift[!other]) {
+                plan->valid        = true;
+                plan->has_modifier = true;
+                plan->modifier     = has_shift[other] ? shifts[other] : shifts[!other];
+            }
+            continue;
+        }
+        for (uint8_t layer = LAYER_BASE + 1; layer < LAYER_COUNT && !plan->valid; layer++) {
+            for (uint8_t row = 0; row < MATRIX_ROWS && !plan->valid; row++) {
+                for (uint8_t col = 0; col < MATRIX_COLS && !plan->valid; col++) {
+                    const uint16_t layer_key = pgm_read_word(&keymaps[LAYER_BASE][row][col]);
+                    if (IS_QK_LAYER_TAP(layer_key) && QK_LAYER_TAP_GET_LAYER(layer_key) == layer && keymap_find(layer, exact, false, &plan->key) && (plan->key.row != row || plan->key.col != col)) {
+                        plan->valid        = true;
+                        plan->has_modifier = true;
+                        plan->modifier     = (keypos_t){.row = row, .col = col};
+                    }
+                }
+            }
+        }
+    }
+}
+
+static uint32_t rng_state;
+
+static uint32_t rng_next(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static uint64_t rng_range_us(uint32_t min_ms, uint32_t max_ms) {
+    return min_ms * 1000ull + rng_next() % ((max_ms - min_ms) * 1000 + 1);
+}
+
+static int event_compare(const void *a, const void *b) {
+    const sim_event_t *x = a, *y = b;
+    return x->time_us < y->time_us ? -1 : x->time_us > y->time_us;
+}
+
+/** Typing of `text`: presses `60000 / (wpm * 5)` ms apart with +-40% jitter, each held
+ *  60-120 ms, so fast typing rolls over; a run of characters needing the same shift or
+ *  layer key has it pressed 50-90 ms before and released 30-70 ms after. */
+static uint32_t script_synthesize(script_t *script, const char *text, uint32_t wpm, uint32_t seed) {
+    uint64_t free_us[MATRIX_ROWS][MATRIX_COLS] = {{0}};
+    uint64_t time_us                           = 0;
+    uint32_t unmapped                          = 0;
+    const uint32_t interval_us                 = 60000000ull / (wpm * 5);
+    rng_state                                  = seed ? seed : 1;
+    for (const char *c = text; *c;) {
+        const char_plan_t *plan = (unsigned char)*c < ARRAY_SIZE(char_plans) ? &char_plans[(unsigned char)*c] : NULL;
+        if (!plan || !plan->valid) {
+            unmapped += *c != '\r';
+            c++;
+            continue;
+        }
+        uint64_t modifier_down = 0;
+        if (plan->has_modifier) {
+            const keypos_t m = plan->modifier;
+            modifier_down    = time_us > free_us[m.row][m.col] ? time_us : free_us[m.row][m.col];
+            script_add(script, modifier_down, m, true, INTENT_HOLD);
+            time_us = modifier_down + rng_range_us(50, 90);
+        }
+        uint64_t           last_up = 0;
+        const char_plan_t *next    = plan;
+        do {
+            const keypos_t k    = next->key;
+            const uint64_t down = time_us > free_us[k.row][k.col] ? time_us : free_us[k.row][k.col];
+            last_up             = down + rng_range_us(60, 120);
+            script_add(script, down, k, true, INTENT_TAP);
+            script_add(script, last_up, k, false, INTENT_NONE);
+            free_us[k.row][k.col] = last_up + 20000;
+            time_us               = down + interval_us * 6 / 10 + rng_next() % (interval_us * 8 / 10 + 1);
+            c++;
+            next = (unsigned char)*c < ARRAY_SIZE(char_plans) ? &char_plans[(unsigned char)*c] : NULL;
+        } while (plan->has_modifier && next && next->valid && next->has_modifier && next->modifier.row == plan->modifier.row && next->modifier.col == plan->modifier.col);
+        if (plan->has_modifier) {
+            const keypos_t m = plan->modifier;
+            const uint64_t up = last_up + rng_range_us(30, 70);
+            script_add(script, up, m, false, INTENT_NONE);
+            free_us[m.row][m.col] = up + 20000;
+        }
+    }
+    // events of overlapping keys were appended out of order; an insertion sort keeps ties in order
+    for (size_t i = 1; i < script->count; i++) {
+        const sim_event_t event = script->events[i];
+        size_t            j     = i;
+        while (j > 0 && event_compare(&script->events[j - 1], &event) > 0) {
+            script->events[j] = script->events[j - 1];
+            j--;
+        }
+        script->events[j] = event;
+    }
+    return unmapped;
+}
+
+static char *text_read(const char *path, uint32_t repeat) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        exit(1);
+    }
+    fseek(file, 0, SEEK_END);
+    const long length = ftell(file);
+    rewind(file);
+    char *text = malloc(length * repeat + 1);
+    if (!text || fread(text, 1, length, file) != (size_t)length) {
+        fprintf(stderr, "%s: read failed\n", path);
+        exit(1);
+    }
+    fclose(file);
+    for (uint32_t i = 1; i < repeat; i++) {
+        memcpy(text + length * i, text, length);
+    }
+    text[length * repeat] = '\0';
+    return text;
+}
+
+/* report */
+
+static int u32_compare(const void *a, const void *b) {
+    const uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void latency_print(const char *label, latencies_t *list) {
+    if (!list->count) {
+        printf("  %-10s %8u\n", label, 0);
+        return;
+    }
+    qsort(list->us, list->count, sizeof(*list->us), u32_compare);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < list->count; i++) {
+        sum += list->us[i];
+    }
+    // nearest rank
+#define PERCENTILE(p) (list->us[(list->count * (p) + 99) / 100 - 1] / 1000.0)
+    printf("  %-10s %8zu %8.1f %8.1f %8.1f %8.1f %8.1f\n", label, list->count, sum / 1000.0 / list->count, PERCENTILE(50), PERCENTILE(95), PERCENTILE(99), PERCENTILE(100));
+#undef PERCENTILE
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-pkv] [-q ms] [-t text] [-w wpm] [-s seed] [-n count] [-o script] [-r count] [script]\n", name);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    const char *text_path = NULL, *out_path = NULL;
+    uint32_t    wpm = 70, seed = 1, text_repeat = 1, replays = 1;
+    int         opt;
+    while ((opt = getopt(argc, argv, "pkq:t:w:s:n:o:r:v")) != -1) {
+        switch (opt) {
+            case 'p':
+                options.permissive_hold = true;
+                break;
+            case 'k':
+                options.hold_on_other_key_press = true;
+                break;
+            case 'q':
+                options.quick_tap_term_ms = strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                text_path = optarg;
+                break;
+            case 'w':
+                wpm = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                seed = strtoul(optarg, NULL, 0);
+                break;
+            case 'n':
+                text_repeat = strtoul(optarg, NULL, 0);
+                break;
+            case 'o':
+                out_path = optarg;
+                break;
+            case 'r':
+                replays = strtoul(optarg, NULL, 0);
+                break;
+            case 'v':
+                options.verbose = true;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (optind + 1 < argc || !wpm || !text_repeat || !replays || (optind < argc && text_path)) {
+        usage(argv[0]);
+    }
+
+    script_t script = {0};
+    if (optind < argc) {
+        script_read(&script, argv[optind]);
+        printf("script %s: %zu events\n", argv[optind], script.count);
+    } else {
+        char_plans_init();
+        char *text = NULL;
+        if (text_path) {
+            text = text_read(text_path, text_repeat);
+        } else {
+            text = malloc(sizeof(sample_text) * text_repeat);
+            for (uint32_t i = 0; i < text_repeat; i++) {
+                memcpy(text + (sizeof(sample_text) - 1) * i, sample_text, sizeof(sample_text));
+            }
+        }
+        const uint32_t unmapped = script_synthesize(&script, text, wpm, seed);
+        printf("typing %s at %u wpm, seed %u: %zu events, %u characters not on the keymap\n", text_path ? text_path : "sample text", wpm, seed, script.count, unmapped);
+        free(text);
+    }
+    if (out_path) {
+        script_write(&script, out_path);
+    }
+    printf("core: tapping term %u ms (per key), quick tap %u ms%s%s\n", TAPPING_TERM, options.quick_tap_term_ms, options.permissive_hold ? ", permissive hold" : "", options.hold_on_other_key_press ? ", hold on other key press" : "");
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < replays; i++) {
+        collect = i == 0;
+        sim_run(&script);
+        options.verbose = false;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    const double elapsed_s = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("\nlatency ms      count     mean      p50      p95      p99      max\n");
+    latency_print("key", &latencies[LATENCY_KEY]);
+    latency_print("dual tap", &latencies[LATENCY_TAP]);
+    latency_print("dual hold", &latencies[LATENCY_HOLD]);
+    const uint32_t misfires = stats.false_holds + stats.false_taps;
+    const uint32_t judged   = stats.dual_role - stats.no_intent;
+    printf("\nmisfires: %u of %u dual-role presses with an intent (%.2f%%): %u held instead of tapped, %u tapped instead of held\n", misfires, judged, judged ? 100.0 * misfires / judged : 0.0, stats.false_holds, stats.false_taps);
+    printf("presses %u, HID events %u, keymap reads %.2f per event", stats.presses, stats.hid_events, script.count ? (double)host_keymap_reads / replays / script.count : 0.0);
+    if (stats.dropped) {
+        printf(", %u events dropped (waiting buffer full)", stats.dropped);
+    }
+    const double simulated_s = script.count ? script.events[script.count - 1].time_us / 1e6 : 0;
+    printf("\nreplay: %u x %zu events in %.3f s, %.2f M events/s, %.0fx real time\n", replays, script.count, elapsed_s, replays * script.count / elapsed_s / 1e6, elapsed_s > 0 ? replays * simulated_s / elapsed_s : 0);
+    return 0;
+}
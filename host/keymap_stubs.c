@@ -0,0 +1,164 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* The QMK globals and APIs `keymap.c` calls, for `keymap_sim`: a single, unconnected master
+ * half, and a maccel that takes no part in typing.
+ */
+
+#include "charybdis.h"
+#include "keymap_introspection.h"
+#include "layers.h"
+#include "transactions.h"
+#include "maccel/maccel.h"
+
+uint32_t host_time_ms;
+bool     host_caps_word;
+uint64_t host_keymap_reads;
+
+layer_state_t layer_state;
+layer_state_t default_layer_state = 1;
+
+extern const uint16_t keymaps[][MATRIX_ROWS][MATRIX_COLS];
+
+uint8_t keymap_layer_count(void) {
+    return LAYER_SYMBOLS + 1;
+}
+
+uint16_t keycode_at_keymap_location(uint8_t layer_num, uint8_t row, uint8_t column) {
+    host_keymap_reads++;
+    return layer_num < keymap_layer_count() ? pgm_read_word(&keymaps[layer_num][row][column]) : KC_TRNS;
+}
+
+// QMK's, unless `keycode_cache.c` is linked in
+__attribute__((weak)) uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key) {
+    return key.row < MATRIX_ROWS && key.col < MATRIX_COLS ? keycode_at_keymap_location(layer, key.row, key.col) : KC_NO;
+}
+
+bool debug_enable;
+bool debug_matrix;
+bool debug_keyboard;
+
+layer_state_t layer_state_set_user(layer_state_t state);
+
+void layer_on(uint8_t layer) {
+    layer_state = layer_state_set_user(layer_state | (layer_state_t)1 << layer);
+}
+
+void layer_off(uint8_t layer) {
+    layer_state = layer_state_set_user(layer_state & ~((layer_state_t)1 << layer));
+}
+
+bool layer_state_is(uint8_t layer) {
+    return layer_state & (layer_state_t)1 << layer;
+}
+
+static uint8_t host_mods;
+
+uint8_t get_mods(void) {
+    return host_mods;
+}
+
+void set_mods(uint8_t mods) {
+    host_mods = mods;
+}
+
+void add_weak_mods(uint8_t mods) {}
+
+led_t host_keyboard_led_state(void) {
+    return (led_t){0};
+}
+
+bool is_caps_word_on(void) {
+    return host_caps_word;
+}
+
+bool is_keyboard_master(void) {
+    return true;
+}
+
+bool charybdis_get_pointer_sniping_enabled(void) {
+    return false;
+}
+
+uint32_t timer_read32(void) {
+    return host_time_ms;
+}
+
+uint32_t timer_elapsed32(uint32_t last) {
+    return host_time_ms - last;
+}
+
+void transaction_register_rpc(int8_t transaction_id, slave_callback_t callback) {}
+
+bool transaction_rpc_send(int8_t transaction_id, uint8_t initiator2target_buffer_size, const void *initiator2target_buffer) {
+    return false;
+}
+
+bool is_transport_connected(void) {
+    return false;
+}
+
+/* maccel */
+static uint8_t maccel_profile;
+static uint8_t maccel_override = MACCEL_PROFILE_NONE;
+
+report_mouse_t pointing_device_task_maccel(report_mouse_t mouse_report) {
+    return mouse_report;
+}
+
+bool process_record_maccel(uint16_t keycode, keyrecord_t *record, uint16_t takeoff, uint16_t growth_rate, uint16_t offset, uint16_t limit) {
+    return keycode != takeoff && keycode != growth_rate && keycode != offset && keycode != limit;
+}
+
+void maccel_profile_select(uint8_t profile) {
+    maccel_profile = profile;
+}
+
+void maccel_profile_override(uint8_t profile) {
+    maccel_override = profile;
+}
+
+uint8_t maccel_profile_get(void) {
+    return maccel_override != MACCEL_PROFILE_NONE ? maccel_override : maccel_profile;
+}
+
+uint8_t maccel_profile_get_override(void) {
+    return maccel_override;
+}
+
+bool maccel_get_enabled(void) {
+    return true;
+}
+
+void maccel_cpi_changed(void) {}
+void keyboard_post_init_maccel(void) {}
+void housekeeping_task_maccel(void) {}
+
+#ifdef MACCEL_USE_DRAGSCROLL
+static bool maccel_dragscroll;
+
+void maccel_dragscroll_enable(bool enable) {
+    maccel_dragscroll = enable;
+}
+
+bool maccel_dragscroll_is_enabled(void) {
+    return maccel_dragscroll;
+}
+
+void maccel_dragscroll_toggle(void) {
+    maccel_dragscroll = !maccel_dragscroll;
+}
+#endif // MACCEL_USE_DRAGSCROLL
@@ -0,0 +1,259 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks of `lock_chords.c`, then what it adds to each key event.
+ *
+ * Events are fed the way QMK's core delivers them: every physical press and release to
+ * `pre_process_record_user()`, and those it lets through, once the tap-hold core has
+ * decided, to `process_record_user()` with their tap count.  The chord table is a small
+ * one of its own, two thumbs sharing one partner and a third with a partner of its own.
+ */
+
+#include <getopt.h>
+#include <time.h>
+#include "charybdis.h"
+#include "lock_chords.h"
+
+enum {
+    LAYER_BASE,
+    LAYER_NAV,
+    LAYER_SYM,
+    LAYER_NUM,
+};
+
+enum {
+    THUMB_NAV   = 1 << 0,
+    THUMB_SYM   = 1 << 1,
+    PARTNER     = 1 << 2,
+    THUMB_NUM   = 1 << 3,
+    NUM_PARTNER = 1 << 4,
+};
+
+#define NAV_ROW 3
+#define NAV_COL 4
+#define SYM_ROW 7
+#define SYM_COL 3
+#define PARTNER_ROW 6
+#define PARTNER_COL 0
+#define NUM_ROW 7
+#define NUM_COL 4
+#define NUM_PARTNER_ROW 1
+#define NUM_PARTNER_COL 0
+#define KEY_ROW 1
+#define KEY_COL 1
+
+#define SPC_NAV LT(LAYER_NAV, KC_SPC)
+#define ENT_SYM LT(LAYER_SYM, KC_ENT)
+#define BSP_NUM LT(LAYER_NUM, KC_BSPC)
+
+const uint8_t PROGMEM lock_chord_members[MATRIX_ROWS][MATRIX_COLS] = {
+    [NAV_ROW][NAV_COL]                 = THUMB_NAV,
+    [SYM_ROW][SYM_COL]                 = THUMB_SYM,
+    [PARTNER_ROW][PARTNER_COL]         = PARTNER,
+    [NUM_ROW][NUM_COL]                 = THUMB_NUM,
+    [NUM_PARTNER_ROW][NUM_PARTNER_COL] = NUM_PARTNER,
+};
+
+const uint8_t PROGMEM lock_chord_layers[1 << LOCK_CHORD_KEYS] = {
+    [THUMB_NAV | PARTNER]     = LOCK_CHORD_LAYER(LAYER_NAV),
+    [THUMB_SYM | PARTNER]     = LOCK_CHORD_LAYER(LAYER_SYM),
+    [THUMB_NUM | NUM_PARTNER] = LOCK_CHORD_LAYER(LAYER_NUM),
+};
+
+const uint8_t lock_chord_partners = PARTNER | NUM_PARTNER;
+
+layer_state_t layer_state;
+layer_state_t default_layer_state = 1;
+
+void layer_on(uint8_t layer) {
+    layer_state |= (layer_state_t)1 << layer;
+}
+
+void layer_off(uint8_t layer) {
+    layer_state &= ~((layer_state_t)1 << layer);
+}
+
+bool layer_state_is(uint8_t layer) {
+    return layer_state & (layer_state_t)1 << layer;
+}
+
+static int failures;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+static keyrecord_t record(uint8_t row, uint8_t col, bool pressed, uint8_t tap_count) {
+    return (keyrecord_t){.event = {.key = {.col = col, .row = row}, .pressed = pressed}, .tap = {.count = tap_count}};
+}
+
+// a physical event, true if the core gets it
+static bool physical(uint8_t row, uint8_t col, bool pressed) {
+    keyrecord_t event = record(row, col, pressed, 0);
+    return lock_chords_pre_process(&event);
+}
+
+// what the core made of a dual-role key, true if the action goes ahead; a hold runs it here
+static bool decided(uint8_t row, uint8_t col, uint16_t keycode, bool pressed, bool tap) {
+    keyrecord_t event = record(row, col, pressed, tap);
+    if (!lock_chords_process(keycode, &event)) {
+        return false;
+    }
+    if (!tap) {
+        (pressed ? layer_on : layer_off)(QK_LAYER_TAP_GET_LAYER(keycode));
+    }
+    return true;
+}
+
+static void check_tapped_thumb(void) {
+    // thumb down, partner tapped, thumb up before its term: a tap the chord eats
+    CHECK(physical(NAV_ROW, NAV_COL, true));
+    CHECK(!physical(PARTNER_ROW, PARTNER_COL, true));
+    CHECK(layer_state_is(LAYER_NAV) && lock_chords_is_locked(LAYER_NAV));
+    CHECK(!physical(PARTNER_ROW, PARTNER_COL, false));
+    CHECK(physical(NAV_ROW, NAV_COL, false));
+    CHECK(!decided(NAV_ROW, NAV_COL, SPC_NAV, true, true));
+    CHECK(!decided(NAV_ROW, NAV_COL, SPC_NAV, false, true));
+    CHECK(layer_state_is(LAYER_NAV));
+
+    // the thumb alone taps as usual, locked or not
+    CHECK(physical(NAV_ROW, NAV_COL, true) && physical(NAV_ROW, NAV_COL, false));
+    CHECK(decided(NAV_ROW, NAV_COL, SPC_NAV, true, true) && decided(NAV_ROW, NAV_COL, SPC_NAV, false, true));
+
+    // and the same chord unlocks
+    CHECK(physical(NAV_ROW, NAV_COL, true));
+    CHECK(!physical(PARTNER_ROW, PARTNER_COL, true));
+    CHECK(!layer_state_is(LAYER_NAV) && !lock_chords_is_locked(LAYER_NAV));
+    CHECK(!physical(PARTNER_ROW, PARTNER_COL, false));
+    CHECK(physical(NAV_ROW, NAV_COL, false));
+    CHECK(!decided(NAV_ROW, NAV_COL, SPC_NAV, true, true) && !decided(NAV_ROW, NAV_COL, SPC_NAV, false, true));
+}
+
+static void check_held_thumb(void) {
+    // the thumb held past its term, then the partner: its release leaves the layer on
+    CHECK(physical(SYM_ROW, SYM_COL, true));
+    CHECK(decided(SYM_ROW, SYM_COL, ENT_SYM, true, false) && layer_state_is(LAYER_SYM));
+    CHECK(!physical(PARTNER_ROW, PARTNER_COL, true) && !physical(PARTNER_ROW, PARTNER_COL, false));
+    CHECK(physical(SYM_ROW, SYM_COL, false));
+    CHECK(!decided(SYM_ROW, SYM_COL, ENT_SYM, false, false));
+    CHECK(layer_state_is(LAYER_SYM) && lock_chords_is_locked(LAYER_SYM));
+
+    // a later hold of the same thumb does not unlock either
+    CHECK(physical(SYM_ROW, SYM_COL, true) && decided(SYM_ROW, SYM_COL, ENT_SYM, true, false));
+    CHECK(physical(SYM_ROW, SYM_COL, false) && !decided(SYM_ROW, SYM_COL, ENT_SYM, false, false));
+    CHECK(layer_state_is(LAYER_SYM));
+
+    // turned off some other way, it is unlocked, and the chord locks it again
+    layer_off(LAYER_SYM);
+    CHECK(!lock_chords_is_locked(LAYER_SYM));
+    CHECK(physical(SYM_ROW, SYM_COL, true) && !physical(PARTNER_ROW, PARTNER_COL, true));
+    CHECK(lock_chords_is_locked(LAYER_SYM));
+    CHECK(!physical(PARTNER_ROW, PARTNER_COL, false) && physical(SYM_ROW, SYM_COL, false));
+    CHECK(!decided(SYM_ROW, SYM_COL, ENT_SYM, true, true) && !decided(SYM_ROW, SYM_COL, ENT_SYM, false, true));
+    layer_off(LAYER_SYM);
+}
+
+static void check_own_partner(void) {
+    // another thumb's partner is a key of the layer held, as the numeral layer's Backspace
+    CHECK(physical(NUM_ROW, NUM_COL, true) && decided(NUM_ROW, NUM_COL, BSP_NUM, true, false));
+    CHECK(physical(PARTNER_ROW, PARTNER_COL, true) && physical(PARTNER_ROW, PARTNER_COL, false));
+    CHECK(physical(PARTNER_ROW, PARTNER_COL, true) && physical(PARTNER_ROW, PARTNER_COL, false));
+    CHECK(layer_state_is(LAYER_NUM) && !lock_chords_is_locked(LAYER_NUM));
+
+    // its own partner locks it, and the release leaves it on
+    CHECK(!physical(NUM_PARTNER_ROW, NUM_PARTNER_COL, true) && !physical(NUM_PARTNER_ROW, NUM_PARTNER_COL, false));
+    CHECK(physical(NUM_ROW, NUM_COL, false) && !decided(NUM_ROW, NUM_COL, BSP_NUM, false, false));
+    CHECK(layer_state_is(LAYER_NUM) && lock_chords_is_locked(LAYER_NUM));
+
+    // the other partner still a key while locked, and its own chord unlocks
+    CHECK(physical(NUM_ROW, NUM_COL, true) && physical(PARTNER_ROW, PARTNER_COL, true) && physical(PARTNER_ROW, PARTNER_COL, false));
+    CHECK(!physical(NUM_PARTNER_ROW, NUM_PARTNER_COL, true) && !physical(NUM_PARTNER_ROW, NUM_PARTNER_COL, false));
+    CHECK(!layer_state_is(LAYER_NUM) && !lock_chords_is_locked(LAYER_NUM));
+    CHECK(physical(NUM_ROW, NUM_COL, false));
+    CHECK(!decided(NUM_ROW, NUM_COL, BSP_NUM, true, true) && !decided(NUM_ROW, NUM_COL, BSP_NUM, false, true));
+}
+
+static void check_no_chord(void) {
+    // partner first: it is a key of its own, and so is the thumb after it
+    CHECK(physical(PARTNER_ROW, PARTNER_COL, true));
+    CHECK(physical(NAV_ROW, NAV_COL, true));
+    CHECK(physical(PARTNER_ROW, PARTNER_COL, false) && physical(NAV_ROW, NAV_COL, false));
+    CHECK(decided(NAV_ROW, NAV_COL, SPC_NAV, true, true) && decided(NAV_ROW, NAV_COL, SPC_NAV, false, true));
+    CHECK(!lock_chords_is_locked(LAYER_NAV));
+
+    // both thumbs and the partner: no such chord
+    CHECK(physical(NAV_ROW, NAV_COL, true) && physical(SYM_ROW, SYM_COL, true));
+    CHECK(physical(PARTNER_ROW, PARTNER_COL, true) && physical(PARTNER_ROW, PARTNER_COL, false));
+    CHECK(physical(NAV_ROW, NAV_COL, false) && physical(SYM_ROW, SYM_COL, false));
+    CHECK(layer_state == 0);
+
+    // other keys, and keys without a position, pass
+    CHECK(physical(KEY_ROW, KEY_COL, true) && physical(KEY_ROW, KEY_COL, false));
+    CHECK(physical(0xFF, 0xFF, true) && physical(0xFF, 0xFF, false));
+    keyrecord_t key = record(KEY_ROW, KEY_COL, false, 0);
+    CHECK(lock_chords_process(KC_A, &key));
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// both hooks on a press and a release of the key, as each key event costs them
+static double time_events(uint8_t row, uint8_t col, uint16_t keycode, uint32_t count) {
+    volatile bool sink  = false;
+    const double  start = now_ns();
+    for (uint32_t i = 0; i < count; i++) {
+        keyrecord_t event = record(row, col, i & 1, 0);
+        sink ^= lock_chords_pre_process(&event);
+        sink ^= lock_chords_process(keycode, &event);
+    }
+    (void)sink;
+    return (now_ns() - start) / (count ? count : 1);
+}
+
+int main(int argc, char **argv) {
+    uint32_t events = 10000000;
+    int      opt;
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                events = strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n EVENTS]\n  -n EVENTS  key events to time (default 10000000)\n", argv[0]);
+                return 2;
+        }
+    }
+
+    check_tapped_thumb();
+    check_held_thumb();
+    check_own_partner();
+    check_no_chord();
+    if (failures) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("lock chord checks pass\n");
+
+    printf("%.1f ns/event for other keys, %.1f ns/event for a thumb\n", time_events(KEY_ROW, KEY_COL, KC_A, events), time_events(NAV_ROW, NAV_COL, SPC_NAV, events));
+    return 0;
+}
@@ -0,0 +1,265 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+#include "spi_master.h"
+#include "pmw33xx_common.h"
+#include "pmw3360_mock.h"
+
+#define REG_Config1 0x0F
+#define REG_Motion_Burst 0x50
+#define BURST_LENGTH 6
+
+pmw3360_mock_t pmw3360_mock = {.byte_us = 4, .config1 = 15};
+
+static struct {
+    bool     selected;
+    uint8_t  bytes;     // written since selected
+    uint8_t  address;   // the first of them
+    uint32_t last_byte; // ticks, end of the last byte clocked
+    uint32_t ready;     // ticks, the next select allowed
+    bool     receiving; // in the background
+} bus;
+
+static bool qmk_in_burst; // QMK's driver's idea of it
+
+static void spend(uint32_t us) {
+    host_ticks += us;
+    pmw3360_mock.blocked_us += us;
+}
+
+static void violation(const char *what) {
+    if (pmw3360_mock.violations++ < 5) {
+        fprintf(stderr, "pmw3360 mock: %s at %lu us\n", what, (unsigned long)host_ticks);
+    }
+}
+
+static int16_t clamp16(int32_t value) {
+    return value < INT16_MIN ? INT16_MIN : value > INT16_MAX ? INT16_MAX : value;
+}
+
+void pmw3360_mock_move(int32_t x, int32_t y, uint32_t ticks) {
+    if (pmw3360_mock.x == 0 && pmw3360_mock.y == 0) {
+        pmw3360_mock.since = ticks;
+    }
+    pmw3360_mock.x += x;
+    pmw3360_mock.y += y;
+}
+
+void pmw3360_mock_reset(void) {
+    const uint32_t byte_us = pmw3360_mock.byte_us;
+    memset(&pmw3360_mock, 0, sizeof(pmw3360_mock));
+    memset(&bus, 0, sizeof(bus));
+    bus.last_byte        = host_ticks;
+    bus.ready            = host_ticks;
+    pmw3360_mock.byte_us = byte_us;
+    pmw3360_mock.config1 = 15;
+    qmk_in_burst         = false;
+}
+
+/* the sensor: what it clocks out for the transaction's address, from now on */
+
+static void register_write(uint8_t reg, uint8_t data) {
+    pmw3360_mock.burst_mode = reg == REG_Motion_Burst;
+    if (reg == REG_Config1) {
+        pmw3360_mock.config1 = data;
+    }
+}
+
+static void clock_out(uint8_t *out, uint16_t length) {
+    const uint32_t since_address = host_ticks - bus.last_byte;
+    memset(out, 0, length);
+    if (bus.bytes != 1 || (bus.address & 0x80)) {
+        violation("read without an address");
+        return;
+    }
+    if (bus.address != REG_Motion_Burst) {
+        if (since_address < PMW3360_MOCK_TSRAD_US) {
+            violation("register read before tSRAD");
+        }
+        pmw3360_mock.burst_mode = false;
+        out[0]                  = bus.address == REG_Config1 ? pmw3360_mock.config1 : 0;
+        return;
+    }
+    if (since_address < PMW3360_MOCK_TSRAD_MOTBR_US) {
+        violation("motion burst before tSRAD_MOTBR");
+    }
+    pmw3360_mock.bursts++;
+    uint8_t data[BURST_LENGTH] = {PMW3360_MOCK_JUNK};
+    if (pmw3360_mock.burst_mode) {
+        const int16_t x = clamp16(pmw3360_mock.x), y = clamp16(pmw3360_mock.y);
+        data[0]         = x || y ? 0x80 : 0x00;
+        data[2]         = (uint16_t)x & 0xFF;
+        data[3]         = (uint16_t)x >> 8;
+        data[4]         = (uint16_t)y & 0xFF;
+        data[5]         = (uint16_t)y >> 8;
+        pmw3360_mock.latched_since = pmw3360_mock.since;
+        pmw3360_mock.x             = 0;
+        pmw3360_mock.y             = 0;
+    } else {
+        pmw3360_mock.junk++;
+    }
+    memcpy(out, data, length < BURST_LENGTH ? length : BURST_LENGTH);
+}
+
+/* spi_master.h */
+
+bool spi_start(pin_t slave_pin, bool lsb_first, uint8_t mode, uint16_t divisor) {
+    if (bus.selected) {
+        return false;
+    }
+    if ((int32_t)(host_ticks - bus.ready) < 0) {
+        violation("select before the previous access's tSWW/tSRR");
+    }
+    pmw3360_mock.transactions++;
+    bus.selected = true;
+    bus.bytes    = 0;
+    return true;
+}
+
+spi_status_t spi_write(uint8_t data) {
+    if (!bus.selected || bus.receiving) {
+        violation("write while not selected or receiving");
+        return SPI_STATUS_ERROR;
+    }
+    spend(pmw3360_mock.byte_us);
+    bus.last_byte = host_ticks;
+    if (bus.bytes++ == 0) {
+        bus.address = data;
+    } else if (bus.bytes == 2 && (bus.address & 0x80)) {
+        register_write(bus.address & 0x7F, data);
+    }
+    return SPI_STATUS_SUCCESS;
+}
+
+spi_status_t spi_receive(uint8_t *out, uint16_t length) {
+    if (!bus.selected || bus.receiving) {
+        violation("receive while not selected or receiving");
+        return SPI_STATUS_ERROR;
+    }
+    clock_out(out, length);
+    spend(length * pmw3360_mock.byte_us);
+    bus.last_byte = host_ticks;
+    return SPI_STATUS_SUCCESS;
+}
+
+void spi_receive_start(uint8_t *out, uint16_t length) {
+    if (!bus.selected || bus.receiving) {
+        violation("receive while not selected or receiving");
+        return;
+    }
+    clock_out(out, length);
+    bus.receiving = true;
+    bus.last_byte = host_ticks + length * pmw3360_mock.byte_us;
+}
+
+void spi_receive_wait(void) {
+    if (bus.receiving && (int32_t)(bus.last_byte - host_ticks) > 0) {
+        spend(bus.last_byte - host_ticks);
+    }
+    bus.receiving = false;
+}
+
+void spi_stop(void) {
+    if (bus.receiving) {
+        violation("deselect during a transfer");
+        spi_receive_wait();
+    }
+    if (bus.address & 0x80) {
+        if (host_ticks - bus.last_byte < PMW3360_MOCK_TSCLK_NCS_W_US) {
+            violation("deselect before a write's tSCLK-NCS");
+        }
+        bus.ready = bus.last_byte + PMW3360_MOCK_TSWW_US;
+    } else {
+        bus.ready = bus.last_byte + (bus.address == REG_Motion_Burst ? 0 : PMW3360_MOCK_TSRR_US); // tBEXIT is 500 ns
+    }
+    bus.selected = false;
+}
+
+void wait_us(uint32_t us) {
+    spend(us);
+}
+
+/* QMK's PMW33xx driver, as `drivers/sensors/pmw33xx_common.c` and `pmw3360.c` do it */
+
+bool pmw33xx_init(uint8_t sensor) {
+    pmw3360_mock.config1    = 15; // PMW33XX_CPI, 1600
+    pmw3360_mock.burst_mode = false;
+    qmk_in_burst            = false;
+    return true;
+}
+
+bool pmw33xx_write(uint8_t sensor, uint8_t reg_addr, uint8_t data) {
+    if (!spi_start(PMW33XX_CS_PIN, false, 3, PMW33XX_SPI_DIVISOR)) {
+        return false;
+    }
+    if (reg_addr != REG_Motion_Burst) {
+        qmk_in_burst = false;
+    }
+    spi_write(reg_addr | 0x80);
+    spi_write(data);
+    wait_us(PMW3360_MOCK_TSCLK_NCS_W_US);
+    spi_stop();
+    wait_us(PMW3360_MOCK_TSWW_US - PMW3360_MOCK_TSCLK_NCS_W_US);
+    return true;
+}
+
+uint8_t pmw33xx_read(uint8_t sensor, uint8_t reg_addr) {
+    if (!spi_start(PMW33XX_CS_PIN, false, 3, PMW33XX_SPI_DIVISOR)) {
+        return 0;
+    }
+    qmk_in_burst = false;
+    uint8_t data = 0;
+    spi_write(reg_addr & 0x7F);
+    wait_us(PMW3360_MOCK_TSRAD_US);
+    spi_receive(&data, 1);
+    spi_stop();
+    wait_us(PMW3360_MOCK_TSRR_US);
+    return data;
+}
+
+pmw33xx_report_t pmw33xx_read_burst(uint8_t sensor) {
+    pmw33xx_report_t report = {0};
+    if (!qmk_in_burst) {
+        pmw33xx_write(sensor, REG_Motion_Burst, 0x00);
+        qmk_in_burst = true;
+    }
+    if (!spi_start(PMW33XX_CS_PIN, false, 3, PMW33XX_SPI_DIVISOR)) {
+        return report;
+    }
+    uint8_t data[BURST_LENGTH];
+    spi_write(REG_Motion_Burst);
+    wait_us(PMW3360_MOCK_TSRAD_MOTBR_US);
+    spi_receive(data, sizeof(data));
+    spi_stop();
+    report.motion.w    = data[0];
+    report.observation = data[1];
+    report.delta_x     = (int16_t)(data[2] | data[3] << 8);
+    report.delta_y     = (int16_t)(data[4] | data[5] << 8);
+    if (report.motion.w & 0b111) {
+        qmk_in_burst = false;
+    }
+    return report;
+}
+
+void pmw33xx_set_cpi(uint8_t sensor, uint16_t cpi) {
+    const int32_t value = cpi / 100 - 1;
+    pmw33xx_write(sensor, REG_Config1, value < 0 ? 0 : value > 119 ? 119 : value);
+}
+
+uint16_t pmw33xx_get_cpi(uint8_t sensor) {
+    return (pmw33xx_read(sensor, REG_Config1) + 1) * 100;
+}
@@ -0,0 +1,59 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/* A PMW3360 on QMK's SPI master, on the modelled clock `host_ticks`.
+ *
+ * `pmw3360_mock.c` implements `spi_master.h`, `wait_us()` and QMK's PMW33xx driver the way
+ * QMK does it, on top of a model of the sensor: motion piles up in it until a motion burst
+ * reads it out, the CPI is in its Config1 register, and it is in burst mode from a write to
+ * Motion_Burst until any other register is accessed.  Every byte takes its time on the bus,
+ * and waits and blocking transfers move the clock on by theirs, which is what a caller
+ * spends blocked.  Accesses sooner than the datasheet allows are counted, as are motion
+ * bursts outside burst mode, which read junk as the sensor would.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PMW3360_MOCK_TSRAD_US 160       // register address to data
+#define PMW3360_MOCK_TSRAD_MOTBR_US 35  // Motion_Burst address to data
+#define PMW3360_MOCK_TSWW_US 180        // write to the next access
+#define PMW3360_MOCK_TSRR_US 20         // read to the next access
+#define PMW3360_MOCK_TSCLK_NCS_W_US 35  // last byte of a write to deselect
+#define PMW3360_MOCK_JUNK 0x07          // Motion of a burst outside burst mode
+
+typedef struct {
+    uint32_t byte_us;       // SPI byte time, 4 at QMK's 2 MHz
+    int32_t  x;             // motion not read yet
+    int32_t  y;
+    uint32_t since;         // ticks, arrival of the oldest count not read yet
+    uint32_t latched_since; // `since` of the last motion burst
+    uint8_t  config1;       // CPI / 100 - 1
+    bool     burst_mode;
+    uint32_t transactions;  // chip selects
+    uint32_t bursts;        // motion bursts read
+    uint32_t junk;          // of those, outside burst mode
+    uint32_t violations;    // accesses sooner than the datasheet allows
+    uint64_t blocked_us;    // in waits and blocking transfers
+} pmw3360_mock_t;
+
+extern pmw3360_mock_t pmw3360_mock;
+
+/** Counts arriving at `ticks`, not before the previous ones. */
+void pmw3360_mock_move(int32_t x, int32_t y, uint32_t ticks);
+/** Back to a sensor at rest, idle on the bus since `host_ticks`, and no statistics, keeping the byte time. */
+void pmw3360_mock_reset(void);
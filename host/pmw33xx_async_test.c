@@ -0,0 +1,196 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks of `pmw33xx_async.c` on the modelled PMW3360, then the time the pointing task
+ * spends blocked per read, against QMK's `pmw33xx_read_burst()`.
+ *
+ * Main loop passes of random length start a burst, advance it after a random part of the
+ * pass and collect it at the end, or right after starting; motion arrives at random
+ * meanwhile and the CPI is set at random, also with a burst in flight.  No access may come
+ * sooner than the datasheet allows, every count moved must be read exactly once, and the
+ * sensor must have the CPI last set when the next burst starts.
+ */
+
+#include <getopt.h>
+#include "quantum.h"
+#include "pmw33xx_async.h"
+#include "pmw3360_mock.h"
+
+static int failures;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+static uint32_t rng_state = 1;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static struct {
+    int64_t x;
+    int64_t y;
+} moved, read;
+
+// up to `us` of the pass, with motion arriving now and then
+static void run_for(uint32_t us) {
+    host_ticks += us;
+    if (rng() % 2) {
+        const int32_t x = (int32_t)(rng() % 201) - 100, y = (int32_t)(rng() % 201) - 100;
+        pmw3360_mock_move(x, y, host_ticks);
+        moved.x += x;
+        moved.y += y;
+    }
+}
+
+static void collect(void) {
+    pmw33xx_report_t report;
+    CHECK(pmw33xx_async_collect(&report));
+    CHECK((report.motion.w & 0b111) == 0);
+    if (report.motion.b.is_motion) {
+        read.x += report.delta_x;
+        read.y += report.delta_y;
+    }
+}
+
+static void check_passes(uint32_t passes) {
+    uint16_t cpi = pmw33xx_async_get_cpi();
+    for (uint32_t i = 0; i < passes; i++) {
+        CHECK(pmw33xx_async_start());
+        CHECK(!pmw33xx_async_start());
+        // the CPI the burst started with, which a set during it leaves alone
+        CHECK((pmw3360_mock.config1 + 1) * 100 == cpi);
+        if (rng() % 8 == 0) {
+            const uint32_t transactions = pmw3360_mock.transactions;
+            cpi                         = 100 * (1 + rng() % 120);
+            pmw33xx_async_set_cpi(cpi);
+            CHECK(pmw33xx_async_get_cpi() == cpi && pmw3360_mock.transactions == transactions);
+        }
+        switch (rng() % 4) {
+            case 0: // collected right away
+                break;
+            case 1: // over before tSRAD_MOTBR
+                run_for(rng() % 35);
+                pmw33xx_async_advance();
+                run_for(rng() % 35);
+                break;
+            default: // a scan, then key events and RGB
+                run_for(rng() % 100);
+                pmw33xx_async_advance();
+                run_for(rng() % 400);
+                break;
+        }
+        collect();
+        CHECK(!pmw33xx_async_collect(&(pmw33xx_report_t){0}));
+        run_for(1 + rng() % 50);
+    }
+    CHECK(pmw33xx_async_start());
+    collect();
+    CHECK((pmw3360_mock.config1 + 1) * 100 == cpi);
+}
+
+// another access to the sensor ends its burst mode; the junk that reads is dropped once
+static void check_recovery(void) {
+    run_for(10);
+    pmw33xx_read(0, 0x02);
+    pmw33xx_report_t report;
+    CHECK(pmw33xx_async_start());
+    CHECK(pmw33xx_async_collect(&report) && (report.motion.w & 0b111));
+    const uint32_t junk = pmw3360_mock.junk;
+    for (uint8_t i = 0; i < 3; i++) {
+        run_for(1000);
+        CHECK(pmw33xx_async_start());
+        collect();
+    }
+    CHECK(pmw3360_mock.junk == junk);
+}
+
+// blocked per read, with `between_us` of other work from start to collect, half of it before advancing
+static double blocked_async(uint32_t between_us, uint32_t reads) {
+    const uint64_t from = pmw3360_mock.blocked_us;
+    for (uint32_t i = 0; i < reads; i++) {
+        pmw33xx_report_t report;
+        host_ticks += 100;
+        pmw33xx_async_start();
+        host_ticks += between_us / 2;
+        pmw33xx_async_advance();
+        host_ticks += between_us - between_us / 2;
+        pmw33xx_async_collect(&report);
+    }
+    return (double)(pmw3360_mock.blocked_us - from) / reads;
+}
+
+static double blocked_qmk(uint32_t reads) {
+    const uint64_t from = pmw3360_mock.blocked_us;
+    for (uint32_t i = 0; i < reads; i++) {
+        host_ticks += 100;
+        pmw33xx_read_burst(0);
+    }
+    return (double)(pmw3360_mock.blocked_us - from) / reads;
+}
+
+int main(int argc, char **argv) {
+    uint32_t passes = 100000;
+    int      opt;
+    while ((opt = getopt(argc, argv, "n:k:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                passes = strtoul(optarg, NULL, 0);
+                break;
+            case 'k':
+                pmw3360_mock.byte_us = (8000 + strtoul(optarg, NULL, 0) - 1) / strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr,
+                        "usage: %s [-n PASSES] [-k KHZ]\n"
+                        "  -n PASSES  main loop passes to check (default 100000)\n"
+                        "  -k KHZ     SPI clock (default 2000)\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+
+    CHECK(pmw33xx_async_init());
+    const uint32_t transactions = pmw3360_mock.transactions;
+    CHECK(pmw33xx_async_get_cpi() == 1600 && pmw3360_mock.transactions == transactions);
+    check_passes(passes);
+    check_recovery();
+    CHECK(moved.x == read.x + pmw3360_mock.x && moved.y == read.y + pmw3360_mock.y);
+    CHECK(pmw3360_mock.violations == 0);
+    if (failures) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("pmw33xx async checks pass: %lu bursts, %lu SPI transactions\n", (unsigned long)pmw3360_mock.bursts, (unsigned long)pmw3360_mock.transactions);
+
+    printf("blocked per read, %lu us per SPI byte:\n", (unsigned long)pmw3360_mock.byte_us);
+    printf("  %-28s %6.1f us\n", "pmw33xx_read_burst()", blocked_qmk(10000));
+    const uint32_t betweens[] = {0, 20, 40, 60, 100, 400};
+    for (size_t i = 0; i < ARRAY_SIZE(betweens); i++) {
+        char label[32];
+        snprintf(label, sizeof(label), "async, %lu us in between", (unsigned long)betweens[i]);
+        printf("  %-28s %6.1f us\n", label, blocked_async(betweens[i], 10000));
+    }
+    return pmw3360_mock.violations ? 1 : 0;
+}
@@ -0,0 +1,51 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/* pmw33xx_common.h: the sensor API of QMK's PMW33xx driver, implemented by the host tool
+ * that links it (see `pmw3360_mock.c`) */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PMW33XX_CS_PIN 0
+#define PMW33XX_SPI_DIVISOR 64
+
+typedef union {
+    struct {
+        uint8_t capture_from_raw_data : 1;
+        uint8_t operation_mode : 2;
+        uint8_t is_lifted : 1;
+        uint8_t raw_data_grab_is_raw_data : 1;
+        uint8_t reserved : 2;
+        uint8_t is_motion : 1;
+    } b;
+    uint8_t w;
+} pmw33xx_motion_t;
+
+typedef struct __attribute__((packed)) {
+    pmw33xx_motion_t motion;
+    uint8_t          observation;
+    int16_t          delta_x;
+    int16_t          delta_y;
+} pmw33xx_report_t;
+
+bool             pmw33xx_init(uint8_t sensor);
+pmw33xx_report_t pmw33xx_read_burst(uint8_t sensor);
+void             pmw33xx_set_cpi(uint8_t sensor, uint16_t cpi);
+uint16_t         pmw33xx_get_cpi(uint8_t sensor);
+uint8_t          pmw33xx_read(uint8_t sensor, uint8_t reg_addr);
+bool             pmw33xx_write(uint8_t sensor, uint8_t reg_addr, uint8_t data);
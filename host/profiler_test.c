@@ -0,0 +1,167 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks of `profiler.c` against the stub tick counter, then the cost of one mark.
+ *
+ * A scripted main loop advances `host_ticks` by known amounts between the marks the
+ * keymap's hooks make, so every stage's count, min, average, max and histogram is known
+ * exactly; the VIA replies are decoded and compared too.
+ */
+
+#include <getopt.h>
+#include <time.h>
+#include "quantum.h"
+#include "via.h"
+#include "profiler.h"
+
+static int failures;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                     \
+        }                                                                   \
+    } while (0)
+
+static void spend(uint32_t ticks) {
+    host_ticks += ticks;
+}
+
+// one pass of the main loop, as QMK calls the hooks, with `rgb` frames on every other pass
+static void loop_pass(uint32_t pass) {
+    spend(100); // scan
+    PROFILE_MARK(PROFILE_KEYS);
+    spend(10 + pass % 4); // keys: 10..13
+    if (pass % 2 == 0) {
+        PROFILE_MARK(PROFILE_RGB);
+        spend(300);
+        PROFILE_MARK(PROFILE_OTHER);
+        spend(5);
+    }
+    PROFILE_MARK(PROFILE_POINTING);
+    spend(pass == 7 ? 5000 : 50); // one slow report
+    PROFILE_MARK(PROFILE_SEND);
+    spend(20);
+    PROFILE_MARK(PROFILE_SPLIT);
+    spend(2);
+    PROFILE_MARK(PROFILE_HOUSEKEEPING);
+    spend(1);
+    PROFILE_MARK(PROFILE_SCAN);
+}
+
+static uint32_t get_u32(const uint8_t *data) {
+    return (uint32_t)data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+static void check_stages(void) {
+    profiler_init();
+    host_ticks = 1000;
+    PROFILE_MARK(PROFILE_SCAN); // as at the end of the first housekeeping
+    for (uint32_t pass = 0; pass < 8; pass++) {
+        loop_pass(pass);
+    }
+
+    const profiler_stats_t *scan = profiler_stats(PROFILE_SCAN);
+    CHECK(scan->count == 8 && scan->min == 100 && scan->max == 100);
+    const profiler_stats_t *keys = profiler_stats(PROFILE_KEYS);
+    CHECK(keys->count == 8 && keys->min == 10 && keys->max == 13 && keys->sum == 2 * (10 + 11 + 12 + 13));
+    const profiler_stats_t *rgb = profiler_stats(PROFILE_RGB);
+    CHECK(rgb->count == 4 && rgb->min == 300 && rgb->max == 300);
+    CHECK(profiler_stats(PROFILE_OTHER)->count == 4);
+    const profiler_stats_t *pointing = profiler_stats(PROFILE_POINTING);
+    CHECK(pointing->count == 8 && pointing->min == 50 && pointing->max == 5000 && pointing->sum == 7 * 50 + 5000);
+    CHECK(pointing->histogram[profiler_histogram_bucket(50)] == 7 && pointing->histogram[profiler_histogram_bucket(5000)] == 1);
+    CHECK(profiler_stats(PROFILE_SEND)->sum == 8 * 20);
+    CHECK(profiler_stats(PROFILE_SPLIT)->sum == 8 * 2);
+    CHECK(profiler_stats(PROFILE_HOUSEKEEPING)->sum == 8 * 1);
+
+    // the loop is timed from the first SCAN mark, so 8 passes make 8 loops
+    const profiler_stats_t *loop = profiler_stats(PROFILE_LOOP);
+    CHECK(loop->count == 8);
+    CHECK(loop->sum == host_ticks - 1000);
+    uint64_t stages = 0;
+    for (uint8_t stage = 0; stage < PROFILE_LOOP; stage++) {
+        stages += profiler_stats(stage)->sum;
+    }
+    CHECK(stages == loop->sum); // every tick is counted to exactly one stage
+
+    // histogram: bucket 0 below 2^SHIFT (8 with the microsecond stub), then doubling, last one open
+    CHECK(profiler_histogram_bucket(0) == 0 && profiler_histogram_bucket(7) == 0);
+    CHECK(profiler_histogram_bucket(8) == 1 && profiler_histogram_bucket(15) == 1 && profiler_histogram_bucket(16) == 2);
+    CHECK(profiler_histogram_bucket(UINT32_MAX) == PROFILER_HISTOGRAM_BUCKETS - 1);
+}
+
+static void check_via(void) {
+    uint8_t packet[32] = {id_custom_get_value, 25, 1, PROFILE_POINTING};
+    CHECK(profiler_via_command(packet, sizeof(packet)));
+    CHECK(packet[0] == id_custom_get_value && packet[3] == PROFILE_POINTING && packet[4] == TIMEBASE_TICKS_PER_US);
+    CHECK(get_u32(&packet[5]) == 8 && get_u32(&packet[9]) == 50 && get_u32(&packet[13]) == (7 * 50 + 5000) / 8 && get_u32(&packet[17]) == 5000);
+
+    uint8_t histogram[32] = {id_custom_get_value, 25, 2, PROFILE_POINTING};
+    CHECK(profiler_via_command(histogram, sizeof(histogram)));
+    CHECK(histogram[4] == PROFILER_HISTOGRAM_BUCKETS);
+    const uint8_t slow = profiler_histogram_bucket(5000);
+    CHECK(histogram[5 + slow * 2] == 1 && histogram[6 + slow * 2] == 0);
+
+    uint8_t other[32] = {id_custom_get_value, 24, 1, 0};
+    CHECK(!profiler_via_command(other, sizeof(other))); // maccel's channel is left alone
+
+    uint8_t bad[32] = {id_custom_get_value, 25, 1, PROFILE_STAGES};
+    CHECK(profiler_via_command(bad, sizeof(bad)) && bad[3] == 0xFF);
+
+    uint8_t reset[32] = {id_custom_set_value, 25, 3};
+    CHECK(profiler_via_command(reset, sizeof(reset)) && reset[0] == id_custom_set_value);
+    CHECK(profiler_stats(PROFILE_POINTING)->count == 0 && profiler_stats(PROFILE_LOOP)->count == 0);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    uint32_t marks = 10000000;
+    int      opt;
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                marks = strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n MARKS]\n  -n MARKS  marks to time (default 10000000)\n", argv[0]);
+                return 2;
+        }
+    }
+
+    check_stages();
+    check_via();
+    if (failures) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("profiler checks pass\n");
+
+    profiler_reset();
+    const double start = now_ns();
+    for (uint32_t i = 0; i < marks; i++) {
+        host_ticks += i & 0x3FF;
+        profiler_mark(i % PROFILE_LOOP);
+    }
+    printf("%.1f ns/mark\n", (now_ns() - start) / (marks ? marks : 1));
+    return 0;
+}
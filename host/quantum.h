@@ -0,0 +1,84 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/* Minimal stand-ins for the QMK APIs the keymap's own modules use, so they compile and
+ * run on a Linux host. See `host_stubs.c`.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "report.h"
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define ARRAY_SIZE(array) (sizeof(array) / sizeof((array)[0]))
+
+/* action_layer.h */
+typedef uint32_t layer_state_t;
+uint8_t          get_highest_layer(layer_state_t state);
+
+/* modifiers.h */
+#define MOD_MASK_CTRL 0x11
+#define MOD_MASK_SHIFT 0x22
+#define MOD_MASK_ALT 0x44
+#define MOD_MASK_GUI 0x88
+
+/* color.h / rgb_matrix.h */
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} RGB;
+
+#define RGB_BLACK 0x00, 0x00, 0x00
+#define RGB_BLUE 0x00, 0x00, 0xFF
+#define RGB_CORAL 0xFF, 0x7C, 0x4D
+#define RGB_CYAN 0x00, 0xFF, 0xFF
+#define RGB_GREEN 0x00, 0xFF, 0x00
+#define RGB_RED 0xFF, 0x00, 0x00
+#define RGB_WHITE 0xFF, 0xFF, 0xFF
+#define RGB_YELLOW 0xFF, 0xFF, 0x00
+
+#ifndef RGB_MATRIX_LED_COUNT
+#    define RGB_MATRIX_LED_COUNT 58 // charybdis 3x6
+#endif
+
+void rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue);
+
+/* Host-only: the LED buffer `rgb_matrix_set_color()` writes. */
+extern RGB host_leds[RGB_MATRIX_LED_COUNT];
+
+/* Host-only: the shared timebase (`timebase.h`), in microseconds, advanced by whoever
+ * drives the profiler, the sensor scheduler and split motion. */
+extern uint32_t host_ticks;
+#define TIMEBASE_TICKS() (host_ticks)
+#define TIMEBASE_TICKS_PER_US 1
+#define TIMEBASE_HIGH_RESOLUTION
+
+/* wait.h, implemented by the host tool that needs it */
+void wait_us(uint32_t us);
+
+/* split_util.h, timer.h and pointing_device.h, implemented by the host tool that needs them */
+bool     is_keyboard_master(void);
+bool     is_keyboard_left(void);
+uint32_t timer_read32(void);
+uint32_t timer_elapsed32(uint32_t last);
+uint16_t pointing_device_get_cpi(void);
+void     pointing_device_set_cpi(uint16_t cpi);
@@ -0,0 +1,416 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Sensor read scheduling on a simulated main loop: `pointing_scheduler.c`'s custom driver
+ * and report coalescing, as `keymap.c` uses them, against reading and sending on every
+ * pass and against `POINTING_DEVICE_TASK_THROTTLE_MS`.
+ *
+ *   scheduler_sim [options] [TRACE]
+ *
+ * Motion comes from a maccel trace (`dt_us x y` lines, see ../maccel/host), or a synthetic
+ * one, and accumulates in the modelled PMW3360 of `pmw3360_mock.c` until a motion burst reads
+ * it out.  Each pass costs `-l` us, the first `-m` of them scanning the matrix, plus `-x` us
+ * more while moving (maccel, a busier RGB effect), plus the time blocked on the sensor's SPI,
+ * at the register timing of its datasheet.  Built as `scheduler_sim_async`, the adaptive
+ * policy reads with `pmw33xx_async.c`: started at the end of a pass, advanced after the next
+ * scan and collected in its pointing task.  For each policy it reports:
+ *
+ * - sensor reads per second overall, and the share of time blocked on them;
+ * - reports sent per second, i.e. USB transactions, and how many of them went out in a
+ *   1 ms frame that had one already (the host takes one per poll, the rest wait);
+ * - onset latency: from the first count of a movement to the report that carries it;
+ * - the interval between reports during motion, mean and standard deviation, which is
+ *   what maccel divides distance by;
+ * - counts lost to the 8-bit report clamp, from motion piling up between reads, or still
+ *   held back at the end.
+ *
+ * With `-H` the adaptive policy runs as on the half with the sensor but without USB, whose
+ * driver QMK's split pointing calls for the other half, so without the coalescer.  `-w` starts
+ * the tick counter elsewhere than at 0, e.g. near where differences from 0 turn negative.  The
+ * adaptive policy fails the run if it reports a count later than its idle interval and longest
+ * backoff, plus two passes, allow, or still holds any back at the end.
+ *
+ *   -l us   pass cost without the sensor (250)    -m us  of it, the matrix scan (100)
+ *   -x us   extra pass cost while moving (0)      -t ms  static throttle to compare (5)
+ *   -k kHz  SPI clock (2000)                      -s seed (1)
+ *   -n ms   synthetic trace length, of motion (100000)
+ *   -w ticks  tick counter at the start (0)       -H  the sensor half, see above
+ */
+
+#include <getopt.h>
+#include <math.h>
+#include "quantum.h"
+#include "pmw33xx_common.h"
+#include "pmw3360_mock.h"
+#include "pointing_scheduler.h"
+
+void           pointing_device_driver_init(void);
+report_mouse_t pointing_device_driver_get_report(report_mouse_t mouse_report);
+
+#define STROKE_GAP_US 100000 // a report this long after the previous one starts a movement
+
+typedef struct {
+    uint64_t time_us; // absolute
+    int16_t  x;
+    int16_t  y;
+} motion_t;
+
+static struct {
+    motion_t *motions;
+    size_t    count;
+    size_t    capacity;
+} trace;
+
+static void trace_push(uint64_t time_us, int16_t x, int16_t y) {
+    if (trace.count == trace.capacity) {
+        trace.capacity = trace.capacity ? trace.capacity * 2 : 4096;
+        trace.motions  = realloc(trace.motions, trace.capacity * sizeof(motion_t));
+        if (!trace.motions) {
+            perror("realloc");
+            exit(2);
+        }
+    }
+    trace.motions[trace.count++] = (motion_t){time_us, x, y};
+}
+
+static bool trace_load(const char *path) {
+    FILE *file = strcmp(path, "-") ? fopen(path, "r") : stdin;
+    if (!file) {
+        perror(path);
+        return false;
+    }
+    char     line[128];
+    uint64_t time_us = 0;
+    while (fgets(line, sizeof(line), file)) {
+        unsigned long dt_us;
+        int           x, y;
+        const char   *text = line + strspn(line, " \t");
+        if (*text == '#' || *text == '\n' || *text == '\0' || strncmp(text, "cpi", 3) == 0) {
+            continue;
+        }
+        if (sscanf(text, "%lu %d %d", &dt_us, &x, &y) != 3) {
+            fprintf(stderr, "%s: expected `dt_us x y`: %s", path, line);
+            return false;
+        }
+        time_us += dt_us;
+        trace_push(time_us, x, y);
+    }
+    if (file != stdin) {
+        fclose(file);
+    }
+    return true;
+}
+
+static uint32_t xorshift32(uint32_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+/* As maccel_bench's: strokes of 20..400 ms, peak 1..60 counts/ms, pauses of 0..800 ms.  Counts
+ * arrive every 125 us rather than once per report, as they do in a sensor, and `count` is
+ * still in milliseconds of motion. */
+#define SYNTHETIC_STEP_US 125
+static void trace_synthesize(size_t count, uint32_t seed) {
+    uint32_t rng     = seed ? seed : 1;
+    uint64_t time_us = 0;
+    size_t   steps   = 0;
+    while (steps < count * (1000 / SYNTHETIC_STEP_US)) {
+        const uint32_t length  = (20 + xorshift32(&rng) % 381) * (1000 / SYNTHETIC_STEP_US);
+        const float    peak    = (1 + xorshift32(&rng) % 60) / (1000.0f / SYNTHETIC_STEP_US);
+        const float    angle   = (xorshift32(&rng) % 6283) / 1000.0f;
+        float          carry_x = 0, carry_y = 0;
+        for (uint32_t i = 0; i < length; i++, steps++) {
+            const float phase = (float)i / length;
+            const float speed = peak * 4 * phase * (1 - phase);
+            carry_x += speed * cosf(angle);
+            carry_y += speed * sinf(angle);
+            const int16_t x = (int16_t)carry_x, y = (int16_t)carry_y;
+            carry_x -= x;
+            carry_y -= y;
+            time_us += SYNTHETIC_STEP_US;
+            if (x || y) {
+                trace_push(time_us, x, y);
+            }
+        }
+        time_us += (xorshift32(&rng) % 800) * 1000;
+    }
+}
+
+/* the sensor, and the clock it moves on */
+
+static size_t   arrived; // trace motions in the sensor
+static uint64_t now_us;
+static uint32_t start_ticks; // `host_ticks` at `now_us` 0
+
+static void sensor_arrive(void) {
+    for (; arrived < trace.count && trace.motions[arrived].time_us <= now_us; arrived++) {
+        pmw3360_mock_move(trace.motions[arrived].x, trace.motions[arrived].y, start_ticks + (uint32_t)trace.motions[arrived].time_us);
+    }
+}
+
+// the sensor's waits moved `host_ticks` on
+static void clock_sync(void) {
+    now_us += (uint32_t)(host_ticks - start_ticks - (uint32_t)now_us);
+}
+
+static void spend(uint32_t us) {
+    now_us += us;
+    host_ticks = start_ticks + (uint32_t)now_us;
+}
+
+static int64_t clamped_x; // lost to the report range, signed
+static int64_t clamped_y;
+static int64_t clamped;   // the same, in absolute counts
+
+/* the policies */
+
+static uint32_t throttle_ms = 5;
+
+static report_mouse_t read_report(report_mouse_t report) {
+    const pmw33xx_report_t burst = pmw33xx_read_burst(0);
+    clock_sync();
+    if (burst.motion.b.is_motion) {
+        report.x = CONSTRAIN_HID_XY(burst.delta_x);
+        report.y = CONSTRAIN_HID_XY(burst.delta_y);
+        clamped_x += burst.delta_x - report.x;
+        clamped_y += burst.delta_y - report.y;
+        clamped += abs(burst.delta_x - report.x) + abs(burst.delta_y - report.y);
+    }
+    return report;
+}
+
+static report_mouse_t every_pass(report_mouse_t report) {
+    return read_report(report);
+}
+
+// QMK's pointing task throttle, on its millisecond timer
+static report_mouse_t throttled(report_mouse_t report) {
+    static uint32_t last_exec;
+    const uint32_t  now_ms = now_us / 1000;
+    if (now_ms - last_exec < throttle_ms) {
+        return report;
+    }
+    last_exec = now_ms;
+    return read_report(report);
+}
+
+// `pointing_device_task_user()`, after the custom driver
+static report_mouse_t adaptive(report_mouse_t report) {
+    report = pointing_device_driver_get_report(report);
+    clock_sync();
+    pointing_scheduler_coalesce(&report);
+    return report;
+}
+
+// the same on the half with the sensor, for QMK's split pointing to take to the other one
+static report_mouse_t adaptive_sensor_half(report_mouse_t report) {
+    report = pointing_device_driver_get_report(report);
+    clock_sync();
+    return report;
+}
+
+/* statistics */
+
+typedef struct {
+    double   sum;
+    double   sum_sq;
+    double   max;
+    uint32_t count;
+} series_t;
+
+static void series_add(series_t *series, double value) {
+    series->sum += value;
+    series->sum_sq += value * value;
+    series->count++;
+    if (value > series->max) {
+        series->max = value;
+    }
+}
+
+static double series_mean(const series_t *series) {
+    return series->count ? series->sum / series->count : 0;
+}
+
+static double series_stddev(const series_t *series) {
+    if (series->count < 2) {
+        return 0;
+    }
+    const double mean = series_mean(series);
+    return sqrt(fmax(0, series->sum_sq / series->count - mean * mean));
+}
+
+typedef struct {
+    double  oldest_ms; // the longest any count waited for its report
+    int64_t held;      // counts neither reported nor clamped by the end
+} outcome_t;
+
+static outcome_t simulate(const char *name, report_mouse_t (*get_report)(report_mouse_t), bool prefetch, uint32_t loop_us, uint32_t scan_us, uint32_t extra_us) {
+    host_ticks = start_ticks;
+    pmw3360_mock_reset();
+    arrived   = 0;
+    now_us    = 0;
+    clamped_x = 0;
+    clamped_y = 0;
+    clamped   = 0;
+
+    series_t latency = {0}, interval = {0};
+    uint64_t last_report = 0;
+    uint32_t reports = 0, same_frame = 0;
+    int64_t  sent_x = 0, sent_y = 0;
+    bool     moving = false;
+    double   oldest = 0;
+    const uint64_t end = trace.motions[trace.count - 1].time_us + 1000000;
+    pointing_device_driver_init();
+    clock_sync();
+    while (now_us < end) {
+        // the matrix scan, then key events and RGB up to the pointing task
+        spend(scan_us);
+        sensor_arrive();
+#ifdef PMW33XX_ASYNC_ENABLE
+        if (prefetch) {
+            pointing_scheduler_advance();
+        }
+#endif
+        spend(loop_us - scan_us + (moving ? extra_us : 0));
+        sensor_arrive();
+        const report_mouse_t report = get_report((report_mouse_t){0});
+        const uint32_t       read_since = pmw3360_mock.latched_since;
+        if (report.x || report.y) {
+            if (reports++ && now_us / 1000 == last_report / 1000) {
+                same_frame++;
+            }
+            sent_x += report.x;
+            sent_y += report.y;
+            const double age = (uint32_t)(host_ticks - read_since) / 1000.0;
+            oldest           = fmax(oldest, age);
+            if (!moving || now_us - last_report >= STROKE_GAP_US) {
+                series_add(&latency, age);
+            } else {
+                series_add(&interval, (now_us - last_report) / 1000.0);
+            }
+            last_report = now_us;
+            moving      = true;
+        } else if (moving && now_us - last_report >= STROKE_GAP_US) {
+            moving = false;
+        }
+#ifdef PMW33XX_ASYNC_ENABLE
+        // housekeeping, at the end of the pass
+        if (prefetch) {
+            pointing_scheduler_prefetch();
+            clock_sync();
+        }
+#endif
+    }
+    // whatever arrived and was neither sent nor clamped is still held back somewhere
+    int64_t arrived_x = 0, arrived_y = 0;
+    for (size_t i = 0; i < arrived; i++) {
+        arrived_x += trace.motions[i].x;
+        arrived_y += trace.motions[i].y;
+    }
+    const int64_t held   = llabs(arrived_x - pmw3360_mock.x - sent_x - clamped_x) + llabs(arrived_y - pmw3360_mock.y - sent_y - clamped_y);
+    const double seconds = now_us / 1e6;
+    printf("%-12s %9.0f %8.1f%% %9.0f %8u %8.2f %8.2f %8.3f %8.3f %8lld\n", name, pmw3360_mock.bursts / seconds, 100.0 * pmw3360_mock.blocked_us / now_us, reports / seconds, same_frame, series_mean(&latency), latency.max, series_mean(&interval), series_stddev(&interval), (long long)(clamped + held));
+    return (outcome_t){.oldest_ms = oldest, .held = held};
+}
+
+int main(int argc, char **argv) {
+    uint32_t loop_us  = 250;
+    uint32_t scan_us  = 100;
+    uint32_t extra_us = 0;
+    uint32_t spi_khz  = 2000;
+    size_t   count    = 100000;
+    uint32_t seed     = 1;
+    bool     half     = false;
+    int      opt;
+    while ((opt = getopt(argc, argv, "l:m:x:t:k:n:s:w:Hh")) != -1) {
+        switch (opt) {
+            case 'l':
+                loop_us = strtoul(optarg, NULL, 0);
+                break;
+            case 'm':
+                scan_us = strtoul(optarg, NULL, 0);
+                break;
+            case 'x':
+                extra_us = strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                throttle_ms = strtoul(optarg, NULL, 0);
+                break;
+            case 'k':
+                spi_khz = strtoul(optarg, NULL, 0);
+                break;
+            case 'n':
+                count = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                seed = strtoul(optarg, NULL, 0);
+                break;
+            case 'w':
+                start_ticks = strtoul(optarg, NULL, 0);
+                break;
+            case 'H':
+                half = true;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-l us] [-m us] [-x us] [-t ms] [-k kHz] [-n ms] [-s seed] [-w ticks] [-H] [TRACE], see the source\n", argv[0]);
+                return 2;
+        }
+    }
+    if (loop_us == 0) {
+        loop_us = 1;
+    }
+    if (scan_us > loop_us) {
+        scan_us = loop_us;
+    }
+    // a byte is 8 clocks
+    pmw3360_mock.byte_us = spi_khz ? (8000 + spi_khz - 1) / spi_khz : 4;
+    if (optind < argc) {
+        if (!trace_load(argv[optind])) {
+            return 2;
+        }
+    } else {
+        trace_synthesize(count, seed);
+    }
+    if (trace.count == 0) {
+        fprintf(stderr, "empty trace\n");
+        return 2;
+    }
+
+#ifdef PMW33XX_ASYNC_ENABLE
+    const char *const reads = "async";
+#else
+    const char *const reads = "blocking";
+#endif
+    printf("%zu motion samples over %.1f s, pass %u us (+%u moving, scan %u us), SPI byte %u us, adaptive reads %s%s, ticks from %#x\n\n", trace.count, trace.motions[trace.count - 1].time_us / 1e6, loop_us, extra_us, scan_us, pmw3360_mock.byte_us, reads, half ? " on the sensor half" : "", start_ticks);
+    printf("%-12s %9s %9s %9s %8s %8s %8s %8s %8s %8s\n", "", "reads/s", "blocked", "reports/s", "2nd/frm", "onset ms", "max", "intv ms", "jitter", "lost");
+    simulate("every pass", every_pass, false, loop_us, scan_us, extra_us);
+    char name[16];
+    snprintf(name, sizeof(name), "throttle %u", throttle_ms);
+    simulate(name, throttled, false, loop_us, scan_us, extra_us);
+    const outcome_t outcome = half ? simulate("sensor half", adaptive_sensor_half, true, loop_us, scan_us, extra_us) : simulate("adaptive", adaptive, true, loop_us, scan_us, extra_us);
+
+    const pointing_scheduler_stats_t stats = pointing_scheduler_stats();
+    printf("\nadaptive: %u reads, %u passes skipped, loop %u us, backoff %u us at the end, counts reported within %.2f ms\n", stats.reads, stats.skipped, stats.loop_us, stats.backoff_us, outcome.oldest_ms);
+    free(trace.motions);
+    const double bound = (POINTING_SCHEDULER_IDLE_INTERVAL_US + POINTING_SCHEDULER_BACKOFF_MAX_US + 2 * (loop_us + extra_us)) / 1000.0;
+    if (outcome.oldest_ms > bound || outcome.held) {
+        fprintf(stderr, "adaptive: a count waited %.2f ms for its report, over %.2f ms, or was never reported (%lld)\n", outcome.oldest_ms, bound, (long long)outcome.held);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,40 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/* spi_master.h: QMK's SPI master, implemented by the host tool that links it (see
+ * `pmw3360_mock.c`) */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef uint8_t pin_t;
+typedef int16_t spi_status_t;
+
+#define SPI_STATUS_SUCCESS (0)
+#define SPI_STATUS_ERROR (-1)
+
+bool         spi_start(pin_t slave_pin, bool lsb_first, uint8_t mode, uint16_t divisor);
+spi_status_t spi_write(uint8_t data);
+spi_status_t spi_receive(uint8_t *out, uint16_t length);
+void         spi_stop(void);
+
+/* Host-only: ChibiOS's asynchronous receive, which `pmw33xx_async.c` uses in place of
+ * `spi_receive()`, going on in the background of the modelled clock. */
+void spi_receive_start(uint8_t *out, uint16_t length);
+void spi_receive_wait(void);
+#define PMW33XX_ASYNC_RECEIVE(data, length) spi_receive_start((data), (length))
+#define PMW33XX_ASYNC_RECEIVE_WAIT() spi_receive_wait()
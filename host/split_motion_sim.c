@@ -0,0 +1,685 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Trackball motion across the split, with USB on the half without the trackball:
+ * `split_motion.c` as `keymap.c` uses it, against QMK's `SPLIT_POINTING_ENABLE`.
+ *
+ *   split_motion_sim [options] [TRACE]
+ *
+ * The halves are two processes, each with its own scheduler, driver and `split_motion.c`, as
+ * the two MCUs have, on one modelled clock: before a split transaction, the trackball half
+ * runs its passes up to the master's time, then answers it there, as the transport's
+ * interrupt would between two of its instructions.  Motion comes from a maccel trace
+ * (`dt_us x y` lines) or a synthetic one, as `scheduler_sim`'s, into the trackball half's
+ * modelled PMW3360, read by the scheduler's driver with asynchronous bursts.  maccel is an
+ * identity here that records the elapsed time it would measure for each report.
+ *
+ * QMK's split pointing is modelled on its `transactions.c`: every master pass reads a
+ * checksum of the other half's report, and the report when the checksum changed or 100 ms
+ * went by; the other half replaces its report with the driver's on each of its passes.  The
+ * master coalesces the reports and runs maccel on them, timed by their arrival.  (Its
+ * PUT_POINTING_CPI write on every pass is left out.)  `split_motion.c` is run with motion
+ * accelerated on the trackball half, and with raw counts accelerated on the master, as while
+ * drag-scrolling or with `SPLIT_MOTION_RAW`.
+ *
+ * The trackball half reads through the scheduler in all three.  A transaction costs `-g` us
+ * plus 10 bit times per byte at `-b` baud, its id included, and blocks the master; an RPC is
+ * QMK's info, request (unless empty), execute and reply transactions.  Reported:
+ *
+ * - split transactions and bytes per second, and the share of the master's time they block;
+ * - maccel runs per second on the master;
+ * - USB reports per second, the onset latency from the first count of a movement to the
+ *   report carrying it, the age of the latest counts in a report, from the sensor read they
+ *   came from, and the mean interval between reports while moving;
+ * - the error of the elapsed time maccel divides by, on whichever half it runs, against the
+ *   time between the sensor reads the counts came from: mean and maximum;
+ * - counts lost between the sensor and USB, overwritten, clamped or still held at the end.
+ *
+ *   -l us   master pass (250)                     -L us  trackball half's pass (230)
+ *   -b baud split serial (921600)                 -g us  per transaction (10)
+ *   -n ms   synthetic trace length, of motion (20000)     -s seed (1)
+ */
+
+#include <getopt.h>
+#include <math.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "quantum.h"
+#include "transactions.h"
+#include "pmw33xx_common.h"
+#include "pmw3360_mock.h"
+#include "pointing_scheduler.h"
+#include "split_motion.h"
+#include "maccel/maccel.h"
+
+void           pointing_device_driver_init(void);
+report_mouse_t pointing_device_driver_get_report(report_mouse_t mouse_report);
+uint16_t       pointing_device_driver_get_cpi(void);
+void           pointing_device_driver_set_cpi(uint16_t cpi);
+
+#define STROKE_GAP_US 100000    // a report this long after the previous one starts a movement
+#define MACCEL_PAUSE_US 50000   // maccel's MACCEL_VELOCITY_IDLE_MS
+#define FORCED_SYNC_US 100000   // QMK's FORCED_SYNC_THROTTLE_MS
+#define SIM_CPI 400
+
+typedef enum {
+    MODE_QMK,
+    MODE_SPLIT,
+    MODE_SPLIT_RAW,
+} sim_mode_t;
+
+static const char *const mode_names[] = {"qmk split", "split motion", "split raw"};
+
+/* the trace, as scheduler_sim's */
+
+typedef struct {
+    uint64_t time_us; // absolute
+    int16_t  x;
+    int16_t  y;
+} motion_t;
+
+static struct {
+    motion_t *motions;
+    size_t    count;
+    size_t    capacity;
+} trace;
+
+static void trace_push(uint64_t time_us, int16_t x, int16_t y) {
+    if (trace.count == trace.capacity) {
+        trace.capacity = trace.capacity ? trace.capacity * 2 : 4096;
+        trace.motions  = realloc(trace.motions, trace.capacity * sizeof(motion_t));
+        if (!trace.motions) {
+            perror("realloc");
+            exit(2);
+        }
+    }
+    trace.motions[trace.count++] = (motion_t){time_us, x, y};
+}
+
+static bool trace_load(const char *path) {
+    FILE *file = strcmp(path, "-") ? fopen(path, "r") : stdin;
+    if (!file) {
+        perror(path);
+        return false;
+    }
+    char     line[128];
+    uint64_t time_us = 0;
+    while (fgets(line, sizeof(line), file)) {
+        unsigned long dt_us;
+        int           x, y;
+        const char   *text = line + strspn(line, " \t");
+        if (*text == '#' || *text == '\n' || *text == '\0' || strncmp(text, "cpi", 3) == 0) {
+            continue;
+        }
+        if (sscanf(text, "%lu %d %d", &dt_us, &x, &y) != 3) {
+            fprintf(stderr, "%s: expected `dt_us x y`: %s", path, line);
+            return false;
+        }
+        time_us += dt_us;
+        trace_push(time_us, x, y);
+    }
+    if (file != stdin) {
+        fclose(file);
+    }
+    return true;
+}
+
+static uint32_t xorshift32(uint32_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+#define SYNTHETIC_STEP_US 125
+static void trace_synthesize(size_t count, uint32_t seed) {
+    uint32_t rng     = seed ? seed : 1;
+    uint64_t time_us = 0;
+    size_t   steps   = 0;
+    while (steps < count * (1000 / SYNTHETIC_STEP_US)) {
+        const uint32_t length  = (20 + xorshift32(&rng) % 381) * (1000 / SYNTHETIC_STEP_US);
+        const float    peak    = (1 + xorshift32(&rng) % 60) / (1000.0f / SYNTHETIC_STEP_US);
+        const float    angle   = (xorshift32(&rng) % 6283) / 1000.0f;
+        float          carry_x = 0, carry_y = 0;
+        for (uint32_t i = 0; i < length; i++, steps++) {
+            const float phase = (float)i / length;
+            const float speed = peak * 4 * phase * (1 - phase);
+            carry_x += speed * cosf(angle);
+            carry_y += speed * sinf(angle);
+            const int16_t x = (int16_t)carry_x, y = (int16_t)carry_y;
+            carry_x -= x;
+            carry_y -= y;
+            time_us += SYNTHETIC_STEP_US;
+            if (x || y) {
+                trace_push(time_us, x, y);
+            }
+        }
+        time_us += (xorshift32(&rng) % 800) * 1000;
+    }
+}
+
+/* statistics */
+
+typedef struct {
+    double   sum;
+    double   max;
+    uint32_t count;
+} series_t;
+
+static void series_add(series_t *series, double value) {
+    series->sum += value;
+    series->count++;
+    if (value > series->max) {
+        series->max = value;
+    }
+}
+
+static double series_mean(const series_t *series) {
+    return series->count ? series->sum / series->count : 0;
+}
+
+/* this half, and its clock */
+
+static bool     sim_master;
+static uint64_t now_us;
+static uint32_t pass_us;
+static uint32_t scan_us;
+static uint32_t sensor_pass_us = 230; // the trackball half's
+
+// the sensor's waits moved `host_ticks` on
+static void clock_sync(void) {
+    now_us += (uint32_t)(host_ticks - (uint32_t)now_us);
+}
+
+static void spend(uint32_t us) {
+    now_us += us;
+    host_ticks = now_us;
+}
+
+bool is_keyboard_master(void) {
+    return sim_master;
+}
+
+// USB is on the left, the trackball on the right (POINTING_DEVICE_RIGHT)
+bool is_keyboard_left(void) {
+    return sim_master;
+}
+
+uint32_t timer_read32(void) {
+    return host_ticks / 1000;
+}
+
+uint32_t timer_elapsed32(uint32_t last) {
+    return timer_read32() - last;
+}
+
+uint16_t pointing_device_get_cpi(void) {
+    return pointing_device_driver_get_cpi();
+}
+
+void pointing_device_set_cpi(uint16_t cpi) {
+    pointing_device_driver_set_cpi(cpi);
+}
+
+/* maccel, as an identity that measures the elapsed time as maccel does */
+
+maccel_config_t g_maccel_profiles[MACCEL_PROFILE_COUNT] = {
+    [0] = MACCEL_CONFIG(1.18, 0.56, 3.6, 9.0),
+    [1] = MACCEL_CONFIG(1.18, 0.40, 6.0, 3.0),
+    [2] = MACCEL_CONFIG(1.50, 0.80, 2.5, 12.0),
+};
+
+static struct {
+    bool     raw;       // as while drag-scrolling
+    uint8_t  profile;
+    uint32_t last;      // ticks, the previous report with motion
+    uint64_t last_read; // the sensor read of its latest counts
+    uint64_t read_us;   // the sensor read of the latest counts in the next report
+    bool     given;
+    uint16_t given_us;
+    uint32_t calls;
+    series_t error; // us
+} maccel;
+
+report_mouse_t pointing_device_task_maccel(report_mouse_t mouse_report) {
+    if (mouse_report.x == 0 && mouse_report.y == 0) {
+        return mouse_report;
+    }
+    maccel.calls++;
+    uint32_t elapsed = host_ticks - maccel.last;
+    maccel.last      = host_ticks;
+    if (maccel.given) {
+        elapsed      = maccel.given_us;
+        maccel.given = false;
+    }
+    const uint64_t truth = maccel.read_us - maccel.last_read;
+    maccel.last_read     = maccel.read_us;
+    if (elapsed < MACCEL_PAUSE_US && truth < MACCEL_PAUSE_US) {
+        series_add(&maccel.error, fabs((double)elapsed - (double)truth));
+    }
+    return mouse_report;
+}
+
+void maccel_report_elapsed(uint16_t elapsed_us) {
+    maccel.given    = true;
+    maccel.given_us = elapsed_us;
+}
+
+bool maccel_dragscroll_is_enabled(void) {
+    return maccel.raw;
+}
+
+uint8_t maccel_profile_get(void) {
+    return maccel.profile;
+}
+
+void maccel_profile_select(uint8_t profile) {
+    maccel.profile = profile;
+}
+
+void maccel_profiles_changed(void) {}
+
+void maccel_cpi_changed(void) {}
+
+/* The link: the master's requests and the trackball half's replies, over a socket pair.
+ * `side` is the simulation's own, for measuring, and costs nothing on the modelled link. */
+
+#define SIM_BUFFER 32
+
+typedef enum {
+    LINK_QMK_CHECKSUM,
+    LINK_QMK_DATA,
+    LINK_RPC,
+    LINK_END,
+} link_kind_t;
+
+typedef struct {
+    uint8_t  kind;
+    int8_t   id;
+    uint8_t  in_length;
+    uint8_t  out_length;
+    uint64_t time_us;
+    uint8_t  data[SIM_BUFFER];
+} link_request_t;
+
+typedef struct {
+    uint64_t read_us; // the sensor read of the latest counts in the reply
+    uint64_t since;   // arrival in the sensor of the oldest
+    bool     motion;
+} side_t;
+
+typedef struct {
+    uint8_t data[SIM_BUFFER];
+    side_t  side;
+} link_reply_t;
+
+// what the trackball half reports at the end
+typedef struct {
+    series_t error; // of maccel's elapsed times
+    int64_t  unread_x; // in the sensor
+    int64_t  unread_y;
+    uint32_t violations;
+} sensor_end_t;
+
+static int link_fd;
+
+static void link_exchange(const void *out, size_t out_length, void *in, size_t in_length) {
+    if (out && write(link_fd, out, out_length) != (ssize_t)out_length) {
+        perror("link write");
+        exit(2);
+    }
+    for (size_t done = 0; in && done < in_length;) {
+        const ssize_t got = read(link_fd, (uint8_t *)in + done, in_length - done);
+        if (got <= 0) {
+            perror("link read");
+            exit(2);
+        }
+        done += got;
+    }
+}
+
+/* the trackball half */
+
+static size_t           arrived; // trace motions in the sensor
+static slave_callback_t rpc_callback;
+static struct {
+    report_mouse_t report; // QMK's split shared memory
+    uint8_t        checksum;
+    side_t         side;
+} shared;
+static side_t pending; // motion kept by `split_motion.c`, not polled yet
+
+void transaction_register_rpc(int8_t transaction_id, slave_callback_t callback) {
+    rpc_callback = callback;
+}
+
+static void sensor_arrive(void) {
+    for (; arrived < trace.count && trace.motions[arrived].time_us <= now_us; arrived++) {
+        pmw3360_mock_move(trace.motions[arrived].x, trace.motions[arrived].y, (uint32_t)trace.motions[arrived].time_us);
+    }
+}
+
+static uint8_t crc8(const void *data, size_t length) {
+    uint8_t crc = 0xFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= ((const uint8_t *)data)[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = crc & 0x80 ? (uint8_t)(crc << 1) ^ 0x31 : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void sensor_pass(sim_mode_t mode) {
+    spend(scan_us);
+    sensor_arrive();
+    // matrix_slave_scan_user()
+    pointing_scheduler_advance();
+    spend(pass_us - scan_us);
+    sensor_arrive();
+    const uint32_t bursts = pmw3360_mock.bursts;
+    report_mouse_t report = pointing_device_driver_get_report((report_mouse_t){0});
+    clock_sync();
+    const uint32_t since = pmw3360_mock.bursts != bursts ? pmw3360_mock.latched_since : (uint32_t)now_us;
+    const bool motion = report.x || report.y;
+    if (mode == MODE_QMK) {
+        // QMK's pointing_handlers_slave(), on every pass
+        shared.report   = report;
+        shared.checksum = crc8(&report, sizeof(report));
+        shared.side     = (side_t){.read_us = now_us, .since = since, .motion = motion};
+    } else {
+        if (motion) {
+            if (!pending.motion) {
+                pending.since = since;
+            }
+            pending.read_us = now_us;
+            pending.motion  = true;
+        }
+        maccel.read_us = now_us;
+        split_motion_send(report);
+    }
+    // housekeeping_task_user()
+    if (mode != MODE_QMK) {
+        split_motion_task();
+    }
+    pointing_scheduler_prefetch();
+    clock_sync();
+}
+
+static void sensor_serve(sim_mode_t mode) {
+    link_request_t request;
+    for (;;) {
+        link_exchange(NULL, 0, &request, sizeof(request));
+        while (now_us + pass_us <= request.time_us) {
+            sensor_pass(mode);
+        }
+        link_reply_t reply = {0};
+        // answered at the master's time, between two of this half's instructions
+        host_ticks = request.time_us;
+        switch (request.kind) {
+            case LINK_QMK_CHECKSUM:
+                reply.data[0] = shared.checksum;
+                break;
+            case LINK_QMK_DATA:
+                memcpy(reply.data, &shared.report, sizeof(shared.report));
+                reply.side = shared.side;
+                break;
+            case LINK_RPC:
+                rpc_callback(request.in_length, request.data, request.out_length, reply.data);
+                reply.side = pending;
+                pending    = (side_t){0};
+                break;
+            case LINK_END: {
+                sensor_end_t end = {.error = maccel.error, .unread_x = pmw3360_mock.x, .unread_y = pmw3360_mock.y, .violations = pmw3360_mock.violations};
+                link_exchange(&end, sizeof(end), NULL, 0);
+                return;
+            }
+        }
+        host_ticks = now_us;
+        link_exchange(&reply, sizeof(reply), NULL, 0);
+    }
+}
+
+/* the master */
+
+static uint32_t link_baud = 921600;
+static uint32_t link_gap_us = 10;
+static struct {
+    uint64_t transactions;
+    uint64_t bytes;
+    uint64_t busy_us;
+    side_t   side; // of the latest reply with motion
+} wire;
+
+static void link_transaction(uint8_t bytes) {
+    const uint32_t us = link_gap_us + (uint32_t)((1 + bytes) * 10 * 1000000ULL / link_baud);
+    wire.transactions++;
+    wire.bytes += 1 + bytes;
+    wire.busy_us += us;
+    spend(us);
+}
+
+static link_reply_t link_request(link_kind_t kind, int8_t id, uint8_t in_length, const void *in, uint8_t out_length) {
+    link_request_t request = {.kind = kind, .id = id, .in_length = in_length, .out_length = out_length, .time_us = now_us};
+    if (in) {
+        memcpy(request.data, in, in_length);
+    }
+    link_reply_t reply;
+    link_exchange(&request, sizeof(request), &reply, sizeof(reply));
+    if (reply.side.motion) {
+        wire.side = reply.side;
+    }
+    return reply;
+}
+
+bool transaction_rpc_exec(int8_t transaction_id, uint8_t initiator2target_buffer_size, const void *initiator2target_buffer, uint8_t target2initiator_buffer_size, void *target2initiator_buffer) {
+    link_transaction(4); // PUT_RPC_INFO: id, lengths, checksum
+    if (initiator2target_buffer_size > 0) {
+        link_transaction(initiator2target_buffer_size);
+    }
+    link_transaction(1); // EXECUTE_RPC
+    const link_reply_t reply = link_request(LINK_RPC, transaction_id, initiator2target_buffer_size, initiator2target_buffer, target2initiator_buffer_size);
+    link_transaction(target2initiator_buffer_size);
+    memcpy(target2initiator_buffer, reply.data, target2initiator_buffer_size);
+    return true;
+}
+
+bool transaction_rpc_send(int8_t transaction_id, uint8_t initiator2target_buffer_size, const void *initiator2target_buffer) {
+    return false;
+}
+
+bool is_transport_connected(void) {
+    return true;
+}
+
+// QMK's pointing_handlers_master(), in the scan: the shared report, if it changed
+static report_mouse_t qmk_master_sync(void) {
+    static uint8_t  last_checksum;
+    static uint64_t last_update;
+    link_transaction(1);
+    const uint8_t checksum = link_request(LINK_QMK_CHECKSUM, 0, 0, NULL, 1).data[0];
+    if (checksum == last_checksum && now_us - last_update < FORCED_SYNC_US) {
+        return (report_mouse_t){0};
+    }
+    report_mouse_t     report;
+    const link_reply_t reply = link_request(LINK_QMK_DATA, 0, 0, NULL, sizeof(report));
+    link_transaction(sizeof(report));
+    memcpy(&report, reply.data, sizeof(report));
+    last_checksum = checksum;
+    last_update   = now_us;
+    return report;
+}
+
+static void simulate(sim_mode_t mode) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        perror("socketpair");
+        exit(2);
+    }
+    const pid_t sensor_pid = fork();
+    if (sensor_pid < 0) {
+        perror("fork");
+        exit(2);
+    }
+    sim_master = sensor_pid != 0;
+    link_fd    = fds[sim_master ? 0 : 1];
+    close(fds[sim_master ? 1 : 0]);
+    host_ticks = 0;
+    pointing_device_driver_init();
+    pointing_device_set_cpi(SIM_CPI);
+    split_motion_init();
+    if (!sim_master) {
+        pass_us = sensor_pass_us;
+        scan_us = pass_us * 2 / 5;
+        sensor_serve(mode);
+        exit(0);
+    }
+    maccel.raw = mode == MODE_SPLIT_RAW;
+
+    series_t latency = {0}, interval = {0}, age = {0};
+    uint64_t last_report = 0, held_since = 0;
+    uint32_t reports = 0;
+    int64_t  sent_x = 0, sent_y = 0;
+    bool     moving = false, held = false;
+    const uint64_t end = trace.motions[trace.count - 1].time_us + 1000000;
+    while (now_us < end) {
+        // the matrix scan, and QMK's split transactions at its end
+        spend(scan_us);
+        report_mouse_t report = {0};
+        if (mode == MODE_QMK) {
+            report = qmk_master_sync();
+        }
+        spend(pass_us - scan_us);
+        // pointing_device_task_user()
+        if ((report.x || report.y || mode != MODE_QMK) && wire.side.motion && !held) {
+            held_since = wire.side.since;
+            held       = true;
+        }
+        if (pointing_scheduler_coalesce(&report)) {
+            maccel.read_us = wire.side.read_us;
+            if (mode == MODE_QMK || !split_motion_take(&report)) {
+                report = pointing_device_task_maccel(report);
+            }
+        }
+        if (report.x || report.y) {
+            reports++;
+            series_add(&age, (now_us - maccel.read_us) / 1000.0);
+            sent_x += report.x;
+            sent_y += report.y;
+            if (!moving || now_us - last_report >= STROKE_GAP_US) {
+                series_add(&latency, (now_us - held_since) / 1000.0);
+            } else {
+                series_add(&interval, (now_us - last_report) / 1000.0);
+            }
+            last_report = now_us;
+            moving      = true;
+            held        = false;
+            wire.side   = (side_t){0};
+        } else if (moving && now_us - last_report >= STROKE_GAP_US) {
+            moving = false;
+        }
+        // housekeeping_task_user()
+        if (mode != MODE_QMK) {
+            split_motion_task();
+        }
+    }
+    sensor_end_t         sensor;
+    const link_request_t request = {.kind = LINK_END, .time_us = now_us};
+    link_exchange(&request, sizeof(request), &sensor, sizeof(sensor));
+    waitpid(sensor_pid, NULL, 0);
+
+    int64_t arrived_x = 0, arrived_y = 0;
+    for (size_t i = 0; i < trace.count && trace.motions[i].time_us <= now_us; i++) {
+        arrived_x += trace.motions[i].x;
+        arrived_y += trace.motions[i].y;
+    }
+    const int64_t   lost    = llabs(arrived_x - sensor.unread_x - sent_x) + llabs(arrived_y - sensor.unread_y - sent_y);
+    const series_t *error   = mode == MODE_SPLIT ? &sensor.error : &maccel.error;
+    const double    seconds = now_us / 1e6;
+    printf("%-13s %8.0f %8.0f %7.1f%% %8.0f %9.0f %8.2f %8.3f %8.3f %8.1f %8.0f %8lld\n", mode_names[mode], wire.transactions / seconds, wire.bytes / seconds, 100.0 * wire.busy_us / now_us, maccel.calls / seconds, reports / seconds, series_mean(&latency), series_mean(&age), series_mean(&interval), series_mean(error), error->max, (long long)lost);
+    if (sensor.violations) {
+        printf("  %u sensor timing violations\n", sensor.violations);
+    }
+}
+
+int main(int argc, char **argv) {
+    uint32_t master_pass_us = 250;
+    size_t   count          = 20000;
+    uint32_t seed           = 1;
+    int      opt;
+    while ((opt = getopt(argc, argv, "l:L:b:g:n:s:h")) != -1) {
+        switch (opt) {
+            case 'l':
+                master_pass_us = strtoul(optarg, NULL, 0);
+                break;
+            case 'L':
+                sensor_pass_us = strtoul(optarg, NULL, 0);
+                break;
+            case 'b':
+                link_baud = strtoul(optarg, NULL, 0);
+                break;
+            case 'g':
+                link_gap_us = strtoul(optarg, NULL, 0);
+                break;
+            case 'n':
+                count = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                seed = strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-l us] [-L us] [-b baud] [-g us] [-n ms] [-s seed] [TRACE], see the source\n", argv[0]);
+                return 2;
+        }
+    }
+    if (link_baud == 0) {
+        link_baud = 1;
+    }
+    if (optind < argc) {
+        if (!trace_load(argv[optind])) {
+            return 2;
+        }
+    } else {
+        trace_synthesize(count, seed);
+    }
+    if (trace.count == 0) {
+        fprintf(stderr, "empty trace\n");
+        return 2;
+    }
+
+    printf("%zu motion samples over %.1f s, master pass %u us, trackball half's %u us, link %u baud + %u us per transaction\n\n", trace.count, trace.motions[trace.count - 1].time_us / 1e6, master_pass_us, sensor_pass_us, link_baud, link_gap_us);
+    printf("%-13s %8s %8s %8s %8s %9s %8s %8s %8s %8s %8s %8s\n", "", "trans/s", "bytes/s", "link", "maccel/s", "reports/s", "onset ms", "age ms", "intv ms", "dt err", "max us", "lost");
+    for (sim_mode_t mode = MODE_QMK; mode <= MODE_SPLIT_RAW; mode++) {
+        // each with both halves fresh from reset
+        fflush(stdout);
+        const pid_t pid = fork();
+        if (pid == 0) {
+            pass_us = master_pass_us;
+            scan_us = pass_us * 2 / 5;
+            simulate(mode);
+            fflush(stdout);
+            exit(0);
+        }
+        int status;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            return 1;
+        }
+    }
+    free(trace.motions);
+    return 0;
+}
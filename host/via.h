@@ -0,0 +1,15 @@
+#pragma once
+#include "quantum.h"
+
+/* via.h: the command ids the profiler and the keycode cache dispatch on */
+enum via_command_id {
+    id_dynamic_keymap_get_keycode = 0x04,
+    id_dynamic_keymap_set_keycode = 0x05,
+    id_dynamic_keymap_reset       = 0x06,
+    id_custom_set_value           = 0x07,
+    id_custom_get_value           = 0x08,
+    id_custom_save                = 0x09,
+    id_eeprom_reset               = 0x0A,
+    id_dynamic_keymap_set_buffer  = 0x13,
+    id_unhandled                  = 0xFF,
+};
@@ -0,0 +1,144 @@
+/**
+ * Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "quantum.h"
+#include "layers.h"
+#include "indicators.h"
+
+#ifdef RGB_MATRIX_ENABLE
+
+/**
+ * \brief What each LED indicates, besides the layer color.
+ *
+ * Designated initializers, so an LED given two roles is an `-Woverride-init` error.
+ */
+enum indicator_role {
+    ROLE_LAYER = 0,  // layer color only
+    ROLE_MOD_COMBO,  // mixes shift (green), ctrl (red) and alt (blue), no layer color
+    ROLE_CAPS_LOCK,
+    ROLE_CAPS_WORD,
+    ROLE_SHIFT,      // also lit by gui
+    ROLE_CTRL,       // also lit by gui
+    ROLE_ALT,        // also lit by gui
+};
+
+// clang-format off
+static const uint8_t PROGMEM led_roles[RGB_MATRIX_LED_COUNT] = {
+    [7]  = ROLE_MOD_COMBO,  // 2nd top-outers
+    [36] = ROLE_MOD_COMBO,
+    [20] = ROLE_CAPS_LOCK,  // right-inner-top
+    [49] = ROLE_CAPS_LOCK,  // right-inner-top
+    [21] = ROLE_CAPS_WORD,  // inner-2nd, on the other half
+    [50] = ROLE_CAPS_WORD,  // left-inner-2nd
+    [51] = ROLE_CAPS_WORD,  // left-inner-3rd
+    [28] = ROLE_SHIFT,      // left-3rd-thumb
+    [54] = ROLE_SHIFT,      // right-2nd-thumb
+    [27] = ROLE_CTRL,       // left-2nd-thumb
+    [53] = ROLE_CTRL,       // right-1st-thumb
+    [26] = ROLE_ALT,        // left-1st-thumb
+    [55] = ROLE_ALT,        // right-bottom-thumb
+};
+
+/** Layer colors; black leaves the LED to the current effect. */
+static const uint8_t PROGMEM layer_colors[][3] = {
+    [LAYER_BASE]       = {RGB_BLACK},
+    [LAYER_NAVIGATION] = {RGB_CYAN},
+    [LAYER_POINTER]    = {RGB_YELLOW},
+    [LAYER_NUMERAL]    = {RGB_BLUE},
+    [LAYER_SYMBOLS]    = {RGB_CORAL},
+};
+// clang-format on
+
+/** Colors for the last state seen; black leaves the LED to the current effect. */
+static struct {
+    bool          valid;
+    layer_state_t layers;
+    uint8_t       mods;
+    bool          caps_lock;
+    bool          caps_word;
+    uint8_t       colors[RGB_MATRIX_LED_COUNT][3];
+} indicators;
+
+static void indicators_set(uint8_t *color, uint8_t r, uint8_t g, uint8_t b) {
+    color[0] = r;
+    color[1] = g;
+    color[2] = b;
+}
+
+static void indicators_update(uint8_t layer, uint8_t mods, bool caps_lock, bool caps_word) {
+    for (uint8_t led = 0; led < RGB_MATRIX_LED_COUNT; led++) {
+        uint8_t *color = indicators.colors[led];
+        switch (pgm_read_byte(&led_roles[led])) {
+            case ROLE_MOD_COMBO:
+                indicators_set(color, (mods & MOD_MASK_CTRL) ? 0xFF : 0, (mods & MOD_MASK_SHIFT) ? 0xFF : 0, (mods & MOD_MASK_ALT) ? 0xFF : 0);
+                continue;
+            case ROLE_CAPS_LOCK:
+                if (caps_lock) {
+                    indicators_set(color, RGB_WHITE);
+                    continue;
+                }
+                break;
+            case ROLE_CAPS_WORD:
+                if (caps_word) {
+                    indicators_set(color, RGB_WHITE);
+                    continue;
+                }
+                break;
+            case ROLE_SHIFT:
+                if (mods & (MOD_MASK_SHIFT | MOD_MASK_GUI)) {
+                    indicators_set(color, RGB_GREEN);
+                    continue;
+                }
+                break;
+            case ROLE_CTRL:
+                if (mods & (MOD_MASK_CTRL | MOD_MASK_GUI)) {
+                    indicators_set(color, RGB_RED);
+                    continue;
+                }
+                break;
+            case ROLE_ALT:
+                if (mods & (MOD_MASK_ALT | MOD_MASK_GUI)) {
+                    indicators_set(color, RGB_BLUE);
+                    continue;
+                }
+                break;
+        }
+        if (layer < ARRAY_SIZE(layer_colors)) {
+            indicators_set(color, pgm_read_byte(&layer_colors[layer][0]), pgm_read_byte(&layer_colors[layer][1]), pgm_read_byte(&layer_colors[layer][2]));
+        } else {
+            indicators_set(color, RGB_BLACK);
+        }
+    }
+}
+
+void indicators_render(uint8_t led_min, uint8_t led_max, layer_state_t layers, uint8_t mods, bool caps_lock, bool caps_word) {
+    if (!indicators.valid || layers != indicators.layers || mods != indicators.mods || caps_lock != indicators.caps_lock || caps_word != indicators.caps_word) {
+        indicators.valid     = true;
+        indicators.layers    = layers;
+        indicators.mods      = mods;
+        indicators.caps_lock = caps_lock;
+        indicators.caps_word = caps_word;
+        indicators_update(get_highest_layer(layers), mods, caps_lock, caps_word);
+    }
+    for (uint8_t led = led_min; led < led_max; led++) {
+        const uint8_t *color = indicators.colors[led];
+        if (color[0] | color[1] | color[2]) {
+            rgb_matrix_set_color(led, color[0], color[1], color[2]);
+        }
+    }
+}
+
+#endif // RGB_MATRIX_ENABLE
@@ -0,0 +1,28 @@
+/**
+ * Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * \brief Paint the layer, mod and caps indicators over LEDs `led_min..led_max-1`.
+ *
+ * Call from `rgb_matrix_indicators_advanced_user()` on every frame; colors are
+ * only recomputed when one of the arguments changed since the previous call.
+ */
+void indicators_render(uint8_t led_min, uint8_t led_max, layer_state_t layers, uint8_t mods, bool caps_lock, bool caps_word);
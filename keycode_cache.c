@@ -0,0 +1,180 @@
+/**
+ * Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "keycode_cache.h"
+#include "keymap_introspection.h"
+#ifdef VIA_ENABLE
+#    include "via.h"
+#endif
+
+#define KEYCODE_CACHE_NONE 0xFF // a position not resolved yet
+
+static struct {
+    bool          stale;                           // the keymap changed since the overlays were copied
+    layer_state_t state;                           // layers the entries were resolved for
+    uint8_t       layer[MATRIX_ROWS][MATRIX_COLS]; // where each position resolved
+    uint16_t      keycode[MATRIX_ROWS][MATRIX_COLS];
+} cache = {.stale = true};
+
+#if KEYCODE_CACHE_SPARSE_KEYS > 0
+static struct {
+    layer_state_t layers;                                            // overlays copied
+    matrix_row_t  opaque[KEYCODE_CACHE_SPARSE_LAYERS][MATRIX_ROWS];  // columns that are not `KC_TRNS`
+    matrix_row_t  none[KEYCODE_CACHE_SPARSE_LAYERS][MATRIX_ROWS];    // of those, the `KC_NO` ones
+    uint8_t       first[KEYCODE_CACHE_SPARSE_LAYERS][MATRIX_ROWS];   // index of each row's first in `keycodes`
+    uint16_t      keycodes[KEYCODE_CACHE_SPARSE_KEYS];               // all the others
+} sparse;
+
+// one layer's keys of their own after the `*count` already copied, unless they do not fit
+static bool keycode_cache_copy_layer(uint8_t layer, uint8_t *count) {
+    uint8_t next = *count;
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        sparse.opaque[layer][row] = 0;
+        sparse.none[layer][row]   = 0;
+        sparse.first[layer][row]  = next;
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            const uint16_t keycode = keycode_at_keymap_location(layer, row, col);
+            if (keycode == KC_TRNS) {
+                continue;
+            }
+            sparse.opaque[layer][row] |= (matrix_row_t)1 << col;
+            if (keycode == KC_NO) {
+                sparse.none[layer][row] |= (matrix_row_t)1 << col;
+                continue;
+            }
+            if (next == KEYCODE_CACHE_SPARSE_KEYS) {
+                return false;
+            }
+            sparse.keycodes[next++] = keycode;
+        }
+    }
+    *count = next;
+    return true;
+}
+
+static void keycode_cache_copy(void) {
+    const uint8_t layers = keymap_layer_count() < KEYCODE_CACHE_SPARSE_LAYERS ? keymap_layer_count() : KEYCODE_CACHE_SPARSE_LAYERS;
+    uint8_t       count  = 0;
+    sparse.layers        = 0;
+    for (uint8_t layer = 1; layer < layers; layer++) {
+        if (keycode_cache_copy_layer(layer, &count)) {
+            sparse.layers |= (layer_state_t)1 << layer;
+        }
+    }
+}
+#endif // KEYCODE_CACHE_SPARSE_KEYS
+
+static uint16_t keycode_cache_read(uint8_t layer, uint8_t row, uint8_t col) {
+#if KEYCODE_CACHE_SPARSE_KEYS > 0
+    if (layer < KEYCODE_CACHE_SPARSE_LAYERS && (sparse.layers & ((layer_state_t)1 << layer))) {
+        const matrix_row_t bit = (matrix_row_t)1 << col;
+        if (!(sparse.opaque[layer][row] & bit)) {
+            return KC_TRNS;
+        }
+        if (sparse.none[layer][row] & bit) {
+            return KC_NO;
+        }
+        // after the row's stored keys to the left, a few at most
+        uint8_t index = sparse.first[layer][row];
+        for (matrix_row_t left = sparse.opaque[layer][row] & ~sparse.none[layer][row] & (bit - 1); left; left &= left - 1) {
+            index++;
+        }
+        return sparse.keycodes[index];
+    }
+#endif
+    return keycode_at_keymap_location(layer, row, col);
+}
+
+// as QMK's `layer_switch_get_layer()` walks the layers, once
+static void keycode_cache_resolve(uint8_t row, uint8_t col) {
+    for (int8_t layer = get_highest_layer(cache.state); layer >= 0; layer--) {
+        if (cache.state & ((layer_state_t)1 << layer)) {
+            const uint16_t keycode = keycode_cache_read(layer, row, col);
+            if (keycode != KC_TRNS) {
+                cache.layer[row][col]   = layer;
+                cache.keycode[row][col] = keycode;
+                return;
+            }
+        }
+    }
+    // transparent all the way down: left unresolved, as QMK then reads the default layer
+}
+
+// entries hold for any layers, only the walk over others would no longer find them
+static void keycode_cache_check(void) {
+    const layer_state_t state = layer_state | default_layer_state;
+    if (cache.stale) {
+#if KEYCODE_CACHE_SPARSE_KEYS > 0
+        keycode_cache_copy();
+#endif
+        cache.stale = false;
+    } else if (state == cache.state) {
+        return;
+    }
+    cache.state = state;
+    memset(cache.layer, KEYCODE_CACHE_NONE, sizeof(cache.layer));
+}
+
+// in place of QMK's weak one, which this one defers to for all but the walk's reads
+uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key) {
+    if (key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS) {
+#if defined(ENCODER_ENABLE) && defined(ENCODER_MAP_ENABLE)
+        if (key.row == KEYLOC_ENCODER_CW && key.col < NUM_ENCODERS) {
+            return keycode_at_encodermap_location(layer, key.col, true);
+        }
+        if (key.row == KEYLOC_ENCODER_CCW && key.col < NUM_ENCODERS) {
+            return keycode_at_encodermap_location(layer, key.col, false);
+        }
+#endif
+        return KC_NO;
+    }
+    keycode_cache_check();
+    if (cache.layer[key.row][key.col] == KEYCODE_CACHE_NONE) {
+        keycode_cache_resolve(key.row, key.col);
+    }
+    const uint8_t resolved = cache.layer[key.row][key.col];
+    if (layer == resolved) {
+        return cache.keycode[key.row][key.col];
+    }
+    // the walk passed through every active layer above without finding a keycode
+    if (layer > resolved && resolved != KEYCODE_CACHE_NONE && (cache.state & ((layer_state_t)1 << layer))) {
+        return KC_TRNS;
+    }
+    return keycode_cache_read(layer, key.row, key.col);
+}
+
+void keycode_cache_init(void) {
+    keycode_cache_check();
+}
+
+void keycode_cache_keymap_changed(void) {
+    cache.stale = true;
+}
+
+#ifdef VIA_ENABLE
+// before VIA handles a command; the next key event copies the edited keymap
+bool via_command_kb(uint8_t *data, uint8_t length) {
+    switch (data[0]) {
+        case id_dynamic_keymap_set_keycode:
+        case id_dynamic_keymap_reset:
+        case id_dynamic_keymap_set_buffer:
+        case id_eeprom_reset:
+            keycode_cache_keymap_changed();
+            break;
+    }
+    return false;
+}
+#endif // VIA_ENABLE
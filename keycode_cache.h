@@ -0,0 +1,58 @@
+/**
+ * Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "quantum.h"
+
+/**
+ * \brief Resolved keycodes per matrix position, and overlay layers kept sparsely.
+ *
+ * For each key event QMK walks the active layers from the top, reading the keymap (VIA's
+ * EEPROM copy, with VIA) at every one until it is not transparent, then reads that layer's
+ * keycode once more.  All those reads go through `keymap_key_to_keycode()`, which this
+ * overrides: the first read of a position resolves it through the layers once and keeps
+ * the layer and keycode found, and the walk's reads are answered from that, the keycode at
+ * its layer and `KC_TRNS` at the active layers above.  Other reads, e.g. of the layer a
+ * release was pressed on, go to the keymap.  Entries are dropped when `layer_state` or
+ * `default_layer_state` is no longer what they were resolved for, so nothing needs to be
+ * told about layer changes, and when the keymap is edited over VIA.
+ *
+ * Overlay layers, all but layer 0, are mostly `KC_TRNS` and `KC_NO`.  With
+ * `KEYCODE_CACHE_SPARSE_KEYS`, resolving reads them from RAM instead, where per row only a
+ * mask of the columns that are not transparent, a mask of those that are `KC_NO`, and the
+ * other keycodes are copied.  The copy is made at startup and again after VIA edits; a layer
+ * it has no room left for is read from the keymap as before.
+ *
+ * It only pays where a keymap read is dear.  `host/keycode_cache_test` has it reading a third
+ * as often but taking longer per event than the walk on a keymap in RAM, which is where
+ * RP2040's wear-leveled EEPROM keeps VIA's, so it is off by default (`rules.mk`) until a
+ * press-to-action measurement on the keyboard shows it ahead.
+ */
+
+#ifndef KEYCODE_CACHE_SPARSE_KEYS
+#    define KEYCODE_CACHE_SPARSE_KEYS 128 // overlay keycodes other than KC_TRNS and KC_NO in RAM, 0 for none
+#endif
+#ifndef KEYCODE_CACHE_SPARSE_LAYERS
+#    define KEYCODE_CACHE_SPARSE_LAYERS 8 // layers below this can have a sparse copy
+#endif
+_Static_assert(KEYCODE_CACHE_SPARSE_KEYS <= UINT8_MAX, "KEYCODE_CACHE_SPARSE_KEYS out of range");
+_Static_assert(KEYCODE_CACHE_SPARSE_LAYERS <= sizeof(layer_state_t) * 8, "KEYCODE_CACHE_SPARSE_LAYERS out of range");
+
+/** From `keyboard_post_init_user()`: copy the overlays now rather than on the first key event. */
+void keycode_cache_init(void);
+/** The keymap was changed other than over VIA's keymap commands, which are caught here. */
+void keycode_cache_keymap_changed(void);
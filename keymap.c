@@ -15,6 +15,28 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include QMK_KEYBOARD_H
+#ifdef SPLIT_TRANSACTION_IDS_USER
+#    include "transactions.h"
+#endif
+#ifdef MACCEL_ENABLE
+#    include "maccel/maccel.h"
+#endif
+#ifdef RGB_MATRIX_ENABLE
+#    include "indicators.h"
+#endif
+#include "profiler.h"
+#ifdef POINTING_SCHEDULER_ENABLE
+#    include "pointing_scheduler.h"
+#endif
+#ifdef LOCK_CHORDS_ENABLE
+#    include "lock_chords.h"
+#endif
+#ifdef KEYCODE_CACHE_ENABLE
+#    include "keycode_cache.h"
+#endif
+#ifdef SPLIT_MOTION_ENABLE
+#    include "split_motion.h"
+#endif
 
 
 /**
@@ -28,13 +50,7 @@
  * - Swap right hand BTN1 and BTN2
  */
 
-enum charybdis_keymap_layers {
-    LAYER_BASE = 0,
-    LAYER_NAVIGATION,
-    LAYER_POINTER,
-    LAYER_NUMERAL,
-    LAYER_SYMBOLS
-};
+#include "layers.h"
 
 #define SPC_NAV LT(LAYER_NAVIGATION, KC_SPC)
 #define TAB_PTR LT(LAYER_POINTER, KC_TAB)
@@ -45,15 +61,6 @@ enum charybdis_keymap_layers {
 #define ALT_SCL MT(MOD_RALT, KC_SCLN)
 #define CTL_EQL MT(MOD_RCTL, KC_EQL)
 
-#ifdef COMBO_ENABLE
-const uint16_t PROGMEM combo_layer_lock_med[] = {ESC_MED, CW_TOGG, COMBO_END};
-const uint16_t PROGMEM combo_layer_lock_nav[] = {SPC_NAV, CW_TOGG, COMBO_END};
-const uint16_t PROGMEM combo_layer_lock_ptr[] = {TAB_PTR, CW_TOGG, COMBO_END};
-const uint16_t PROGMEM combo_layer_lock_fun[] = {DEL_FUN, KC_CAPS, COMBO_END};
-const uint16_t PROGMEM combo_layer_lock_num[] = {BSP_NUM, KC_CAPS, COMBO_END};
-const uint16_t PROGMEM combo_layer_lock_sym[] = {ENT_SYM, KC_CAPS, COMBO_END};
-#endif
-
 #ifndef POINTING_DEVICE_ENABLE
 #    define DRGSCRL KC_NO
 #    define DPI_MOD KC_NO
@@ -87,7 +94,7 @@ const uint16_t PROGMEM combo_layer_lock_sym[] = {ENT_SYM, KC_CAPS, COMBO_END};
 #define LAYOUT_LAYER_BASE                                                                              \
      KC_APP,   KC_Q,   KC_W,   KC_F,   KC_P,   KC_B,     KC_J,   KC_L,   KC_U,   KC_Y,KC_QUOT,KC_DEL, \
     KC_F5,   KC_A,   KC_R,   KC_S,   KC_T,   KC_G,     KC_M,   KC_N,   KC_E,   KC_I,   KC_O,KC_SCLN, \
-    XXXXXXX,   KC_Z,   KC_X,   KC_C,   KC_D,   KC_V,     KC_K,   KC_H,KC_MINS,LA2_PTR,KC_DOT,CW_TOGG, \
+    KC_CAPS,   KC_Z,   KC_X,   KC_C,   KC_D,   KC_V,     KC_K,   KC_H,KC_MINS,LA2_PTR,KC_DOT,CW_TOGG, \
                             KC_ESC,SPC_NAV,TAB_PTR,                                  ENT_SYM,BSP_NUM
 
 /** Convenience row shorthands. */
@@ -177,29 +184,45 @@ const uint16_t PROGMEM combo_layer_lock_sym[] = {ENT_SYM, KC_CAPS, COMBO_END};
     _______,KC_TILD,KC_EXLM,  KC_AT,KC_HASH,KC_PIPE,   KC_CUT,KC_COPY,KC_UNDERSCORE,KC_LEFT_ANGLE_BRACKET, KC_RIGHT_ANGLE_BRACKET,_______, \
                             KC_LPRN,KC_RPRN,KC_QUES,                                  _______,KC_BSPC
 
+/** Tapping terms of the home row mods, per finger. */
+#define TAPPING_TERM_PINKY (TAPPING_TERM + 130)  // Compensate for weaker little fingers
+#define TAPPING_TERM_HRM (TAPPING_TERM + 20)     // Compensate for homerow mods
+
 /**
  * \brief Add Home Row mod to a layout.
  *
- * Expects a 12-key per row layout, at least x3 rows (at least 36 keycodes).
+ * Expects a 12-key per row layout, x3 rows plus 5 thumbs (41 keycodes).
  * Adds support for GACS (Gui, Alt, Ctl, Shift) home row.
  *
- * This is meant to be used with `LAYER_ALPHAS_QWERTY` defined above, eg.:
+ * This is meant to be used with `LAYOUT_LAYER_BASE` defined above, eg.:
+ *
+ *     HOME_ROW_MOD_GACS(LAYOUT_LAYER_BASE)
  *
- *     HOME_ROW_MOD_GACS(LAYER_ALPHAS_QWERTY)
+ * The same macro, through `HOME_ROW_MOD_GACS_TERMS()`, lays out the tapping term
+ * of each mod (0 elsewhere) for `get_tapping_term()`, so the two cannot drift apart.
+ * `K(key)` passes a key through, `M(mod_tap, term, key)` wraps it in a mod-tap.
  */
-#define _HOME_ROW_MOD_GACS(                                                     \
-    L00, L01, L02, L03, L04, L05, R06, R07, R08, R09, R10, R11,                 \
-    L12, L13, L14, L15, L16, L17, R18, R19, R20, R21, R22, R23,                 \
-    L24, L25, L26, L27, L28, L29, R30, R31, R32, R33, R34, R35,                 \
-    ...)                                                                        \
-          L00,         L01,         L02,         L03,         L04,         L05, \
-          R06,         R07,         R08,         R09,         R10,         R11, \
-          L12,         L13,         L14,         L15,         L16,         L17, \
-          R18,         R19,         R20,         R21,         R22,         R23, \
-          L24, LGUI_T(L25), LALT_T(L26), LCTL_T(L27), LSFT_T(L28),         L29, \
-          R30, RSFT_T(R31), RCTL_T(R32),         R33, LALT_T(R34),         R35, \
-    __VA_ARGS__
-#define HOME_ROW_MOD_GACS(...) _HOME_ROW_MOD_GACS(__VA_ARGS__)
+#define _HOME_ROW_MOD_GACS(K, M,                                                                    \
+    L00, L01, L02, L03, L04, L05, R06, R07, R08, R09, R10, R11,                                     \
+    L12, L13, L14, L15, L16, L17, R18, R19, R20, R21, R22, R23,                                     \
+    L24, L25, L26, L27, L28, L29, R30, R31, R32, R33, R34, R35,                                     \
+    T36, T37, T38, T39, T40)                                                                        \
+    K(L00), K(L01), K(L02), K(L03), K(L04), K(L05), K(R06), K(R07), K(R08), K(R09), K(R10), K(R11), \
+    K(L12), K(L13), K(L14), K(L15), K(L16), K(L17), K(R18), K(R19), K(R20), K(R21), K(R22), K(R23), \
+    K(L24), M(LGUI_T, TAPPING_TERM_PINKY, L25), M(LALT_T, TAPPING_TERM_HRM, L26),                   \
+            M(LCTL_T, TAPPING_TERM_HRM, L27), M(LSFT_T, TAPPING_TERM_HRM, L28), K(L29),             \
+    K(R30), M(RSFT_T, TAPPING_TERM_HRM, R31), M(RCTL_T, TAPPING_TERM_HRM, R32),                     \
+            K(R33), M(LALT_T, TAPPING_TERM_PINKY, R34), K(R35),                                     \
+    K(T36), K(T37), K(T38), K(T39), K(T40)
+
+#define _HRM_KEY(key) key
+#define _HRM_MOD_TAP(mod_tap, term, key) mod_tap(key)
+#define _HRM_NO_TERM(key) 0
+// a mod-tap only carries a basic keycode, anything else would silently lose its layer/mods
+#define _HRM_TERM(mod_tap, term, key) ((term) + 0 * sizeof(char[(key) <= 0xFF ? 1 : -1]))
+
+#define HOME_ROW_MOD_GACS(...) _HOME_ROW_MOD_GACS(_HRM_KEY, _HRM_MOD_TAP, __VA_ARGS__)
+#define HOME_ROW_MOD_GACS_TERMS(...) _HOME_ROW_MOD_GACS(_HRM_NO_TERM, _HRM_TERM, __VA_ARGS__)
 
 #define LAYOUT_wrapper(...) LAYOUT(__VA_ARGS__)
 
@@ -218,27 +241,194 @@ const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
   [LAYER_POINTER] = LAYOUT_wrapper(LAYOUT_LAYER_POINTER),
   [LAYER_SYMBOLS] = LAYOUT_wrapper(LAYOUT_LAYER_SYMBOLS),
 };
+
+#ifdef DYNAMIC_KEYMAP_LAYER_COUNT
+_Static_assert(ARRAY_SIZE(keymaps) == DYNAMIC_KEYMAP_LAYER_COUNT, "VIA's EEPROM keymap should have as many layers as `keymaps`");
+#endif
+
+/** Tapping term of each base-layer home row mod by matrix position, 0 elsewhere. */
+static const uint16_t PROGMEM tapping_terms[MATRIX_ROWS][MATRIX_COLS] = LAYOUT_wrapper(HOME_ROW_MOD_GACS_TERMS(LAYOUT_LAYER_BASE));
+
+#ifdef LOCK_CHORDS_ENABLE
+/**
+ * \brief Layer locks: hold a layer-tap thumb and tap the outer pinky key of the other hand,
+ * `CW_TOGG` for the left thumbs, `KC_CAPS` for `ENT_SYM` and the `KC_F5` above it for
+ * `BSP_NUM`; again to unlock.
+ *
+ * Partners match by position on whatever layer is up, so each must be transparent on its
+ * thumb's layer: the numeral layer has its Backspace where `KC_CAPS` is.
+ */
+enum lock_chord_keys {
+    CHORD_CAPS = 1 << 0,
+    CHORD_CWRD = 1 << 1,
+    CHORD_NAV  = 1 << 2,
+    CHORD_PTR  = 1 << 3,
+    CHORD_SYM  = 1 << 4,
+    CHORD_NUM  = 1 << 5,
+    CHORD_F5   = 1 << 6,
+};
+
+const uint8_t PROGMEM lock_chord_members[MATRIX_ROWS][MATRIX_COLS] = LAYOUT_wrapper(
+             0,      0,      0,      0,      0,      0,        0,      0,      0,      0,      0,      0,
+      CHORD_F5,      0,      0,      0,      0,      0,        0,      0,      0,      0,      0,      0,
+    CHORD_CAPS,      0,      0,      0,      0,      0,        0,      0,      0,      0,      0,CHORD_CWRD,
+                                     0,CHORD_NAV,CHORD_PTR,                            CHORD_SYM,CHORD_NUM);
+
+const uint8_t PROGMEM lock_chord_layers[1 << LOCK_CHORD_KEYS] = {
+    [CHORD_NAV | CHORD_CWRD] = LOCK_CHORD_LAYER(LAYER_NAVIGATION),
+    [CHORD_PTR | CHORD_CWRD] = LOCK_CHORD_LAYER(LAYER_POINTER),
+    [CHORD_SYM | CHORD_CAPS] = LOCK_CHORD_LAYER(LAYER_SYMBOLS),
+    [CHORD_NUM | CHORD_F5]   = LOCK_CHORD_LAYER(LAYER_NUMERAL),
+};
+
+const uint8_t lock_chord_partners = CHORD_CAPS | CHORD_CWRD | CHORD_F5;
+
+bool pre_process_record_user(uint16_t keycode, keyrecord_t *record) {
+    return lock_chords_pre_process(record);
+}
+#endif // LOCK_CHORDS_ENABLE
 // clang-format on
 
 uint16_t get_tapping_term(uint16_t keycode, keyrecord_t *record) {
-    switch (keycode) {
-        case LGUI_T(KC_A):
-        case RGUI_T(KC_O):
-            // Compensate for weaker little fingers
-            return TAPPING_TERM+130;
-        case LALT_T(KC_R):
-        case LCTL_T(KC_S):
-        case LSFT_T(KC_T):
-        case RALT_T(KC_I):
-        case RCTL_T(KC_E):
-        case RSFT_T(KC_N):
-            // Compensate for homerow mods
-            return TAPPING_TERM+20;
-        default:
-            return TAPPING_TERM;
+    const keypos_t key = record->event.key;
+    // combos and other virtual keys have no matrix position
+    if (key.row < MATRIX_ROWS && key.col < MATRIX_COLS) {
+        const uint16_t term = pgm_read_word(&tapping_terms[key.row][key.col]);
+        // only for the mod itself, not whatever another layer (or VIA) put there
+        if (term && keycode == pgm_read_word(&keymaps[LAYER_BASE][key.row][key.col])) {
+            return term;
+        }
     }
+    return TAPPING_TERM;
 }
 
+/**
+ * \brief State the RGB indicators need from both halves.
+ *
+ * Layers, mods, caps-lock and caps-word travel together in one small packet over a
+ * single split transaction, instead of QMK's separate layer, mods and led-state syncs
+ * (which also never shared caps-word).  The master half sends it only when something
+ * changed, plus a heartbeat every `USER_SYNC_HEARTBEAT_MS` in case the other half
+ * missed one or rebooted.  maccel's profile, for the trackball half, goes with its
+ * motion polls instead (`split_motion.h`).
+ */
+#ifndef USER_SYNC_HEARTBEAT_MS
+#    define USER_SYNC_HEARTBEAT_MS 250
+#endif
+
+typedef struct __attribute__((packed)) {
+    layer_state_t layer_state;
+    layer_state_t default_layer_state;
+    uint8_t       mods;
+    uint8_t       flags;
+} user_state_t;
+
+enum user_state_flags {
+    USER_STATE_CAPS_LOCK = 1 << 0,
+    USER_STATE_CAPS_WORD = 1 << 1,
+};
+
+/** On the master half collected from its own state, on the other from the last packet. */
+static user_state_t user_state;
+
+static void user_state_collect(void) {
+    user_state.layer_state         = layer_state;
+    user_state.default_layer_state = default_layer_state;
+    user_state.mods                = get_mods();
+    user_state.flags               = host_keyboard_led_state().caps_lock ? USER_STATE_CAPS_LOCK : 0;
+#ifdef CAPS_WORD_ENABLE
+    if (is_caps_word_on()) {
+        user_state.flags |= USER_STATE_CAPS_WORD;
+    }
+#endif
+}
+
+#ifdef SPLIT_TRANSACTION_IDS_USER
+static void user_state_sync_slave_handler(uint8_t in_buflen, const void *in_data, uint8_t out_buflen, void *out_data) {
+    if (in_buflen != sizeof(user_state)) {
+        return;
+    }
+    memcpy(&user_state, in_data, sizeof(user_state));
+    // stand in for the split syncs this replaces
+    layer_state         = user_state.layer_state;
+    default_layer_state = user_state.default_layer_state;
+    set_mods(user_state.mods);
+}
+#endif // SPLIT_TRANSACTION_IDS_USER
+
+static void user_state_task(void) {
+    if (!is_keyboard_master()) {
+        return;
+    }
+    user_state_collect();
+#ifdef SPLIT_TRANSACTION_IDS_USER
+    static user_state_t last_sent;
+    static uint32_t     last_sync;
+    static bool         synced = false;
+    if (!is_transport_connected()) {
+        synced = false;
+        return;
+    }
+    if (synced && memcmp(&user_state, &last_sent, sizeof(user_state)) == 0 && timer_elapsed32(last_sync) < USER_SYNC_HEARTBEAT_MS) {
+        return;
+    }
+    if (transaction_rpc_send(USER_SYNC_STATE, sizeof(user_state), &user_state)) {
+        last_sent = user_state;
+        last_sync = timer_read32();
+        synced    = true;
+    }
+#endif // SPLIT_TRANSACTION_IDS_USER
+}
+
+void housekeeping_task_user(void) {
+    PROFILE_MARK(PROFILE_SPLIT);
+    user_state_task();
+#ifdef SPLIT_MOTION_ENABLE
+    split_motion_task();
+#endif
+    PROFILE_MARK(PROFILE_HOUSEKEEPING);
+#ifdef MACCEL_ENABLE
+    housekeeping_task_maccel();
+#endif
+#ifdef PROFILER_ENABLE
+    profiler_task();
+#endif
+#ifdef PMW33XX_ASYNC_ENABLE
+    // the sensor is read while the next pass scans the matrix
+    pointing_scheduler_prefetch();
+#endif
+    // the loop starts over with the matrix scan
+    PROFILE_MARK(PROFILE_SCAN);
+}
+
+#if defined(PROFILER_ENABLE) || defined(PMW33XX_ASYNC_ENABLE)
+// called at the end of the scan, before its key events are processed
+void matrix_scan_user(void) {
+    PROFILE_MARK(PROFILE_KEYS);
+#    ifdef PMW33XX_ASYNC_ENABLE
+    pointing_scheduler_advance();
+#    endif
+}
+#endif
+
+#if defined(SPLIT_MOTION_ENABLE) && defined(PMW33XX_ASYNC_ENABLE)
+// the same, on the half that is not master, where the sensor may be
+void matrix_slave_scan_user(void) {
+    pointing_scheduler_advance();
+}
+#endif
+
+#ifdef PROFILER_ENABLE
+#    ifdef VIA_ENABLE
+// maccel's VIA handler passes on the channels it does not know
+void via_custom_value_command_user(uint8_t *data, uint8_t length) {
+    if (!profiler_via_command(data, length)) {
+        data[0] = id_unhandled;
+    }
+}
+#    endif // VIA_ENABLE
+#endif     // PROFILER_ENABLE
+
 // Enable debugging
 // https://github.com/qmk/qmk_firmware/blob/master/docs/faq_debug.md
 void keyboard_post_init_user(void) {
@@ -247,28 +437,22 @@ void keyboard_post_init_user(void) {
   debug_matrix=false;
   debug_keyboard=false;
   //debug_mouse=true;
+#ifdef PROFILER_ENABLE
+    profiler_init();
+#endif
 #ifdef MACCEL_ENABLE
     keyboard_post_init_maccel();
 #endif
-}
-
-#ifdef COMBO_ENABLE
-/*
-combo_t key_combos[] = {
-    COMBO(combo_layer_lock_nav, TG(LAYER_NAVIGATION)),
-    COMBO(combo_layer_lock_ptr, TG(LAYER_POINTER)),
-    COMBO(combo_layer_lock_fun, TG(LAYER_FUNCTION)),
-    COMBO(combo_layer_lock_num, TG(LAYER_NUMERAL)),
-    COMBO(combo_layer_lock_sym, TG(LAYER_SYMBOLS)),
-};
-*/
-combo_t key_combos[] = {
-    COMBO(combo_layer_lock_nav, TG(LAYER_NAVIGATION)),
-    COMBO(combo_layer_lock_ptr, TG(LAYER_POINTER)),
-    COMBO(combo_layer_lock_num, TG(LAYER_NUMERAL)),
-    COMBO(combo_layer_lock_sym, TG(LAYER_SYMBOLS)),
-};
+#ifdef KEYCODE_CACHE_ENABLE
+    keycode_cache_init();
+#endif
+#ifdef SPLIT_TRANSACTION_IDS_USER
+    transaction_register_rpc(USER_SYNC_STATE, user_state_sync_slave_handler);
+#endif
+#ifdef SPLIT_MOTION_ENABLE
+    split_motion_init();
 #endif
+}
 
 /*
 bool caps_word_press_user(uint16_t keycode) {
@@ -331,158 +515,189 @@ bool caps_word_press_user(uint16_t keycode) {
 // #define MACCEL_OFFSET   2.2   // --/++ growth kicks in earlier/later
 // #define MACCEL_LIMIT    6.0   // maximum acceleration factor
 
-// To view mouse's distance/velocity while configuring maccel,
-// set `CONSOLE_ENABLE = yes` in `rules.mk` and uncomment the lines below,
-// and run `qmk console` in the shell:
+// To view mouse's distance/velocity while configuring maccel, set
+// `MACCEL_TELEMETRY_ENABLE = yes` and `CONSOLE_ENABLE = yes` in `rules.mk`, run
+// `qmk console` in the shell and decode its `MX:` lines with `maccel_trace_decode -x`.
+// For maccel's other console output, uncomment the lines below:
 // #define MACCEL_DEBUG
 // #undef PRINTF_SUPPORT_DECIMAL_SPECIFIERS
 // #define PRINTF_SUPPORT_DECIMAL_SPECIFIERS 1
 
 
-#   include "maccel/maccel.h"
-
 report_mouse_t pointing_device_task_user(report_mouse_t mouse_report) {
-    return pointing_device_task_maccel(mouse_report);
+    PROFILE_MARK(PROFILE_POINTING);
+#ifdef SPLIT_MOTION_ENABLE
+    if (!is_keyboard_master()) {
+        // the trackball half, without USB: the master polls its motion
+        return split_motion_send(mouse_report);
+    }
+#endif
+#ifdef POINTING_SCHEDULER_ENABLE
+    // between USB frames motion is held back, and QMK sends no report without any
+    if (pointing_scheduler_coalesce(&mouse_report)) {
+#    ifdef SPLIT_MOTION_ENABLE
+        // the trackball half's, if it is the other one, goes out with the frame too
+        if (split_motion_take(&mouse_report)) {
+            PROFILE_MARK(PROFILE_SEND);
+            return mouse_report;
+        }
+#    endif
+        mouse_report = pointing_device_task_maccel(mouse_report);
+    }
+#else
+    mouse_report = pointing_device_task_maccel(mouse_report);
+#endif
+    PROFILE_MARK(PROFILE_SEND);
+    return mouse_report;
+}
+
+#ifdef POINTING_DEVICE_ENABLE
+/**
+ * \brief Pick the maccel profile (see `config.h`) for the pointer's current use.
+ *
+ * Sniping and the navigation layer, where the pointer selects text, get the
+ * precise curve; the pointer layer the one for long throws.  maccel keeps all
+ * curves computed, so this is only a pointer swap and runs on every change.
+ */
+static void maccel_profile_update(layer_state_t state) {
+    uint8_t profile = MACCEL_PROFILE_POINTING;
+    if (charybdis_get_pointer_sniping_enabled()) {
+        profile = MACCEL_PROFILE_PRECISE;
+    } else {
+        switch (get_highest_layer(state)) {
+            case LAYER_NAVIGATION:
+                profile = MACCEL_PROFILE_PRECISE;
+                break;
+            case LAYER_POINTER:
+                profile = MACCEL_PROFILE_TRAVEL;
+                break;
+        }
+    }
+    maccel_profile_select(profile);
+}
+
+layer_state_t layer_state_set_user(layer_state_t state) {
+    maccel_profile_update(state);
+    return state;
+}
+
+void post_process_record_user(uint16_t keycode, keyrecord_t *record) {
+    switch (keycode) {
+        case SNIPING:
+        case SNP_TOG:
+            // charybdis has switched sniping by now
+            maccel_profile_update(layer_state);
+            break;
+    }
+}
+#endif // POINTING_DEVICE_ENABLE
+
+#if defined(MACCEL_USE_DRAGSCROLL) && defined(POINTING_DEVICE_HIRES_SCROLL_ENABLE) && defined(OS_DETECTION_ENABLE)
+/**
+ * Drag-scroll in fractions of a detent only on hosts that apply the resolution multiplier:
+ * Linux and Windows do, macOS and iOS would take every fraction for a whole detent.  Until
+ * the host is known, whole detents.
+ */
+uint16_t maccel_dragscroll_resolution(void) {
+    switch (detected_host_os()) {
+        case OS_LINUX:
+        case OS_WINDOWS:
+            return pointing_device_get_hires_scroll_resolution();
+        default:
+            return 1;
+    }
 }
+#endif
+#endif  // MACCEL_ENABLE
 
 enum my_keycodes {
     MA_TAKEOFF = QK_USER,   // mouse acceleration curve takeoff (initial acceleration) step key
     MA_GROWTH_RATE,              // mouse acceleration curve growth rate step key
     MA_OFFSET,              // mouse acceleration curve offset step key
     MA_LIMIT,               // mouse acceleration curve limit step key
+    MA_TRACE,               // start/stop recording trackball motion (`MACCEL_TRACE_ENABLE`)
+    MA_PROFILE,             // cycle a forced maccel profile, then back to automatic
+    PF_DUMP,                // print the main loop profile to the console (`PROFILER_ENABLE`)
 };
 
 bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+#ifdef LOCK_CHORDS_ENABLE
+    if (!lock_chords_process(keycode, record)) {
+        return false;
+    }
+#endif
+#ifdef MACCEL_ENABLE
     if (!process_record_maccel(keycode, record, MA_TAKEOFF, MA_GROWTH_RATE, MA_OFFSET, MA_LIMIT)) {
         return false;
     }
+#    ifdef POINTING_DEVICE_ENABLE
+    switch (keycode) {
+#        ifdef MACCEL_USE_DRAGSCROLL
+        // drag-scroll by maccel instead of charybdis, which also leaves the DPI alone
+        case DRGSCRL:
+            maccel_dragscroll_enable(record->event.pressed);
+            return false;
+        case DRG_TOG:
+            if (record->event.pressed) {
+                maccel_dragscroll_toggle();
+            }
+            return false;
+#        else
+        case DRGSCRL:
+        case DRG_TOG:
+#        endif // MACCEL_USE_DRAGSCROLL
+        case DPI_MOD:
+        case DPI_RMOD:
+        case S_D_MOD:
+        case S_D_RMOD:
+        case SNIPING:
+        case SNP_TOG:
+            // charybdis applies the new DPI right after us; maccel re-reads it from housekeeping
+            maccel_cpi_changed();
+            break;
+    }
+#    endif // POINTING_DEVICE_ENABLE
+    if (keycode == MA_PROFILE) {
+        if (record->event.pressed) {
+            const uint8_t forced = maccel_profile_get_override();
+            const uint8_t next   = forced == MACCEL_PROFILE_NONE ? 0 : forced + 1;
+            maccel_profile_override(next < MACCEL_PROFILE_COUNT ? next : MACCEL_PROFILE_NONE);
+        }
+        return false;
+    }
+#endif // MACCEL_ENABLE
+#ifdef PROFILER_ENABLE
+    if (keycode == PF_DUMP) {
+        if (record->event.pressed) {
+            profiler_dump();
+        }
+        return false;
+    }
+#endif
+#ifdef MACCEL_TRACE_ENABLE
+    if (keycode == MA_TRACE) {
+        if (record->event.pressed) {
+            maccel_trace_toggle();
+        }
+        return false;
+    }
+#endif
     /* insert your own macros here */
     return true;
 }
-#endif  // MACCEL_ENABLE
 
 
 #ifdef RGB_MATRIX_ENABLE
-// Forward-declare this helper function since it is defined in
-// rgb_matrix.c.
-void rgb_matrix_update_pwm_buffers(void);
-
 /**
+ * Layer, mod and caps indicators, see `indicators.c` for which LED shows what.
  *
- * Led indices for RGBs.
- * C-strings so 0 cannot set the color of the 1st led.
- *
- * Indicate *caps-states* with top-inner keys
- * (left-side works only if `SPLIT_LAYER_STATE_ENABLE`)
+ * Both halves paint from `user_state`, so the half without the USB connection
+ * shows caps-word too.
  */
-const int8_t caps_lock_leds[] = {
-    20, // right-inner-top
-    49, // right-inner-top
-    -1
-};
-const int8_t caps_word_leds[] = {
-    //21, // NOT WORKING, caps-word state not shared!
-    50, // left-inner-2nd
-    51, // left-inner-3rd
-    -1
-};
-
-const int8_t mod_shift_leds[] = {
-    28, // left-3rd-thumb
-    54, // right-2nd-thumb
-    -1
-};
-const int8_t mod_ctrl_leds[] = {
-    27, // left-2nd-thumb
-    53, // right-1st-thumb
-    -1
-};
-const int8_t mod_alt_leds[] = {
-    26, // left-1st-thumb
-    55, // right-bottom-thumb
-    -1
-};
-
-bool inarray(const int8_t *arr, int8_t led) {
-    while (*arr != -1 && *arr != led) arr++;
-    return *arr == led;
-}
-
-void rgb_matrix_colorify_led(uint8_t led, uint8_t mods, bool caps_lock, bool caps_word) {
-    RGB color = { 0, 0, 0 };
-    bool color_set = false;
-
-    void set_color(int r, int g, int b) {
-        color.r = r;
-        color.g = g;
-        color.b = b;
-        color_set = true;
-    }
-
-    if (led == 7 || led == 36) {  // 2nd top-outers combine mod colors
-        if (mods & MOD_MASK_SHIFT) {
-            color.g = 0xff;
-            color_set = true;
-        }
-        if (mods & MOD_MASK_CTRL) {
-            color.r = 0xff;
-            color_set = true;
-        }
-        if (mods & MOD_MASK_ALT) {
-            color.b = 0xff;
-            color_set = true;
-        }
-    } else if (caps_lock && inarray(caps_lock_leds, led)) {
-        set_color(RGB_WHITE);
-    }
-    else if (caps_word && inarray(caps_word_leds, led)) {
-        set_color(RGB_WHITE);
-    }
-    else if ((mods & (MOD_MASK_SHIFT | MOD_MASK_GUI)) && inarray(mod_shift_leds, led)) {
-        set_color(RGB_GREEN);
-    }
-    else if ((mods & (MOD_MASK_CTRL | MOD_MASK_GUI)) && inarray(mod_ctrl_leds, led)) {
-        set_color(RGB_RED);
-    }
-    else if ((mods & (MOD_MASK_ALT | MOD_MASK_GUI)) && inarray(mod_alt_leds, led)) {
-        set_color(RGB_BLUE);
-    }
-    else {
-        switch (get_highest_layer(layer_state | default_layer_state)) {
-        case LAYER_POINTER:
-            set_color(RGB_YELLOW);
-            break;
-        //case LAYER_FUNCTION:
-        //    set_color(RGB_MAGENTA);
-        //    break;
-        case LAYER_NAVIGATION:
-            set_color(RGB_CYAN);
-            break;
-        case LAYER_NUMERAL:
-            set_color(RGB_BLUE);
-            break;
-        case LAYER_SYMBOLS:
-            set_color(RGB_CORAL);
-            break;
-        default:
-            break;
-        }
-    }
-
-    if (color_set) {
-        rgb_matrix_set_color(led, color.r, color.g, color.b);
-    }
-}
-
 bool rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max) {
-    uint8_t mods = get_mods();
-    bool caps_lock = host_keyboard_led_state().caps_lock;
-    bool caps_word = is_caps_word_on();
-
-    for (uint8_t led = led_min; led <= led_max; led++) {
-        rgb_matrix_colorify_led(led, mods, caps_lock, caps_word);
-    }
-
+    PROFILE_MARK(PROFILE_RGB);
+    indicators_render(led_min, led_max, user_state.layer_state | user_state.default_layer_state, user_state.mods, user_state.flags & USER_STATE_CAPS_LOCK, user_state.flags & USER_STATE_CAPS_WORD);
+    PROFILE_MARK(PROFILE_OTHER);
     return false;
 }
 #endif // RGB_MATRIX_ENABLE
@@ -0,0 +1,88 @@
+/**
+ * Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "lock_chords.h"
+
+static struct {
+    uint8_t       down;     // members held
+    uint8_t       consumed; // members whose press made a chord, until their release
+    layer_state_t locked;
+} chords;
+
+static uint8_t lock_chords_member(keypos_t key) {
+    // combos and other virtual keys have no matrix position
+    if (key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS) {
+        return 0;
+    }
+    return pgm_read_byte(&lock_chord_members[key.row][key.col]);
+}
+
+bool lock_chords_is_locked(uint8_t layer) {
+    // a layer turned off some other way is no longer locked
+    return (chords.locked & ((layer_state_t)1 << layer)) && layer_state_is(layer);
+}
+
+static void lock_chords_toggle(uint8_t layer) {
+    if (lock_chords_is_locked(layer)) {
+        chords.locked &= ~((layer_state_t)1 << layer);
+        layer_off(layer);
+    } else {
+        chords.locked |= (layer_state_t)1 << layer;
+        layer_on(layer);
+    }
+}
+
+bool lock_chords_pre_process(keyrecord_t *record) {
+    const uint8_t member = lock_chords_member(record->event.key);
+    if (!member) {
+        return true;
+    }
+    if (!record->event.pressed) {
+        chords.down &= ~member;
+        if (chords.consumed & member & lock_chord_partners) {
+            chords.consumed &= ~member;
+            return false; // its press went nowhere either
+        }
+        return true;
+    }
+    chords.down |= member;
+    if (!(member & lock_chord_partners)) {
+        return true;
+    }
+    const uint8_t chord = pgm_read_byte(&lock_chord_layers[chords.down]);
+    if (chord == LOCK_CHORD_NONE) {
+        return true;
+    }
+    chords.consumed |= chords.down;
+    lock_chords_toggle(chord - 1);
+    return false;
+}
+
+bool lock_chords_process(uint16_t keycode, keyrecord_t *record) {
+    const uint8_t member = lock_chords_member(record->event.key) & ~lock_chord_partners;
+    if (member & chords.consumed) {
+        if (!record->event.pressed) {
+            chords.consumed &= ~member;
+        }
+        if (record->tap.count) {
+            return false; // the thumb was tapped for the chord, not for its keycode
+        }
+    }
+    if (IS_QK_LAYER_TAP(keycode) && !record->event.pressed && !record->tap.count) {
+        return !lock_chords_is_locked(QK_LAYER_TAP_GET_LAYER(keycode));
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+/**
+ * Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "quantum.h"
+
+/**
+ * \brief Layer-lock chords, in place of QMK combos.
+ *
+ * While a layer-tap thumb is down, pressing its partner key locks the thumb's layer on,
+ * or unlocks it; the partner's press and release go no further.  The thumb itself is
+ * left to the tap-hold core, and whatever it resolves to is dropped: no tap keycode, and
+ * no layer off on its release while its layer is locked.  The same goes for any layer-tap
+ * of a locked layer, so holding and releasing it does not unlock.
+ *
+ * Only matrix positions count, not keycodes.  Members are found with one table read per
+ * key event, and a chord with a second one indexed by the bitmask of members down, so
+ * nothing is scanned and no key waits: other keys pass straight through.
+ *
+ * The keymap lays out both tables, and names the partners.
+ */
+
+#ifndef LOCK_CHORD_KEYS
+#    define LOCK_CHORD_KEYS 6 // member keys, one bit each in the tables below
+#endif
+_Static_assert(LOCK_CHORD_KEYS >= 2 && LOCK_CHORD_KEYS <= 8, "LOCK_CHORD_KEYS out of range");
+
+#define LOCK_CHORD_NONE 0
+#define LOCK_CHORD_LAYER(layer) ((layer) + 1) // an entry of `lock_chord_layers`
+
+/** Member bit of each matrix position, 0 for keys that are no member. */
+extern const uint8_t PROGMEM lock_chord_members[MATRIX_ROWS][MATRIX_COLS];
+/** The layer each set of members down locks, `LOCK_CHORD_NONE` for most. */
+extern const uint8_t PROGMEM lock_chord_layers[1 << LOCK_CHORD_KEYS];
+/** Members that complete a chord when pressed, i.e. not the thumbs. */
+extern const uint8_t lock_chord_partners;
+
+/** From `pre_process_record_user()`, which sees key events before the tap-hold core. */
+bool lock_chords_pre_process(keyrecord_t *record);
+/** From `process_record_user()`, which sees what the core made of them. */
+bool lock_chords_process(uint16_t keycode, keyrecord_t *record);
+
+bool lock_chords_is_locked(uint8_t layer);
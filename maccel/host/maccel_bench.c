@@ -0,0 +1,420 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Replays motion traces through `pointing_device_task_maccel()` on the host.
+ *
+ * A trace is a text file with one sensor report per line, `dt_us x y`: the microseconds
+ * since the previous report and the raw deltas. A `cpi N` line sets the device CPI for the
+ * reports after it, and `#` starts a comment. Without a trace file, a deterministic synthetic
+ * one is generated (strokes with a bell-shaped speed profile, separated by pauses).
+ *
+ * Output deltas can be written as `out_x out_y` lines, one per report of the trace, and
+ * compared against a golden file from an earlier run, to catch behaviour changes: exactly,
+ * or within a few counts for builds whose rounding depends on the host's libm.
+ *
+ * With -w, the trace is drag-scrolled instead, at the given wheel resolution (1 for whole
+ * detents, 120 for a host applying the HID resolution multiplier), and the output columns
+ * are the wheel's h and v. Pauses are filled with pointing tasks without motion, every
+ * millisecond, as the keyboard runs them to send what is left over.
+ *
+ * Built with MACCEL_TELEMETRY_ENABLE, the telemetry ring is drained every few reports, as
+ * housekeeping would, and -x writes what the first pass recorded to a file.
+ */
+
+#include <getopt.h>
+#include <math.h>
+#include <time.h>
+#include "quantum.h"
+#include "maccel.h"
+
+void eeconfig_init_user(void);
+
+static uint16_t wheel_resolution; // drag-scroll at this resolution, 0 to move the pointer
+
+#define WHEEL_PAUSE_US 50000 // a longer one between reports starts a new movement
+
+uint16_t maccel_dragscroll_resolution(void) {
+    return wheel_resolution;
+}
+
+typedef struct {
+    uint32_t reports;      // wheel reports sent
+    uint32_t largest;      // most steps in one report, on one axis
+    uint64_t steps;        // all of them
+    uint32_t scrolls;      // movements started after a pause
+    uint64_t onset_us;     // total time from a movement's first motion to its first wheel report
+    uint64_t motion_since; // first motion of the movement not scrolled yet, 0 if none
+} wheel_stats_t;
+
+#ifdef MACCEL_TELEMETRY_ENABLE
+#    define TELEMETRY_DRAIN_EVERY 16 // reports, well within the ring
+
+// what the ring holds, appended to `file` if there is one
+static void telemetry_drain(FILE *file) {
+    uint8_t chunk[240];
+    uint8_t length;
+    while ((length = maccel_telemetry_read(chunk, sizeof(chunk))) > 0) {
+        if (file) {
+            fwrite(chunk, 1, length, file);
+        }
+    }
+}
+#endif
+
+static void wheel_count(wheel_stats_t *stats, const report_mouse_t *report) {
+    if (report->h == 0 && report->v == 0) {
+        return;
+    }
+    const uint32_t h = abs(report->h), v = abs(report->v);
+    stats->reports++;
+    stats->steps += h + v;
+    stats->largest = h > stats->largest ? h : stats->largest;
+    stats->largest = v > stats->largest ? v : stats->largest;
+    if (stats->motion_since) {
+        stats->onset_us += host_time_us - stats->motion_since;
+        stats->scrolls++;
+        stats->motion_since = 0;
+    }
+}
+
+// the pointing tasks of a pause, which send steps left over from the motion before it
+static void wheel_pause(wheel_stats_t *stats, uint32_t dt_us) {
+    for (; dt_us > 1000; dt_us -= 1000) {
+        host_time_us += 1000;
+        const report_mouse_t report = pointing_device_task_maccel((report_mouse_t){0});
+        wheel_count(stats, &report);
+    }
+    host_time_us += dt_us;
+}
+
+typedef struct {
+    uint32_t dt_us;
+    int16_t  x;
+    int16_t  y;
+    uint16_t cpi; // device CPI from this report on, 0 if unchanged
+} trace_report_t;
+
+typedef struct {
+    trace_report_t *reports;
+    size_t          count;
+    size_t          capacity;
+} trace_t;
+
+static void trace_push(trace_t *trace, uint32_t dt_us, int16_t x, int16_t y, uint16_t cpi) {
+    if (trace->count == trace->capacity) {
+        trace->capacity = trace->capacity ? trace->capacity * 2 : 4096;
+        trace->reports  = realloc(trace->reports, trace->capacity * sizeof(trace_report_t));
+        if (!trace->reports) {
+            perror("realloc");
+            exit(2);
+        }
+    }
+    trace->reports[trace->count++] = (trace_report_t){dt_us, x, y, cpi};
+}
+
+static bool trace_load(trace_t *trace, const char *path) {
+    FILE *file = strcmp(path, "-") ? fopen(path, "r") : stdin;
+    if (!file) {
+        perror(path);
+        return false;
+    }
+    char     line[128];
+    size_t   lineno = 0;
+    uint16_t cpi    = 0;
+    while (fgets(line, sizeof(line), file)) {
+        lineno++;
+        unsigned long dt_us;
+        int           x, y;
+        char         *text = line + strspn(line, " \t");
+        if (*text == '#' || *text == '\n' || *text == '\0') {
+            continue;
+        }
+        if (sscanf(text, "cpi %d", &x) == 1) {
+            cpi = x;
+            continue;
+        }
+        if (sscanf(text, "%lu %d %d", &dt_us, &x, &y) != 3) {
+            fprintf(stderr, "%s:%zu: expected `dt_us x y`\n", path, lineno);
+            return false;
+        }
+        trace_push(trace, dt_us, x, y, cpi);
+        cpi = 0;
+    }
+    if (file != stdin) {
+        fclose(file);
+    }
+    return true;
+}
+
+static uint32_t xorshift32(uint32_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+// strokes of 20..400 reports at 1 kHz, peak speed 1..60 counts/report, pauses of 0..800 ms
+static void trace_synthesize(trace_t *trace, size_t count, uint32_t seed) {
+    uint32_t rng = seed ? seed : 1;
+    uint32_t dt_us = 1000;
+    while (trace->count < count) {
+        const uint32_t length = 20 + xorshift32(&rng) % 381;
+        const float    peak   = 1 + xorshift32(&rng) % 60;
+        const float    angle  = (xorshift32(&rng) % 6283) / 1000.0f;
+        float          carry_x = 0, carry_y = 0;
+        for (uint32_t i = 0; i < length && trace->count < count; i++) {
+            const float phase = (float)i / length;
+            const float speed = peak * 4 * phase * (1 - phase);
+            carry_x += speed * cosf(angle);
+            carry_y += speed * sinf(angle);
+            const int16_t x = (int16_t)carry_x, y = (int16_t)carry_y;
+            carry_x -= x;
+            carry_y -= y;
+            if (x || y) {
+                trace_push(trace, dt_us, x, y, 0);
+                dt_us = 0;
+            }
+            dt_us += 1000;
+        }
+        dt_us += (xorshift32(&rng) % 800) * 1000;
+    }
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [options] [TRACE]\n"
+            "  TRACE       replay `dt_us x y` lines from a file (- for stdin), default: synthetic\n"
+            "              (`maccel_trace_decode` turns a recording from the keyboard into one)\n"
+            "  -n COUNT    synthetic trace length in reports (default 100000)\n"
+            "  -s SEED     synthetic trace seed (default 1)\n"
+            "  -r REPEAT   replay the trace REPEAT times for timing (default 10)\n"
+            "  -c CPI      device CPI (default 400)\n"
+            "  -p T,G,O,L  curve takeoff, growth rate, offset and limit\n"
+            "  -o FILE     write `out_x out_y` lines to FILE (- for stdout)\n"
+            "  -g FILE     compare those lines against golden FILE, fail on any difference\n"
+            "  -e COUNTS   but allow differences of up to COUNTS per delta (default 0)\n"
+            "  -w RES      drag-scroll at RES wheel steps per detent (1 whole detents, 120 hi-res)\n"
+#ifdef MACCEL_TELEMETRY_ENABLE
+            "  -x FILE     write the first pass's telemetry records to FILE\n"
+#endif
+            ,
+            prog);
+}
+
+int main(int argc, char **argv) {
+    size_t      synthetic_count = 100000;
+    uint32_t    seed            = 1;
+    unsigned    repeat          = 10;
+    const char *params          = NULL;
+    const char *output_path     = NULL;
+    const char *golden_path     = NULL;
+    int         tolerance       = 0;
+    const char *telemetry_path  = NULL;
+    int         opt;
+    while ((opt = getopt(argc, argv, "n:s:r:c:p:o:g:e:w:x:h")) != -1) {
+        switch (opt) {
+            case 'n':
+                synthetic_count = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                seed = strtoul(optarg, NULL, 0);
+                break;
+            case 'r':
+                repeat = strtoul(optarg, NULL, 0);
+                break;
+            case 'c':
+                host_cpi = strtoul(optarg, NULL, 0);
+                break;
+            case 'p':
+                params = optarg;
+                break;
+            case 'o':
+                output_path = optarg;
+                break;
+            case 'g':
+                golden_path = optarg;
+                break;
+            case 'e':
+                tolerance = strtoul(optarg, NULL, 0);
+                break;
+            case 'w':
+                wheel_resolution = strtoul(optarg, NULL, 0);
+                break;
+#ifdef MACCEL_TELEMETRY_ENABLE
+            case 'x':
+                telemetry_path = optarg;
+                break;
+#endif
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    if (repeat == 0) {
+        repeat = 1;
+    }
+
+    trace_t trace = {0};
+    if (optind < argc) {
+        if (!trace_load(&trace, argv[optind])) {
+            return 2;
+        }
+    } else {
+        trace_synthesize(&trace, synthetic_count, seed);
+    }
+    if (trace.count == 0) {
+        fprintf(stderr, "empty trace\n");
+        return 2;
+    }
+
+    // boot like the keyboard does: defaults to the EEPROM block, then load them back through VIA
+    eeconfig_init_user();
+    keyboard_post_init_maccel();
+    if (params) {
+        float takeoff, growth_rate, offset, limit;
+        if (sscanf(params, "%f,%f,%f,%f", &takeoff, &growth_rate, &offset, &limit) != 4) {
+            fprintf(stderr, "-p expects takeoff,growth_rate,offset,limit\n");
+            return 2;
+        }
+        maccel_set_takeoff(takeoff);
+        maccel_set_growth_rate(growth_rate);
+        maccel_set_offset(offset);
+        maccel_set_limit(limit);
+    }
+    housekeeping_task_maccel();
+    maccel_dragscroll_enable(wheel_resolution != 0);
+#ifdef MACCEL_TELEMETRY_ENABLE
+    FILE *telemetry = NULL;
+    if (telemetry_path && !(telemetry = fopen(telemetry_path, "wb"))) {
+        perror(telemetry_path);
+        return 2;
+    }
+#else
+    (void)telemetry_path;
+#endif
+
+    report_mouse_t *outputs = malloc(trace.count * sizeof(report_mouse_t));
+    if (!outputs) {
+        perror("malloc");
+        return 2;
+    }
+    double        elapsed_ns = 0;
+    wheel_stats_t wheel      = {0};
+    for (unsigned pass = 0; pass < repeat; pass++) {
+        host_time_us += 1000000; // every pass starts from a resting pointer
+        const double start = now_ns();
+        for (size_t i = 0; i < trace.count; i++) {
+            if (wheel_resolution) {
+                wheel_pause(&wheel, trace.reports[i].dt_us);
+                if (trace.reports[i].dt_us >= WHEEL_PAUSE_US) {
+                    wheel.motion_since = host_time_us;
+                }
+            } else {
+                host_time_us += trace.reports[i].dt_us;
+            }
+            if (trace.reports[i].cpi && trace.reports[i].cpi != host_cpi) {
+                host_cpi = trace.reports[i].cpi;
+                maccel_cpi_changed();
+                housekeeping_task_maccel();
+            }
+            report_mouse_t report = {.x = trace.reports[i].x, .y = trace.reports[i].y};
+            outputs[i]            = pointing_device_task_maccel(report);
+            if (wheel_resolution) {
+                wheel_count(&wheel, &outputs[i]);
+            }
+#ifdef MACCEL_TELEMETRY_ENABLE
+            if (i % TELEMETRY_DRAIN_EVERY == 0) {
+                telemetry_drain(pass == 0 ? telemetry : NULL);
+            }
+#endif
+        }
+#ifdef MACCEL_TELEMETRY_ENABLE
+        telemetry_drain(pass == 0 ? telemetry : NULL);
+#endif
+        elapsed_ns += now_ns() - start;
+    }
+#ifdef MACCEL_TELEMETRY_ENABLE
+    if (telemetry) {
+        fclose(telemetry);
+    }
+#endif
+
+    const size_t total = trace.count * repeat;
+    printf("reports: %zu x %u, %.1f ns/report, %.2f M reports/s, cpi reads: %u\n", trace.count, repeat, elapsed_ns / total, total / elapsed_ns * 1e3, host_cpi_reads);
+    if (wheel_resolution) {
+        printf("wheel at %u/detent: %.0f detents in %u reports, %.3f detents/report, at most %.3f, %.2f ms from motion to scrolling\n", wheel_resolution, (double)wheel.steps / wheel_resolution, wheel.reports, (double)wheel.steps / wheel_resolution / (wheel.reports ? wheel.reports : 1), (double)wheel.largest / wheel_resolution, wheel.onset_us / 1000.0 / (wheel.scrolls ? wheel.scrolls : 1));
+    }
+
+    int   status = 0;
+    FILE *output = NULL;
+    if (output_path) {
+        output = strcmp(output_path, "-") ? fopen(output_path, "w") : stdout;
+        if (!output) {
+            perror(output_path);
+            return 2;
+        }
+    }
+    FILE *golden = NULL;
+    if (golden_path && !(golden = fopen(golden_path, "r"))) {
+        perror(golden_path);
+        return 2;
+    }
+    size_t near = 0; // reports off by no more than the tolerance
+    for (size_t i = 0; i < trace.count && (output || golden); i++) {
+        const int out_x = wheel_resolution ? outputs[i].h : outputs[i].x, out_y = wheel_resolution ? outputs[i].v : outputs[i].y;
+        if (output) {
+            fprintf(output, "%d %d\n", out_x, out_y);
+        }
+        if (golden && status == 0) {
+            int expected_x, expected_y;
+            if (fscanf(golden, "%d %d", &expected_x, &expected_y) != 2) {
+                fprintf(stderr, "golden: ends at report %zu of %zu\n", i, trace.count);
+                status = 1;
+            } else if (abs(out_x - expected_x) > tolerance || abs(out_y - expected_y) > tolerance) {
+                fprintf(stderr, "golden: report %zu (%lu %d %d) differs\n  expected: %d %d\n  got:      %d %d\n", i, (unsigned long)trace.reports[i].dt_us, trace.reports[i].x, trace.reports[i].y, expected_x, expected_y, out_x, out_y);
+                status = 1;
+            } else if (out_x != expected_x || out_y != expected_y) {
+                near++;
+            }
+        }
+    }
+    if (golden && status == 0 && fscanf(golden, " %*c") != EOF) {
+        fprintf(stderr, "golden: has more reports than the trace\n");
+        status = 1;
+    }
+    if (output && output != stdout) {
+        fclose(output);
+    }
+    if (golden) {
+        fclose(golden);
+        if (status == 0) {
+            printf("golden: %zu reports match", trace.count);
+            if (tolerance) {
+                printf(", %zu of them off by at most %d", near, tolerance);
+            }
+            printf("\n");
+        }
+    }
+    free(outputs);
+    free(trace.reports);
+    return status;
+}
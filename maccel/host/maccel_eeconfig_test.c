@@ -0,0 +1,207 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks of the EEPROM user block that `maccel_via.c` writes and decodes at boot.
+ *
+ * Blocks are put in the stand-in EEPROM byte by byte, the way other firmware versions would
+ * have left them: the current format with fewer or more profiles and fields, and damaged
+ * ones. Built with the block size and the three profiles of the keymap's `config.h`.
+ */
+
+#include <math.h>
+#include "quantum.h"
+#include "maccel.h"
+
+void eeconfig_init_user(void);
+
+static int failures;
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                               \
+        }                                                                             \
+    } while (0)
+
+#define NEAR(a, b) (fabsf((a) - (b)) <= 0.0005f)
+
+static maccel_config_t defaults[MACCEL_PROFILE_COUNT];
+
+static uint16_t crc16(const uint8_t *data, uint16_t length) {
+    uint16_t crc = 0xFFFF;
+    while (length--) {
+        crc ^= (uint16_t)*data++ << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+// a block of the current format: `values` holds profiles * fields 16-bit fields
+static void put_block(uint8_t version, uint8_t profiles, uint8_t fields, const uint16_t *values) {
+    uint8_t block[EECONFIG_USER_DATA_SIZE] = {version, profiles, fields};
+    for (uint16_t i = 0; i < profiles * fields; i++) {
+        block[5 + 2 * i] = values[i] & 0xFF;
+        block[6 + 2 * i] = values[i] >> 8;
+    }
+    const uint16_t crc = crc16(&block[5], profiles * fields * 2);
+    block[3]           = crc & 0xFF;
+    block[4]           = crc >> 8;
+    eeconfig_update_user_datablock(block);
+}
+
+// boot on what is stored, from the compiled-in profiles
+static void boot(void) {
+    memcpy(g_maccel_profiles, defaults, sizeof(defaults));
+    keyboard_post_init_maccel();
+}
+
+// let the deferred save happen
+static void settle(void) {
+    host_time_us += 10000000;
+    maccel_config_save_task(true);
+}
+
+static bool same(const maccel_config_t *a, const maccel_config_t *b) {
+    return a->takeoff == b->takeoff && a->growth_rate == b->growth_rate && a->offset == b->offset && a->limit == b->limit && a->enabled == b->enabled;
+}
+
+static bool is_default(uint8_t profile) {
+    return same(&g_maccel_profiles[profile], &defaults[profile]);
+}
+
+static void check_round_trip(void) {
+    g_maccel_profiles[0] = (maccel_config_t)MACCEL_CONFIG(1.234f, 0.56f, -3.5f, 12.75f);
+    g_maccel_profiles[1] = (maccel_config_t)MACCEL_CONFIG(0.5f, 0, 33.5f, 1);
+    g_maccel_profiles[2] = (maccel_config_t)MACCEL_CONFIG(64, 64, -32, 15.99f);
+    g_maccel_profiles[2].enabled = false;
+    maccel_config_t saved[MACCEL_PROFILE_COUNT];
+    memcpy(saved, g_maccel_profiles, sizeof(saved));
+    maccel_config_save();
+    settle();
+
+    uint8_t block[EECONFIG_USER_DATA_SIZE];
+    eeconfig_read_user_datablock(block);
+    CHECK(block[0] == 2 && block[1] == MACCEL_PROFILE_COUNT && block[2] == 5);
+
+    const uint32_t rejected = maccel_eeconfig_stats().rejected;
+    boot();
+    CHECK(maccel_eeconfig_stats().rejected == rejected);
+    for (uint8_t i = 0; i < MACCEL_PROFILE_COUNT; i++) {
+        CHECK(NEAR(g_maccel_profiles[i].takeoff, saved[i].takeoff) && NEAR(g_maccel_profiles[i].growth_rate, saved[i].growth_rate));
+        CHECK(NEAR(g_maccel_profiles[i].offset, saved[i].offset) && NEAR(g_maccel_profiles[i].limit, saved[i].limit));
+        CHECK(g_maccel_profiles[i].enabled == saved[i].enabled);
+    }
+    // values of the config, which thousandths hold exactly, come back as the same floats
+    CHECK(g_maccel_profiles[0].takeoff == 1.234f && g_maccel_profiles[0].growth_rate == 0.56f && g_maccel_profiles[0].offset == -3.5f);
+
+    // out of range saturates, NaN stores as the lowest
+    g_maccel_profiles[0] = (maccel_config_t)MACCEL_CONFIG(100, NAN, -40, INFINITY);
+    maccel_config_save();
+    settle();
+    boot();
+    CHECK(g_maccel_profiles[0].takeoff == 65.535f && g_maccel_profiles[0].growth_rate == 0);
+    CHECK(g_maccel_profiles[0].offset == -32 && g_maccel_profiles[0].limit == 65.535f);
+}
+
+static void check_fewer(void) {
+    // one profile of flags, takeoff and growth rate: the rest keep their defaults
+    const uint16_t values[] = {0, 1500, 250};
+    put_block(2, 1, 3, values);
+    boot();
+    CHECK(!g_maccel_profiles[0].enabled && g_maccel_profiles[0].takeoff == 1.5f && g_maccel_profiles[0].growth_rate == 0.25f);
+    CHECK(g_maccel_profiles[0].offset == defaults[0].offset && g_maccel_profiles[0].limit == defaults[0].limit);
+    CHECK(is_default(1) && is_default(2));
+}
+
+static void check_more(void) {
+    // two profiles of seven fields, as a later firmware might store: the extra fields are ignored
+    uint16_t values[2 * 7];
+    for (uint8_t i = 0; i < 2; i++) {
+        const uint16_t profile[7] = {1, 1000 + i, 2000 + i, 32000 + i, 3000 + i, 0xFFFF, 0xFFFF};
+        memcpy(&values[i * 7], profile, sizeof(profile));
+    }
+    put_block(2, 2, 7, values);
+    boot();
+    for (uint8_t i = 0; i < 2; i++) {
+        CHECK(g_maccel_profiles[i].enabled && NEAR(g_maccel_profiles[i].takeoff, 1 + i / 1000.0f) && NEAR(g_maccel_profiles[i].growth_rate, 2 + i / 1000.0f));
+        CHECK(NEAR(g_maccel_profiles[i].offset, i / 1000.0f) && NEAR(g_maccel_profiles[i].limit, 3 + i / 1000.0f));
+    }
+    CHECK(is_default(2));
+
+    // and four profiles of flags, takeoff and growth rate: so is the extra profile
+    uint16_t flags[4 * 3];
+    for (uint8_t i = 0; i < 4; i++) {
+        const uint16_t profile[3] = {0, 1500 + i, 250 + i};
+        memcpy(&flags[i * 3], profile, sizeof(profile));
+    }
+    put_block(2, 4, 3, flags);
+    boot();
+    for (uint8_t i = 0; i < MACCEL_PROFILE_COUNT; i++) {
+        CHECK(!g_maccel_profiles[i].enabled && NEAR(g_maccel_profiles[i].takeoff, 1.5f + i / 1000.0f) && NEAR(g_maccel_profiles[i].growth_rate, 0.25f + i / 1000.0f));
+        CHECK(g_maccel_profiles[i].offset == defaults[i].offset && g_maccel_profiles[i].limit == defaults[i].limit);
+    }
+}
+
+static void check_rejected(void) {
+    const uint16_t values[5] = {1, 1000, 1000, 32000, 1000};
+    uint8_t        block[EECONFIG_USER_DATA_SIZE];
+
+    // a flipped bit
+    put_block(2, 1, 5, values);
+    eeconfig_read_user_datablock(block);
+    block[7] ^= 0x10;
+    eeconfig_update_user_datablock(block);
+    uint32_t rejected = maccel_eeconfig_stats().rejected;
+    boot();
+    CHECK(maccel_eeconfig_stats().rejected == rejected + 1 && is_default(0));
+
+    // an unknown version, no fields, and counts beyond the block
+    const uint8_t headers[][3] = {{3, 1, 5}, {0xFF, 0xFF, 0xFF}, {2, 0, 5}, {2, 1, 0}, {2, 4, 8}};
+    for (size_t i = 0; i < sizeof(headers) / sizeof(headers[0]); i++) {
+        put_block(headers[i][0], 0, 0, NULL);
+        eeconfig_read_user_datablock(block);
+        memcpy(block, headers[i], 3);
+        eeconfig_update_user_datablock(block);
+        rejected = maccel_eeconfig_stats().rejected;
+        boot();
+        CHECK(maccel_eeconfig_stats().rejected == rejected + 1 && is_default(0) && is_default(1) && is_default(2));
+    }
+
+    // the defaults are written over it
+    settle();
+    eeconfig_read_user_datablock(block);
+    CHECK(block[0] == 2 && block[1] == MACCEL_PROFILE_COUNT);
+}
+
+int main(void) {
+    memcpy(defaults, g_maccel_profiles, sizeof(defaults));
+    eeconfig_init_user();
+    keyboard_post_init_maccel();
+
+    check_round_trip();
+    check_fewer();
+    check_more();
+    check_rejected();
+    if (failures) {
+        fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    printf("eeconfig checks pass: %d bytes for %d profiles (%d as floats)\n", 5 + MACCEL_PROFILE_COUNT * 5 * 2, MACCEL_PROFILE_COUNT, (int)(4 + MACCEL_PROFILE_COUNT * sizeof(maccel_config_t)));
+    return 0;
+}
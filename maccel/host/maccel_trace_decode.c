@@ -0,0 +1,266 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Decodes a motion recording from `maccel_trace.c` into a replayable trace.
+ *
+ * Input is either a console log (`qmk console > log.txt`), of which only the `MT:` hex lines
+ * are read, or with `-b` the raw bytes as drained through VIA. Output is the text trace format
+ * `maccel_bench` replays: `dt_us x y` per report, `cpi N` when the CPI changes.
+ *
+ * With `-x`, the input is telemetry from `maccel_telemetry.c` instead (`MX:` lines), and the
+ * output CSV: one row per report, with its profile's parameters as last recorded.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef struct {
+    uint8_t *bytes;
+    size_t   length;
+    size_t   capacity;
+} buffer_t;
+
+static void buffer_push(buffer_t *buffer, uint8_t byte) {
+    if (buffer->length == buffer->capacity) {
+        buffer->capacity = buffer->capacity ? buffer->capacity * 2 : 4096;
+        buffer->bytes    = realloc(buffer->bytes, buffer->capacity);
+        if (!buffer->bytes) {
+            perror("realloc");
+            exit(2);
+        }
+    }
+    buffer->bytes[buffer->length++] = byte;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+static void read_console(FILE *file, const char *prefix, buffer_t *buffer) {
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        const char *hex = strstr(line, prefix);
+        if (!hex) {
+            continue;
+        }
+        for (hex += 3; hex_value(hex[0]) >= 0 && hex_value(hex[1]) >= 0; hex += 2) {
+            buffer_push(buffer, hex_value(hex[0]) << 4 | hex_value(hex[1]));
+        }
+    }
+}
+
+static void read_binary(FILE *file, buffer_t *buffer) {
+    int c;
+    while ((c = fgetc(file)) != EOF) {
+        buffer_push(buffer, c);
+    }
+}
+
+static int16_t read_i16(const uint8_t *bytes) {
+    return (int16_t)(bytes[0] | bytes[1] << 8);
+}
+
+static int decode(const buffer_t *buffer, FILE *out) {
+    const uint8_t *bytes     = buffer->bytes;
+    size_t         pos       = 0;
+    uint32_t       tick_us   = 1000;
+    uint64_t       dt_us     = 0; // carried over marker and dropped records
+    unsigned long  reports   = 0;
+    unsigned       recording = 0;
+
+    while (pos < buffer->length) {
+        const uint8_t tag    = bytes[pos] >> 6;
+        const size_t  length = tag == 0 ? 2 : tag == 1 ? 3 : tag == 2 ? 7 : 3;
+        if (pos + length > buffer->length) {
+            fprintf(stderr, "truncated record at byte %zu\n", pos);
+            return 1;
+        }
+        const uint8_t *record = &bytes[pos];
+        pos += length;
+        int16_t x, y;
+        switch (tag) {
+            case 0:
+                dt_us += (record[0] & 0x3F) * tick_us;
+                x = (int8_t)record[1] >> 4;
+                y = (int8_t)(record[1] << 4) >> 4;
+                break;
+            case 1:
+                dt_us += (record[0] & 0x3F) * tick_us;
+                x = (int8_t)record[1];
+                y = (int8_t)record[2];
+                break;
+            case 2:
+                dt_us += (uint16_t)read_i16(&record[1]) * tick_us;
+                x = read_i16(&record[3]);
+                y = read_i16(&record[5]);
+                break;
+            default: {
+                const uint16_t value = (uint16_t)read_i16(&record[1]);
+                switch (record[0] & 0x3F) {
+                    case 0:
+                        fprintf(out, "cpi %u\n", value);
+                        break;
+                    case 1:
+                        tick_us = value;
+                        dt_us   = 0;
+                        fprintf(out, "# recording %u, tick %u us\n", ++recording, value);
+                        break;
+                    case 2:
+                        fprintf(out, "# %u reports dropped (buffer full)\n", value);
+                        break;
+                    default:
+                        fprintf(stderr, "unknown marker %u at byte %zu\n", record[0] & 0x3F, pos - length);
+                        return 1;
+                }
+                continue;
+            }
+        }
+        fprintf(out, "%llu %d %d\n", (unsigned long long)dt_us, x, y);
+        dt_us = 0;
+        reports++;
+    }
+    fprintf(stderr, "%lu reports in %u recording(s)\n", reports, recording);
+    return 0;
+}
+
+static uint32_t read_u32(const uint8_t *bytes) {
+    return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+static float read_float(const uint8_t *bytes) {
+    const uint32_t bits = read_u32(bytes);
+    float          value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// maccel_telemetry_record_t, see maccel.h
+#define TELEMETRY_RECORD_SIZE 24
+#define TELEMETRY_PROFILES 256
+
+static int decode_telemetry(const buffer_t *buffer, FILE *out) {
+    float         params[TELEMETRY_PROFILES][4];
+    bool          known[TELEMETRY_PROFILES] = {false};
+    unsigned long reports = 0, dropped = 0;
+
+    if (buffer->length % TELEMETRY_RECORD_SIZE) {
+        fprintf(stderr, "%zu trailing bytes ignored\n", buffer->length % TELEMETRY_RECORD_SIZE);
+    }
+    fprintf(out, "profile,cpi,dt_us,v_in,factor,v_out,x_in,y_in,x_out,y_out,d_in,d_out,dropped,takeoff,growth_rate,offset,limit\n");
+    for (size_t pos = 0; pos + TELEMETRY_RECORD_SIZE <= buffer->length; pos += TELEMETRY_RECORD_SIZE) {
+        const uint8_t *record  = &buffer->bytes[pos];
+        const uint8_t  profile = record[1];
+        const uint16_t lost    = (uint16_t)read_i16(&record[2]);
+        dropped += lost;
+        switch (record[0]) {
+            case 1: {
+                const double  velocity = read_u32(&record[8]) / 65536.0;
+                const double  factor   = read_u32(&record[12]) / 65536.0;
+                const int16_t x_in = read_i16(&record[16]), y_in = read_i16(&record[18]);
+                const int16_t x_out = read_i16(&record[20]), y_out = read_i16(&record[22]);
+                fprintf(out, "%u,%u,%u,%.4f,%.4f,%.4f,%d,%d,%d,%d,%.3f,%.3f,%u", profile, (uint16_t)read_i16(&record[4]), (uint16_t)read_i16(&record[6]), velocity, factor, velocity * factor, x_in, y_in, x_out, y_out, sqrt((double)x_in * x_in + (double)y_in * y_in), sqrt((double)x_out * x_out + (double)y_out * y_out), lost);
+                if (known[profile]) {
+                    fprintf(out, ",%.3f,%.3f,%.3f,%.3f\n", params[profile][0], params[profile][1], params[profile][2], params[profile][3]);
+                } else {
+                    fprintf(out, ",,,,\n");
+                }
+                reports++;
+                break;
+            }
+            case 2:
+                for (uint8_t i = 0; i < 4; i++) {
+                    params[profile][i] = read_float(&record[4 + i * 4]);
+                }
+                known[profile] = true;
+                break;
+            default:
+                fprintf(stderr, "unknown record kind %u at byte %zu\n", record[0], pos);
+                return 1;
+        }
+    }
+    fprintf(stderr, "%lu reports, %lu dropped\n", reports, dropped);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    bool        binary      = false;
+    bool        telemetry   = false;
+    const char *output_path = NULL;
+    int         opt;
+    while ((opt = getopt(argc, argv, "bxo:h")) != -1) {
+        switch (opt) {
+            case 'b':
+                binary = true;
+                break;
+            case 'x':
+                telemetry = true;
+                break;
+            case 'o':
+                output_path = optarg;
+                break;
+            default:
+                fprintf(stderr,
+                        "usage: %s [-b] [-x] [-o TRACE] [INPUT]\n"
+                        "  INPUT      console log with MT: lines (default: stdin)\n"
+                        "  -b         INPUT is the raw recording as read through VIA\n"
+                        "  -x         INPUT is telemetry (MX: lines, or raw with -b), to CSV\n"
+                        "  -o TRACE   write the trace there instead of stdout\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+
+    FILE *in = optind < argc ? fopen(argv[optind], binary ? "rb" : "r") : stdin;
+    if (!in) {
+        perror(argv[optind]);
+        return 2;
+    }
+    buffer_t buffer = {0};
+    if (binary) {
+        read_binary(in, &buffer);
+    } else {
+        read_console(in, telemetry ? "MX:" : "MT:", &buffer);
+    }
+    if (in != stdin) {
+        fclose(in);
+    }
+
+    FILE *out = output_path ? fopen(output_path, "w") : stdout;
+    if (!out) {
+        perror(output_path);
+        return 2;
+    }
+    const int status = telemetry ? decode_telemetry(&buffer, out) : decode(&buffer, out);
+    if (out != stdout) {
+        fclose(out);
+    }
+    free(buffer.bytes);
+    return status;
+}
@@ -0,0 +1,252 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Worst-case timing of `pointing_device_task_maccel()` on the host.
+ *
+ * Every combination of adversarial input goes through the report path: curve parameters at
+ * and beyond their bounds (NaN and infinities included, as VIA's config block can write
+ * them), device CPIs from 0 to 65535, deltas up to the report's limits, report intervals from
+ * 0 to a pause, with the profile changed just before, acceleration off or drag-scroll on.
+ * Each combination is repeated and its fastest run kept, so that what remains is the cost of
+ * maccel's code path, not the host's preemption and cache misses; the worst of those per
+ * path is printed with the input that caused it, as `MACCEL_WCET_ENABLE` records it.
+ *
+ * Outputs are checked along the way: of the input's sign, accelerated by no less than 1 and
+ * no more than the largest limit, and left alone where maccel should not touch them. The run
+ * fails on any that is off, and with -b on any path whose worst case is over the budget.
+ */
+
+#include <getopt.h>
+#include <math.h>
+#include "quantum.h"
+#include "maccel.h"
+
+void eeconfig_init_user(void);
+
+static const char *const path_names[MACCEL_PATH_COUNT] = {
+    [MACCEL_PATH_IDLE] = "idle", [MACCEL_PATH_DISABLED] = "disabled", [MACCEL_PATH_DRAGSCROLL] = "dragscroll", [MACCEL_PATH_MOTION] = "motion", [MACCEL_PATH_PAUSE] = "pause", [MACCEL_PATH_REFRESH] = "refresh", [MACCEL_PATH_LUT_FILL] = "lut fill", [MACCEL_PATH_CPI_READ] = "cpi read",
+};
+
+// each parameter is set to each of these in turn, the others at their default
+static const float param_values[] = {0, 1e-40f, 0.5f, 1, 6.5f, 14.1f, 1e6f, -1, NAN, INFINITY, -INFINITY};
+static const char *const param_names[] = {"takeoff", "growth_rate", "offset", "limit"};
+#define PARAMS 4
+
+static const uint16_t cpis[]   = {0, 100, 400, 12000, 65535};
+static const uint32_t dts_us[] = {0, 1, 125, 1000, 49999, 50000, 10000000};
+static const struct {
+    mouse_xy_report_t x, y;
+} deltas[] = {
+    {0, 0}, {1, 0}, {0, -1}, {1, 1}, {127, -127}, {XY_REPORT_MAX, XY_REPORT_MAX}, {XY_REPORT_MIN, XY_REPORT_MIN}, {XY_REPORT_MIN, XY_REPORT_MAX},
+};
+
+typedef enum {
+    MODE_NORMAL,     // housekeeping ran before each report
+    MODE_CHANGED,    // the config changed just before each report
+    MODE_DISABLED,   // acceleration off
+    MODE_DRAGSCROLL, // drag-scroll on
+    MODE_COUNT,
+} input_mode_t;
+static const char *const mode_names[MODE_COUNT] = {"normal", "changed", "disabled", "dragscroll"};
+
+typedef struct {
+    maccel_config_t config;
+    uint16_t        cpi;
+    uint32_t        dt_us;
+    int16_t         x, y;
+    input_mode_t    mode;
+} input_t;
+
+static struct {
+    uint32_t ns; // worst of the fastest runs
+    input_t  input;
+    bool     seen;
+} worst[MACCEL_PATH_COUNT];
+
+static uint32_t failures;
+
+static void describe(FILE *file, const input_t *input) {
+    fprintf(file, "tko %g grw %g ofs %g lmt %g, cpi %u, dt %lu us, %d %d, %s", input->config.takeoff, input->config.growth_rate, input->config.offset, input->config.limit, input->cpi, (unsigned long)input->dt_us, input->x, input->y, mode_names[input->mode]);
+}
+
+static void fail(const input_t *input, const report_mouse_t *out, const char *what) {
+    if (failures++ < 10) {
+        fprintf(stderr, "%s: ", what);
+        describe(stderr, input);
+        fprintf(stderr, " -> %d %d, h %d v %d\n", out->x, out->y, out->h, out->v);
+    }
+}
+
+// one accelerated axis: the input's sign, and scaled by [1, 64] give or take the truncation
+static bool axis_ok(int32_t in, int32_t out) {
+    if (in == 0 || (in > 0) != (out > 0)) {
+        return in == 0 ? out == 0 : false;
+    }
+    const int32_t in_abs = in < 0 ? -in : in, out_abs = out < 0 ? -out : out;
+    const int32_t limit  = in < 0 ? -XY_REPORT_MIN : XY_REPORT_MAX;
+    return out_abs + 1 >= in_abs && (out_abs <= in_abs * 64 || out_abs == limit);
+}
+
+static void check(const input_t *input, const report_mouse_t *out) {
+    switch (input->mode) {
+        case MODE_DRAGSCROLL:
+            if (out->x != 0 || out->y != 0) {
+                fail(input, out, "drag-scroll moved the pointer");
+            }
+            break;
+        case MODE_DISABLED:
+            if (out->x != input->x || out->y != input->y) {
+                fail(input, out, "disabled, yet accelerated");
+            }
+            break;
+        default:
+            if (!axis_ok(input->x, out->x) || !axis_ok(input->y, out->y)) {
+                fail(input, out, "output off");
+            }
+            break;
+    }
+}
+
+// the report of one input, `repeat` times: fastest run per path
+static void run(const input_t *input, unsigned repeat) {
+    uint32_t fastest[MACCEL_PATH_COUNT];
+    memset(fastest, 0xFF, sizeof(fastest));
+    for (unsigned i = 0; i < repeat; i++) {
+        host_time_us += input->dt_us;
+        if (input->mode == MODE_CHANGED) {
+            maccel_config_changed();
+        } else {
+            housekeeping_task_maccel();
+        }
+        const report_mouse_t out = pointing_device_task_maccel((report_mouse_t){.x = input->x, .y = input->y});
+        uint32_t             ns;
+        const maccel_path_t  path = maccel_wcet_last(&ns);
+        if (ns < fastest[path]) {
+            fastest[path] = ns;
+        }
+        check(input, &out);
+    }
+    for (uint8_t path = 0; path < MACCEL_PATH_COUNT; path++) {
+        if (fastest[path] != UINT32_MAX && (!worst[path].seen || fastest[path] > worst[path].ns)) {
+            worst[path].ns    = fastest[path];
+            worst[path].input = *input;
+            worst[path].seen  = true;
+        }
+    }
+}
+
+// every CPI, interval and delta against one config
+static void run_config(const maccel_config_t *config, unsigned repeat) {
+    for (input_mode_t mode = 0; mode < MODE_COUNT; mode++) {
+        g_maccel_config = *config;
+        maccel_config_changed();
+        maccel_enabled(mode != MODE_DISABLED);
+        maccel_dragscroll_enable(mode == MODE_DRAGSCROLL);
+        for (size_t c = 0; c < sizeof(cpis) / sizeof(cpis[0]); c++) {
+            host_cpi = cpis[c];
+            maccel_cpi_changed();
+            housekeeping_task_maccel();
+            for (size_t t = 0; t < sizeof(dts_us) / sizeof(dts_us[0]); t++) {
+                for (size_t d = 0; d < sizeof(deltas) / sizeof(deltas[0]); d++) {
+                    const input_t input = {*config, cpis[c], dts_us[t], deltas[d].x, deltas[d].y, mode};
+                    run(&input, repeat);
+                }
+            }
+        }
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -r REPEAT   runs of each input, the fastest counting (default 8)\n"
+            "  -b NS       fail if any path's worst case takes longer (default: no budget)\n",
+            prog);
+}
+
+int main(int argc, char **argv) {
+    unsigned repeat    = 8;
+    uint32_t budget_ns = 0;
+    int      opt;
+    while ((opt = getopt(argc, argv, "r:b:h")) != -1) {
+        switch (opt) {
+            case 'r':
+                repeat = strtoul(optarg, NULL, 0);
+                break;
+            case 'b':
+                budget_ns = strtoul(optarg, NULL, 0);
+                break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    if (repeat == 0) {
+        repeat = 1;
+    }
+
+    eeconfig_init_user();
+    keyboard_post_init_maccel();
+    // the first report, before housekeeping ever read the CPI, is not repeatable: a sensor
+    // answering 0 takes that path on every report instead, and is timed as one of the CPIs
+    pointing_device_task_maccel((report_mouse_t){.x = 1, .y = 1});
+
+    const maccel_config_t defaults = g_maccel_config;
+    uint32_t              configs  = 1;
+    run_config(&defaults, repeat);
+    for (uint8_t p = 0; p < PARAMS; p++) {
+        for (size_t v = 0; v < sizeof(param_values) / sizeof(param_values[0]); v++, configs++) {
+            maccel_config_t config = defaults;
+            float *const    params[PARAMS] = {&config.takeoff, &config.growth_rate, &config.offset, &config.limit};
+            *params[p]                     = param_values[v];
+            run_config(&config, repeat);
+        }
+    }
+    const maccel_config_t all_nan = {NAN, NAN, NAN, NAN, true}, all_inf = {INFINITY, INFINITY, INFINITY, INFINITY, true};
+    run_config(&all_nan, repeat);
+    run_config(&all_inf, repeat);
+    configs += 2;
+
+    printf("%u configs (each of %s", configs, param_names[0]);
+    for (uint8_t p = 1; p < PARAMS; p++) {
+        printf(", %s", param_names[p]);
+    }
+    printf(" at %zu values), %u runs of each input\n", sizeof(param_values) / sizeof(param_values[0]), repeat);
+    printf("%-10s %10s %9s  worst input\n", "path", "reports", "worst ns");
+    bool over = false;
+    for (uint8_t path = 0; path < MACCEL_PATH_COUNT; path++) {
+        const maccel_wcet_stats_t stats = maccel_wcet_stats(path);
+        if (!worst[path].seen) {
+            printf("%-10s %10lu %9s\n", path_names[path], (unsigned long)stats.calls, "-");
+            continue;
+        }
+        const bool path_over = budget_ns && worst[path].ns > budget_ns;
+        printf("%-10s %10lu %9lu  ", path_names[path], (unsigned long)stats.calls, (unsigned long)worst[path].ns);
+        describe(stdout, &worst[path].input);
+        printf("%s\n", path_over ? "  OVER BUDGET" : "");
+        over |= path_over;
+    }
+
+    if (failures) {
+        fprintf(stderr, "%lu outputs off\n", (unsigned long)failures);
+        return 1;
+    }
+    if (over) {
+        fprintf(stderr, "worst case over the budget of %lu ns\n", (unsigned long)budget_ns);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <time.h>
+#include "quantum.h"
+#include "via.h"
+
+uint64_t host_time_us    = 0;
+uint16_t host_cpi        = 400;
+uint32_t host_cpi_reads  = 0;
+uint32_t host_cpi_writes = 0;
+uint8_t  host_mods       = 0;
+
+static uint8_t host_eeprom_user_block[EECONFIG_USER_DATA_SIZE];
+
+uint32_t host_clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec * 1000000000U + ts.tv_nsec;
+}
+
+uint32_t timer_read32(void) {
+    return host_time_us / 1000;
+}
+uint32_t timer_elapsed32(uint32_t last) {
+    return timer_read32() - last;
+}
+void wait_ms(uint32_t ms) {
+    host_time_us += ms * 1000;
+}
+
+uint16_t pointing_device_get_cpi(void) {
+    host_cpi_reads++;
+    return host_cpi;
+}
+void pointing_device_set_cpi(uint16_t cpi) {
+    host_cpi_writes++;
+    host_cpi = cpi;
+}
+
+uint8_t get_mods(void) {
+    return host_mods;
+}
+
+void eeconfig_read_user_datablock(void *data) {
+    memcpy(data, host_eeprom_user_block, sizeof(host_eeprom_user_block));
+}
+void eeconfig_update_user_datablock(const void *data) {
+    memcpy(host_eeprom_user_block, data, sizeof(host_eeprom_user_block));
+}
+
+void via_custom_value_command_user(uint8_t *data, uint8_t length) {
+    data[0] = id_unhandled;
+}
@@ -0,0 +1,97 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/* Minimal stand-ins for the QMK APIs maccel uses, so it compiles and runs on a Linux host.
+ * Only what `maccel.c` and `maccel_via.c` touch is declared here; see `qmk_stubs.c`.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PROGMEM
+
+/* report.h / pointing_device.h */
+#ifdef MOUSE_EXTENDED_REPORT
+#    define XY_REPORT_MIN INT16_MIN
+#    define XY_REPORT_MAX INT16_MAX
+typedef int16_t mouse_xy_report_t;
+#else
+#    define XY_REPORT_MIN INT8_MIN
+#    define XY_REPORT_MAX INT8_MAX
+typedef int8_t mouse_xy_report_t;
+#endif
+
+#ifdef WHEEL_EXTENDED_REPORT
+#    define HV_REPORT_MIN INT16_MIN
+#    define HV_REPORT_MAX INT16_MAX
+typedef int16_t mouse_hv_report_t;
+#else
+#    define HV_REPORT_MIN INT8_MIN
+#    define HV_REPORT_MAX INT8_MAX
+typedef int8_t mouse_hv_report_t;
+#endif
+
+typedef struct {
+    uint8_t           buttons;
+    mouse_xy_report_t x;
+    mouse_xy_report_t y;
+    mouse_hv_report_t v;
+    mouse_hv_report_t h;
+} report_mouse_t;
+
+uint16_t pointing_device_get_cpi(void);
+void     pointing_device_set_cpi(uint16_t cpi);
+
+/* action.h / keycodes */
+typedef struct {
+    struct {
+        bool     pressed;
+        uint16_t time;
+    } event;
+} keyrecord_t;
+
+#define MOD_MASK_CTRL 0x11
+#define MOD_MASK_SHIFT 0x22
+#define MOD_MASK_ALT 0x44
+#define MOD_MASK_GUI 0x88
+
+uint8_t get_mods(void);
+
+/* timer.h / wait.h */
+uint32_t timer_read32(void);
+uint32_t timer_elapsed32(uint32_t last);
+void     wait_ms(uint32_t ms);
+
+/* eeconfig.h */
+void eeconfig_read_user_datablock(void *data);
+void eeconfig_update_user_datablock(const void *data);
+
+/* Host-only: the simulated clock driving `timer_read32()`, in microseconds. */
+extern uint64_t host_time_us;
+#define TIMEBASE_TICKS() ((uint32_t)host_time_us) // stands in for the MCU's microsecond counter (`timebase.h`)
+#define TIMEBASE_TICKS_PER_US 1
+#define TIMEBASE_HIGH_RESOLUTION
+uint32_t host_clock_ns(void); // real time, for `maccel_wcet`
+#define MACCEL_WCET_TICKS() host_clock_ns()
+#define MACCEL_WCET_TICKS_PER_US 1000
+extern uint16_t host_cpi;
+extern uint32_t host_cpi_reads;
+extern uint32_t host_cpi_writes;
+extern uint8_t  host_mods;
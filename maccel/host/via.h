@@ -0,0 +1,12 @@
+#pragma once
+#include "quantum.h"
+
+/* via.h: the custom-value command ids maccel_via.c dispatches on */
+enum via_command_id {
+    id_custom_set_value = 0x07,
+    id_custom_get_value = 0x08,
+    id_custom_save      = 0x09,
+    id_unhandled        = 0xFF,
+};
+
+void via_custom_value_command_user(uint8_t *data, uint8_t length);
@@ -17,9 +17,9 @@
 
 #include "quantum.h" // IWYU pragma: keep
 #include "maccel.h"
-#include "math.h"
-
-static uint32_t maccel_timer;
+#if !defined(MACCEL_USE_FIXED_POINT) || defined(MACCEL_DEBUG)
+#    include "math.h"
+#endif
 
 #ifndef MACCEL_TAKEOFF
 #    define MACCEL_TAKEOFF 2.0 // lower/higher value = curve starts more smoothly/abrubtly
@@ -34,15 +34,14 @@ static uint32_t maccel_timer;
 #    define MACCEL_LIMIT 6.0 // upper limit of accel curve (maximum acceleration factor)
 #endif
 
-maccel_config_t g_maccel_config = {
-    // clang-format off
-    .growth_rate =  MACCEL_GROWTH_RATE,
-    .offset =       MACCEL_OFFSET,
-    .limit =        MACCEL_LIMIT,
-    .takeoff =      MACCEL_TAKEOFF,
-    .enabled =      true
-    // clang-format on
-};
+_Static_assert(MACCEL_PROFILE_COUNT >= 1 && MACCEL_PROFILE_COUNT < MACCEL_PROFILE_NONE, "MACCEL_PROFILE_COUNT out of range");
+
+// every profile starts from the MACCEL_* defaults, unless config.h lists them in MACCEL_PROFILES
+#ifndef MACCEL_PROFILES
+#    define MACCEL_PROFILES {[0 ... MACCEL_PROFILE_COUNT - 1] = MACCEL_CONFIG(MACCEL_TAKEOFF, MACCEL_GROWTH_RATE, MACCEL_OFFSET, MACCEL_LIMIT)}
+#endif
+
+maccel_config_t g_maccel_profiles[MACCEL_PROFILE_COUNT] = MACCEL_PROFILES;
 
 /* DEVICE_CPI_PARAM
 A device specific parameter required to ensure consistent acceleration behaviour across different devices and user dpi settings.
@@ -88,7 +87,7 @@ float maccel_get_growth_rate(void) {
     return g_maccel_config.growth_rate;
 }
 float maccel_get_offset(void) {
-    return g_maccel_config.limit;
+    return g_maccel_config.offset;
 }
 float maccel_get_limit(void) {
     return g_maccel_config.limit;
@@ -96,24 +95,31 @@ float maccel_get_limit(void) {
 void maccel_set_takeoff(float val) {
     if (val >= 0.5) { // value less than 0.5 leads to nonsensical results
         g_maccel_config.takeoff = val;
+        maccel_config_changed();
     }
 }
 void maccel_set_growth_rate(float val) {
     if (val >= 0) { // value less 0 leads to nonsensical results
         g_maccel_config.growth_rate = val;
+        maccel_config_changed();
     }
 }
 void maccel_set_offset(float val) {
-    g_maccel_config.limit = val;
+    g_maccel_config.offset = val;
+    maccel_config_changed();
 }
 void maccel_set_limit(float val) {
     if (val >= 1) { // limit less than 1 leads to nonsensical results
         g_maccel_config.limit = val;
+        maccel_config_changed();
     }
 }
 
 void maccel_enabled(bool enable) {
-    g_maccel_config.enabled = enable;
+    // on or off for every profile, so switching profiles does not switch acceleration on again
+    for (uint8_t i = 0; i < MACCEL_PROFILE_COUNT; i++) {
+        g_maccel_profiles[i].enabled = enable;
+    }
 #ifdef MACCEL_DEBUG
     printf("maccel: enabled: %d\n", g_maccel_config.enabled);
 #endif
@@ -128,46 +134,814 @@ void maccel_toggle_enabled(void) {
 #define _CONSTRAIN(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
 #define CONSTRAIN_REPORT(val) (mouse_xy_report_t) _CONSTRAIN(val, XY_REPORT_MIN, XY_REPORT_MAX)
 
-report_mouse_t pointing_device_task_maccel(report_mouse_t mouse_report) {
-    if (mouse_report.x != 0 || mouse_report.y != 0) {
-        if (!g_maccel_config.enabled) { // do nothing if not enabled
-            return mouse_report;
+#ifdef MACCEL_USE_FIXED_POINT
+/* Integer-only engine (Q16.16 fixed-point)
+ *
+ * Evaluates the same curve as the float path without libm or soft-float calls on the report path,
+ * for MCUs without an FPU (Cortex-M0/M0+, AVR). The sigmoid is rewritten in base 2:
+ *   f(v) = c - (c-1) * 2^(-(y/x) * log2(1 + 2^(x*(v-b)*log2(e))))
+ * The distance comes from an integer square root; 2^-f and ln(1+f) are least-squares polynomials
+ * on [0,1] (error < 2e-5). Parameters are converted to Q16 only when they (or the CPI) change.
+ */
+typedef int32_t fix16_t;
+
+#    define FIX16_ONE (1L << 16)
+#    define FIX16_LOG2E 94548 // log2(e) in Q16
+// Velocity is clamped here: the curve has long reached its limit, and it keeps products in 32 bits.
+#    define FIX16_VELOCITY_MAX (256L << 16)
+#    define FIX16_FROM_FLOAT(val) ((fix16_t)((val) * (float)FIX16_ONE))
+#    define FIX16_TO_FLOAT(val) ((float)(val) / FIX16_ONE)
+// dpi correction numerator: 100 / DEVICE_CPI_PARAM, folded at compile time
+#    define FIX16_DPI_CORRECTION ((uint32_t)(100.0 / DEVICE_CPI_PARAM * FIX16_ONE))
+
+static inline fix16_t fix16_mul(fix16_t a, fix16_t b) {
+    return (fix16_t)(((int64_t)a * b) >> 16);
+}
+
+// 2^-x for x >= 0, result in (0, 1]
+static fix16_t fix16_exp2_neg(fix16_t x) {
+    if (x >= (16L << 16)) {
+        return 0; // below Q16 resolution
+    }
+    const uint32_t f = x & 0xFFFF;
+    // 2^-f ~= 1 - f*(b1 - f*(b2 - f*(b3 - f*b4))), all terms positive, fits unsigned 32-bit
+    uint32_t acc = 3500 - ((f * 455) >> 16);
+    acc          = 15699 - ((f * acc) >> 16);
+    acc          = 45421 - ((f * acc) >> 16);
+    acc          = FIX16_ONE - ((f * acc) >> 16);
+    return acc >> (x >> 16);
+}
+
+// log2(1 + x) for x in [0, 1], result in [0, 1]
+static fix16_t fix16_log2_1p(fix16_t x) {
+    const uint32_t f = x < FIX16_ONE ? x : FIX16_ONE - 1;
+    // ln(1+f) ~= f*(c1 - f*(c2 - f*(c3 - f*(c4 - f*c5))))
+    uint32_t acc = 8830 - ((f * 2084) >> 16);
+    acc          = 18870 - ((f * acc) >> 16);
+    acc          = 32192 - ((f * acc) >> 16);
+    acc          = 65496 - ((f * acc) >> 16);
+    acc          = (f * acc) >> 16;
+    return (acc * (FIX16_LOG2E / 2)) >> 15;
+}
+
+// log2(1 + 2^w), the base-2 softplus
+static fix16_t fix16_softplus2(fix16_t w) {
+    if (w >= 0) {
+        return w + fix16_log2_1p(fix16_exp2_neg(w));
+    }
+    return fix16_log2_1p(fix16_exp2_neg(-w));
+}
+
+// sqrt(x^2 + y^2) in Q8, by bitwise integer square root (exact to the last bit for 8-bit reports)
+static uint32_t fix16_norm_q8(int16_t x, int16_t y) {
+    uint32_t sq    = (uint32_t)((int32_t)x * x) + (uint32_t)((int32_t)y * y); // 2^31 at most, for extended reports
+    uint8_t  shift = 16; // pre-scale by 2^16 for 8 fractional bits, less when that would overflow
+    while (shift && (sq >> (32 - shift))) {
+        shift -= 2;
+    }
+    sq <<= shift;
+    uint32_t root = 0;
+    for (uint32_t bit = 1UL << 30; bit; bit >>= 2) {
+        if (sq >= root + bit) {
+            sq -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
         }
-        // time since last mouse report:
-        uint16_t delta_time = timer_elapsed32(maccel_timer);
-        maccel_timer        = timer_read32();
-        // get device cpi setting, only call when mouse hasn't moved since more than 200ms
-        static uint16_t device_cpi = 300;
-        if (delta_time > 200) {
+    }
+    return root << (8 - shift / 2);
+}
+
+#endif // MACCEL_USE_FIXED_POINT
+
+#ifdef MACCEL_USE_LUT
+#    ifndef MACCEL_LUT_SIZE
+#        define MACCEL_LUT_SIZE 128 // table entries, 2 bytes of RAM each
+#    endif
+#    ifndef MACCEL_LUT_RESOLUTION
+#        define MACCEL_LUT_RESOLUTION 4 // entries per unit of velocity, so the table spans 0..(SIZE-1)/RESOLUTION
+#    endif
+#    ifndef MACCEL_LUT_REBUILD_BATCH
+#        define MACCEL_LUT_REBUILD_BATCH 16 // entries refilled per housekeeping call after a change
+#    endif
+_Static_assert(MACCEL_LUT_SIZE >= 2 && MACCEL_LUT_SIZE <= 4096, "MACCEL_LUT_SIZE out of range");
+_Static_assert(MACCEL_LUT_RESOLUTION >= 1 && MACCEL_LUT_RESOLUTION <= 64, "MACCEL_LUT_RESOLUTION out of range");
+#endif // MACCEL_USE_LUT
+
+#if defined(MACCEL_USE_FIXED_POINT) || defined(MACCEL_USE_LUT) || defined(MACCEL_USE_DRAGSCROLL)
+#    define MACCEL_FACTOR_ONE (1 << 12) // integer factors are Q4.12, enough for limits up to 16
+
+// scale a report axis by a Q4.12 factor, truncating towards zero like the float path
+static inline mouse_xy_report_t maccel_scale_report(mouse_xy_report_t val, uint16_t factor) {
+    const int32_t scaled = (int32_t)val * factor / MACCEL_FACTOR_ONE;
+    return CONSTRAIN_REPORT(scaled);
+}
+#endif
+
+#ifndef MACCEL_VELOCITY_WINDOW
+#    define MACCEL_VELOCITY_WINDOW 4 // reports averaged into the velocity estimate
+#endif
+#ifndef MACCEL_VELOCITY_IDLE_MS
+#    define MACCEL_VELOCITY_IDLE_MS 50 // a longer pause between reports starts a new movement
+#endif
+_Static_assert((MACCEL_VELOCITY_WINDOW & (MACCEL_VELOCITY_WINDOW - 1)) == 0 && MACCEL_VELOCITY_WINDOW <= 32, "MACCEL_VELOCITY_WINDOW must be a power of two, at most 32");
+_Static_assert(MACCEL_VELOCITY_IDLE_MS >= 1 && MACCEL_VELOCITY_IDLE_MS <= 65, "MACCEL_VELOCITY_IDLE_MS out of range");
+
+#define MACCEL_VELOCITY_IDLE_US (MACCEL_VELOCITY_IDLE_MS * 1000U)
+#define MACCEL_VELOCITY_MIN_US 125 // shortest USB polling interval, keeps the velocity finite
+
+/* Velocity window
+ *
+ * The last MACCEL_VELOCITY_WINDOW reports, as distance (Q8) and time since the report before (us).
+ * Velocity is the window's total distance over its total time, kept as running sums so each report
+ * costs the same regardless of window size. A pause of MACCEL_VELOCITY_IDLE_MS empties the window.
+ */
+static struct {
+    uint32_t timer; // ms, catches pauses longer than the tick counter's wrap-around
+    uint32_t ticks;
+    uint32_t sum_distance;
+    uint32_t sum_time;
+    uint32_t distance[MACCEL_VELOCITY_WINDOW];
+    uint16_t time[MACCEL_VELOCITY_WINDOW];
+    uint8_t  head;
+    bool     restart;
+    bool     given;    // the next elapsed time is `given_us`, see `maccel_report_elapsed()`
+    uint16_t given_us;
+} maccel_window;
+
+// microseconds since the previous report, at most MACCEL_VELOCITY_IDLE_US (meaning a pause)
+static uint16_t maccel_window_elapsed(void) {
+    const uint32_t ticks   = MACCEL_TIMER_TICKS();
+    uint32_t       elapsed = (ticks - maccel_window.ticks) / MACCEL_TIMER_TICKS_PER_US;
+    if (elapsed > MACCEL_VELOCITY_IDLE_US || timer_elapsed32(maccel_window.timer) > 1000) {
+        elapsed = MACCEL_VELOCITY_IDLE_US;
+    }
+    maccel_window.ticks = ticks;
+    maccel_window.timer = timer_read32();
+    if (maccel_window.given) {
+        // measured where the motion was read, not where it arrived
+        elapsed             = maccel_window.given_us < MACCEL_VELOCITY_IDLE_US ? maccel_window.given_us : MACCEL_VELOCITY_IDLE_US;
+        maccel_window.given = false;
+    }
+    return elapsed;
+}
+
+void maccel_report_elapsed(uint16_t elapsed_us) {
+    maccel_window.given_us = elapsed_us;
+    maccel_window.given    = true;
+}
+
+static void maccel_window_push(uint32_t distance, uint16_t elapsed) {
+    if (maccel_window.restart) {
+        maccel_window.sum_distance = 0;
+        maccel_window.sum_time     = 0;
+        maccel_window.restart      = false;
+    }
+    if (elapsed >= MACCEL_VELOCITY_IDLE_US) {
+        // the first report after a pause took an unknown time: measure it alone, as slow, and leave it out
+        memset(maccel_window.distance, 0, sizeof(maccel_window.distance));
+        memset(maccel_window.time, 0, sizeof(maccel_window.time));
+        maccel_window.sum_distance = distance;
+        maccel_window.sum_time     = elapsed;
+        maccel_window.restart      = true;
+        return;
+    }
+    const uint8_t i = maccel_window.head++ & (MACCEL_VELOCITY_WINDOW - 1);
+    maccel_window.sum_distance += distance - maccel_window.distance[i];
+    maccel_window.sum_time += elapsed - maccel_window.time[i];
+    maccel_window.distance[i] = distance;
+    maccel_window.time[i]     = elapsed;
+}
+
+static uint32_t maccel_window_time(void) {
+    return maccel_window.sum_time > MACCEL_VELOCITY_MIN_US ? maccel_window.sum_time : MACCEL_VELOCITY_MIN_US;
+}
+
+// window velocity in Q8 (sensor counts per ms, no dpi correction)
+static uint32_t maccel_window_velocity(void) {
+    const uint32_t distance = maccel_window.sum_distance;
+    if (distance <= UINT32_MAX / 1000) {
+        return distance * 1000 / maccel_window_time();
+    }
+    return (uint64_t)distance * 1000 / maccel_window_time();
+}
+
+/* Values derived from the device CPI, shared by all profiles.
+ *
+ * The CPI is read from the sensor only after `maccel_cpi_changed()`, from
+ * `housekeeping_task_maccel()`, so that the first report of a movement does no bus traffic.
+ */
+static struct {
+    bool     cpi_stale;
+    uint16_t cpi;
+#if !defined(MACCEL_USE_FIXED_POINT) || defined(MACCEL_DEBUG)
+    float dpi_correction;
+#endif
+#ifdef MACCEL_USE_FIXED_POINT
+    uint32_t dpi_correction_q16;
+    uint32_t velocity_raw_max; // Q8, beyond which velocity saturates (and products would overflow)
+#endif
+} maccel_cache = {.cpi_stale = true};
+
+/* Profiles: values derived from each curve in `g_maccel_profiles`.
+ *
+ * A config only changes through the setters, the keycodes or VIA, so everything its curve needs
+ * besides velocity is computed once after `maccel_config_changed()`, instead of on every report.
+ * All profiles are kept computed by `housekeeping_task_maccel()`, so switching between them
+ * only moves the `maccel_active` pointer.
+ */
+typedef struct {
+    bool dirty;
+#if !defined(MACCEL_USE_FIXED_POINT) || defined(MACCEL_DEBUG)
+    struct {
+        float offset;
+        float limit;
+        float limit_m1;
+        float takeoff;
+        float growth_per_takeoff;
+    } flt;
+#endif
+#ifdef MACCEL_USE_FIXED_POINT
+    struct {
+        fix16_t offset;
+        fix16_t limit;
+        fix16_t limit_m1;
+        fix16_t takeoff;
+        fix16_t growth_per_takeoff;
+    } fix;
+#endif
+#ifdef MACCEL_USE_LUT
+    uint16_t lut_filled;
+    uint16_t lut[MACCEL_LUT_SIZE]; // factor (Q4.12) at velocity i/MACCEL_LUT_RESOLUTION
+#endif
+} maccel_profile_t;
+
+static maccel_profile_t  maccel_profiles[MACCEL_PROFILE_COUNT] = {[0 ... MACCEL_PROFILE_COUNT - 1] = {.dirty = true}};
+static maccel_profile_t *maccel_active                         = &maccel_profiles[0];
+static uint8_t           maccel_profile_index                  = 0; // of maccel_active
+static uint8_t           maccel_profile_selected               = 0;
+static uint8_t           maccel_profile_forced                 = MACCEL_PROFILE_NONE;
+
+static void maccel_profile_activate(void) {
+    maccel_profile_index = maccel_profile_forced != MACCEL_PROFILE_NONE ? maccel_profile_forced : maccel_profile_selected;
+    maccel_active        = &maccel_profiles[maccel_profile_index];
+}
+
+void maccel_profile_select(uint8_t profile) {
+    if (profile < MACCEL_PROFILE_COUNT) {
+        maccel_profile_selected = profile;
+        maccel_profile_activate();
+    }
+}
+
+void maccel_profile_override(uint8_t profile) {
+    if (profile < MACCEL_PROFILE_COUNT || profile == MACCEL_PROFILE_NONE) {
+        maccel_profile_forced = profile;
+        maccel_profile_activate();
+    }
+}
+
+uint8_t maccel_profile_get(void) {
+    return maccel_profile_index;
+}
+
+uint8_t maccel_profile_get_override(void) {
+    return maccel_profile_forced;
+}
+
+maccel_config_t *maccel_profile_config(void) {
+    return &g_maccel_profiles[maccel_profile_index];
+}
+
+void maccel_config_changed(void) {
+    maccel_active->dirty = true;
+}
+
+void maccel_profiles_changed(void) {
+    for (uint8_t i = 0; i < MACCEL_PROFILE_COUNT; i++) {
+        maccel_profiles[i].dirty = true;
+    }
+}
+
+static void maccel_cache_set_cpi(uint16_t device_cpi) {
+    maccel_cache.cpi = device_cpi;
+#if !defined(MACCEL_USE_FIXED_POINT) || defined(MACCEL_DEBUG)
+    // dpi correction factor (for normalizing velocity range across different user dpi settings)
+    maccel_cache.dpi_correction = (float)100.0f / (DEVICE_CPI_PARAM * (device_cpi ? device_cpi : 1));
+#endif
+#ifdef MACCEL_USE_FIXED_POINT
+    maccel_cache.dpi_correction_q16 = FIX16_DPI_CORRECTION / (device_cpi ? device_cpi : 1);
+    maccel_cache.velocity_raw_max   = UINT32_MAX / (maccel_cache.dpi_correction_q16 ? maccel_cache.dpi_correction_q16 : 1);
+#endif
+}
+
+void maccel_cpi_changed(void) {
+    maccel_cache.cpi_stale = true;
+}
+
+static void maccel_cpi_refresh(void) {
+    maccel_cache.cpi_stale = false;
 #ifdef POINTING_DEVICE_DRIVER_azoteq_iqs5xx
-            wait_ms(2);
+    wait_ms(2);
 #endif // POINTING_DEVICE_DRIVER_azoteq_iqs5xx
-            device_cpi = pointing_device_get_cpi();
-#ifdef POINTING_DEVICE_DRIVER_pmw3360
-            // janky bug-fix for PMW3360
-            pointing_device_set_cpi(device_cpi);
-#endif // POINTING_DEVICE_DRIVER_pmw3360
+    const uint16_t device_cpi = pointing_device_get_cpi();
+#if defined(POINTING_DEVICE_DRIVER_pmw3360) || defined(POINTING_SCHEDULER_ENABLE)
+    // janky bug-fix for PMW3360 (behind the scheduler, it is the custom driver)
+    pointing_device_set_cpi(device_cpi);
+#endif // POINTING_DEVICE_DRIVER_pmw3360 || POINTING_SCHEDULER_ENABLE
+    maccel_cache_set_cpi(device_cpi);
+}
+
+/* Parameter bounds
+ *
+ * The setters refuse values below these, but VIA's config block and the EEPROM hand over any
+ * float, NaN and infinity included. Parameters are held to the bounds when a profile is derived,
+ * so that each engine's arithmetic stays finite (and in range for Q16 and Q4.12) whatever the
+ * config holds; NaN falls back to the default.
+ */
+#define MACCEL_TAKEOFF_MIN 0.5f
+#define MACCEL_TAKEOFF_MAX 64.0f
+#define MACCEL_GROWTH_RATE_MAX 64.0f
+#define MACCEL_OFFSET_MAX 64.0f // either way
+#define MACCEL_LIMIT_MIN 1.0f
+#ifdef MACCEL_FACTOR_ONE
+#    define MACCEL_LIMIT_MAX (16.0f - 1.0f / MACCEL_FACTOR_ONE) // largest Q4.12 factor
+#else
+#    define MACCEL_LIMIT_MAX 64.0f
+#endif
+
+static float maccel_param(float val, float low, float high, float fallback) {
+    if (val != val) {
+        return fallback;
+    }
+    return _CONSTRAIN(val, low, high);
+}
+
+static void maccel_profile_refresh(maccel_profile_t *profile, const maccel_config_t *config) {
+    profile->dirty          = false;
+#ifdef MACCEL_TELEMETRY_ENABLE
+    maccel_telemetry_params(profile - maccel_profiles, config);
+#endif
+    const float takeoff     = maccel_param(config->takeoff, MACCEL_TAKEOFF_MIN, MACCEL_TAKEOFF_MAX, MACCEL_TAKEOFF);
+    const float growth_rate = maccel_param(config->growth_rate, 0, MACCEL_GROWTH_RATE_MAX, MACCEL_GROWTH_RATE);
+    const float offset      = maccel_param(config->offset, -MACCEL_OFFSET_MAX, MACCEL_OFFSET_MAX, MACCEL_OFFSET);
+    const float limit       = maccel_param(config->limit, MACCEL_LIMIT_MIN, MACCEL_LIMIT_MAX, MACCEL_LIMIT);
+#if !defined(MACCEL_USE_FIXED_POINT) || defined(MACCEL_DEBUG)
+    profile->flt.offset             = offset;
+    profile->flt.limit              = limit;
+    profile->flt.limit_m1           = limit - 1;
+    profile->flt.takeoff            = takeoff;
+    profile->flt.growth_per_takeoff = growth_rate / takeoff;
+#endif
+#ifdef MACCEL_USE_FIXED_POINT
+    profile->fix.offset             = FIX16_FROM_FLOAT(offset);
+    profile->fix.limit              = FIX16_FROM_FLOAT(limit);
+    profile->fix.limit_m1           = profile->fix.limit - FIX16_ONE;
+    profile->fix.takeoff            = FIX16_FROM_FLOAT(takeoff);
+    profile->fix.growth_per_takeoff = FIX16_FROM_FLOAT(growth_rate / takeoff);
+#endif
+#ifdef MACCEL_USE_LUT
+    profile->lut_filled = 0;
+#endif
+}
+
+#ifdef MACCEL_USE_FIXED_POINT
+// dpi-corrected window velocity in Q16 (distance per ms)
+static fix16_t maccel_fixed_velocity(void) {
+    const uint32_t velocity_raw = maccel_window_velocity();
+    if (velocity_raw >= maccel_cache.velocity_raw_max) {
+        return FIX16_VELOCITY_MAX;
+    }
+    return (velocity_raw * maccel_cache.dpi_correction_q16) >> 8;
+}
+
+// f(v) = c - (c-1) * (1 + e^(x(v-b)))^(-y/x), in Q16
+static fix16_t maccel_fixed_factor(const maccel_profile_t *profile, fix16_t velocity) {
+    // same exponent argument as `maccel_float_factor()`; at most 64 * (256 + 64), so even in
+    // base 2 it fits Q16, and below -64 the curve is 1 to the last bit
+    fix16_t exponent = fix16_mul(profile->fix.takeoff, velocity - profile->fix.offset);
+    exponent         = exponent < -(64L << 16) ? -(64L << 16) : exponent;
+    // the growth rate can take y past Q16, where 2^-y is long gone
+    const int64_t y = ((int64_t)profile->fix.growth_per_takeoff * fix16_softplus2(fix16_mul(exponent, FIX16_LOG2E))) >> 16;
+    if (y >= (16L << 16)) {
+        return profile->fix.limit;
+    }
+    return profile->fix.limit - fix16_mul(profile->fix.limit_m1, fix16_exp2_neg((fix16_t)y));
+}
+#endif // MACCEL_USE_FIXED_POINT
+
+#if !defined(MACCEL_USE_FIXED_POINT) || defined(MACCEL_DEBUG)
+// f(v) = c - ((c-1) / ((1 + e^(x(v - b))) ^ (y/x)))
+static float maccel_float_factor(const maccel_profile_t *profile, float velocity) {
+    const float exponent = profile->flt.takeoff * (velocity - profile->flt.offset);
+    if (exponent > 80.0f) {
+        // 1 + e^exponent is e^exponent to the last bit, and soon past what `expf()` can return
+        return profile->flt.limit - profile->flt.limit_m1 * expf(-exponent * profile->flt.growth_per_takeoff);
+    }
+    return profile->flt.limit - profile->flt.limit_m1 / powf(1 + expf(exponent), profile->flt.growth_per_takeoff);
+}
+#endif
+
+#ifdef MACCEL_USE_LUT
+// (re)fill up to `count` table entries, sampling whichever engine is compiled in
+static void maccel_lut_fill(maccel_profile_t *profile, uint16_t count) {
+    for (; count && profile->lut_filled < MACCEL_LUT_SIZE; count--) {
+        const uint16_t i = profile->lut_filled++;
+#    ifdef MACCEL_USE_FIXED_POINT
+        const int32_t factor = maccel_fixed_factor(profile, ((fix16_t)i << 16) / MACCEL_LUT_RESOLUTION) >> 4;
+#    else
+        const float factor = maccel_float_factor(profile, (float)i / MACCEL_LUT_RESOLUTION) * MACCEL_FACTOR_ONE;
+#    endif
+        profile->lut[i] = _CONSTRAIN(factor, 0, UINT16_MAX);
+    }
+}
+
+// Q4.12 factor at a table position in Q8 (entry index and fraction), interpolated linearly
+static uint16_t maccel_lut_factor(const maccel_profile_t *profile, uint32_t position) {
+    if (position >= (uint32_t)(MACCEL_LUT_SIZE - 1) << 8) {
+        return profile->lut[MACCEL_LUT_SIZE - 1];
+    }
+    const uint16_t *entry = &profile->lut[position >> 8];
+    return entry[0] + (((int32_t)entry[1] - entry[0]) * (int32_t)(position & 0xFF)) / 256;
+}
+#endif // MACCEL_USE_LUT
+
+#ifdef MACCEL_USE_DRAGSCROLL
+#    ifndef MACCEL_DRAGSCROLL_DIVISOR
+#        define MACCEL_DRAGSCROLL_DIVISOR 20 // sensor counts per wheel step, before acceleration
+#    endif
+#    ifndef MACCEL_DRAGSCROLL_OFFSET
+#        define MACCEL_DRAGSCROLL_OFFSET 2.0 // velocity (counts per ms) above which scrolling accelerates
+#    endif
+#    ifndef MACCEL_DRAGSCROLL_GROWTH_RATE
+#        define MACCEL_DRAGSCROLL_GROWTH_RATE 0.25 // factor gained per count/ms beyond the offset
+#    endif
+#    ifndef MACCEL_DRAGSCROLL_LIMIT
+#        define MACCEL_DRAGSCROLL_LIMIT 4.0 // upper limit of the scroll acceleration factor
+#    endif
+#    ifndef MACCEL_DRAGSCROLL_INTERVAL_MS
+#        define MACCEL_DRAGSCROLL_INTERVAL_MS 8 // wheel steps are collected for this long into one report
+#    endif
+#    define DRAGSCROLL_OFFSET_Q8 ((uint32_t)(MACCEL_DRAGSCROLL_OFFSET * 256))
+#    define DRAGSCROLL_GROWTH_Q12 ((uint32_t)(MACCEL_DRAGSCROLL_GROWTH_RATE * 4096))
+#    define DRAGSCROLL_LIMIT_Q12 ((uint32_t)(MACCEL_DRAGSCROLL_LIMIT * 4096))
+// velocity beyond the offset at which the limit is reached, in Q8
+#    define DRAGSCROLL_STEP (4096L * MACCEL_DRAGSCROLL_DIVISOR) // one wheel step, in counts times a Q12 factor
+#    define DRAGSCROLL_KNEE_Q8 ((uint32_t)((MACCEL_DRAGSCROLL_LIMIT - 1) / MACCEL_DRAGSCROLL_GROWTH_RATE * 256))
+#    define DRAGSCROLL_PENDING_MAX (INT32_MAX / 2) // far more than can ever be sent, keeps the sums in range
+#    ifdef HV_REPORT_MAX
+#        define DRAGSCROLL_REPORT_MAX HV_REPORT_MAX // steps in one report, more with WHEEL_EXTENDED_REPORT
+#    else
+#        define DRAGSCROLL_REPORT_MAX 127
+#    endif
+_Static_assert(MACCEL_DRAGSCROLL_DIVISOR >= 1, "MACCEL_DRAGSCROLL_DIVISOR must be at least 1");
+_Static_assert(DRAGSCROLL_GROWTH_Q12 > 0 && DRAGSCROLL_LIMIT_Q12 >= 4096 && DRAGSCROLL_LIMIT_Q12 < 65536, "MACCEL_DRAGSCROLL_GROWTH_RATE or MACCEL_DRAGSCROLL_LIMIT out of range");
+
+/* Drag-scroll stage
+ *
+ * While active, motion becomes wheel steps instead of pointer movement. The factor rises
+ * linearly with velocity past the offset, up to the limit, all in integer math and independent
+ * of the pointer curve. Accelerated motion accumulates per axis and only whole steps are sent,
+ * at most once per MACCEL_DRAGSCROLL_INTERVAL_MS; the remainder carries over, so slow scrolls
+ * lose no distance and fast ones send several steps per report.
+ *
+ * A step is a wheel detent, unless the host scales wheel reports by the HID resolution
+ * multiplier (`maccel_dragscroll_resolution()` above 1). Steps are then that many times finer,
+ * and go out with every report instead of being collected: scrolling is smooth, and starts
+ * with the first step's worth of motion instead of up to an interval later.
+ */
+static struct {
+    bool     active;
+    uint16_t resolution; // steps per detent the pending motion is counted in
+    uint32_t timer;      // last wheel report
+    int32_t  h;          // pending motion, DRAGSCROLL_STEP per step
+    int32_t  v;
+} maccel_dragscroll;
+
+void maccel_dragscroll_enable(bool enable) {
+    maccel_dragscroll.active = enable;
+    maccel_dragscroll.h      = 0;
+    maccel_dragscroll.v      = 0;
+}
+bool maccel_dragscroll_is_enabled(void) {
+    return maccel_dragscroll.active;
+}
+void maccel_dragscroll_toggle(void) {
+    maccel_dragscroll_enable(!maccel_dragscroll.active);
+}
+
+// Q4.12 scroll factor at a window velocity in Q8
+static uint16_t maccel_dragscroll_factor(uint32_t velocity) {
+    if (velocity <= DRAGSCROLL_OFFSET_Q8) {
+        return MACCEL_FACTOR_ONE;
+    }
+    const uint32_t excess = velocity - DRAGSCROLL_OFFSET_Q8;
+    if (excess >= DRAGSCROLL_KNEE_Q8) {
+        return DRAGSCROLL_LIMIT_Q12;
+    }
+    return MACCEL_FACTOR_ONE + ((excess * DRAGSCROLL_GROWTH_Q12) >> 8);
+}
+
+__attribute__((weak)) uint16_t maccel_dragscroll_resolution(void) {
+#    ifdef POINTING_DEVICE_HIRES_SCROLL_ENABLE
+    return pointing_device_get_hires_scroll_resolution();
+#    else
+    return 1;
+#    endif
+}
+
+// add motion times a Q12 factor to an accumulator, saturating, as extended reports could overflow it
+static void maccel_dragscroll_add(int32_t *pending, int32_t motion, int32_t factor) {
+    const int64_t sum = *pending + (int64_t)motion * factor;
+    *pending          = _CONSTRAIN(sum, -DRAGSCROLL_PENDING_MAX, DRAGSCROLL_PENDING_MAX);
+}
+
+// move whole steps out of an accumulator, leaving the remainder
+static int32_t maccel_dragscroll_take(int32_t *pending) {
+    const int32_t whole = *pending / DRAGSCROLL_STEP;
+    const int32_t steps = _CONSTRAIN(whole, -DRAGSCROLL_REPORT_MAX, DRAGSCROLL_REPORT_MAX);
+    *pending -= steps * DRAGSCROLL_STEP;
+    return steps;
+}
+
+// runs on every pointing device task while active, to also send steps left over when motion stopped
+static report_mouse_t maccel_dragscroll_task(report_mouse_t mouse_report) {
+    uint16_t resolution = maccel_dragscroll_resolution();
+    if (resolution == 0) {
+        resolution = 1;
+    }
+    if (resolution != maccel_dragscroll.resolution) {
+        // what is known of the host changed: pending motion was counted in the other steps
+        maccel_dragscroll.resolution = resolution;
+        maccel_dragscroll.h          = 0;
+        maccel_dragscroll.v          = 0;
+    }
+    if (mouse_report.x != 0 || mouse_report.y != 0) {
+        const uint16_t elapsed = maccel_window_elapsed();
+#    ifdef MACCEL_USE_FIXED_POINT
+        maccel_window_push(fix16_norm_q8(mouse_report.x, mouse_report.y), elapsed);
+#    else
+        maccel_window_push((uint32_t)(sqrtf((float)mouse_report.x * mouse_report.x + (float)mouse_report.y * mouse_report.y) * 256), elapsed);
+#    endif
+        const int32_t factor = maccel_dragscroll_factor(maccel_window_velocity());
+#    ifdef MACCEL_DRAGSCROLL_REVERSE_X
+        maccel_dragscroll_add(&maccel_dragscroll.h, -(int32_t)mouse_report.x * resolution, factor);
+#    else
+        maccel_dragscroll_add(&maccel_dragscroll.h, (int32_t)mouse_report.x * resolution, factor);
+#    endif
+#    ifdef MACCEL_DRAGSCROLL_REVERSE_Y
+        maccel_dragscroll_add(&maccel_dragscroll.v, -(int32_t)mouse_report.y * resolution, factor);
+#    else
+        maccel_dragscroll_add(&maccel_dragscroll.v, (int32_t)mouse_report.y * resolution, factor);
+#    endif
+        mouse_report.x = 0;
+        mouse_report.y = 0;
+    }
+    if (resolution == 1 && timer_elapsed32(maccel_dragscroll.timer) < MACCEL_DRAGSCROLL_INTERVAL_MS) {
+        return mouse_report;
+    }
+    const int32_t h = maccel_dragscroll_take(&maccel_dragscroll.h);
+    const int32_t v = maccel_dragscroll_take(&maccel_dragscroll.v);
+    if (h != 0 || v != 0) {
+        const int32_t report_h  = mouse_report.h + h;
+        const int32_t report_v  = mouse_report.v + v;
+        mouse_report.h          = _CONSTRAIN(report_h, -DRAGSCROLL_REPORT_MAX, DRAGSCROLL_REPORT_MAX);
+        mouse_report.v          = _CONSTRAIN(report_v, -DRAGSCROLL_REPORT_MAX, DRAGSCROLL_REPORT_MAX);
+        maccel_dragscroll.timer = timer_read32();
+    }
+    return mouse_report;
+}
+#endif // MACCEL_USE_DRAGSCROLL
+
+#ifdef MACCEL_WCET_ENABLE
+/* Worst-case timing: the code path of the report in progress, and the worst of each so far. */
+static struct {
+    maccel_path_t       path;
+    maccel_path_t       last_path;
+    uint32_t            last_ticks;
+    maccel_wcet_stats_t stats[MACCEL_PATH_COUNT];
+#    ifdef MACCEL_DEBUG
+    uint32_t printed_ticks[MACCEL_PATH_COUNT];
+#    endif
+} maccel_wcet;
+
+// a report taking several paths counts for the costliest, the last in `maccel_path_t`
+#    define MACCEL_WCET_PATH(val) (maccel_wcet.path = (val) > maccel_wcet.path ? (val) : maccel_wcet.path)
+
+static void maccel_wcet_record(uint32_t ticks) {
+    maccel_wcet_stats_t *const stats = &maccel_wcet.stats[maccel_wcet.path];
+    stats->calls++;
+    if (ticks > MACCEL_WCET_BUDGET_US * MACCEL_WCET_TICKS_PER_US) {
+        stats->over_budget++;
+    }
+    if (ticks > stats->max_ticks) {
+        stats->max_ticks = ticks;
+    }
+    maccel_wcet.last_path  = maccel_wcet.path;
+    maccel_wcet.last_ticks = ticks;
+}
+
+maccel_wcet_stats_t maccel_wcet_stats(maccel_path_t path) {
+    return path < MACCEL_PATH_COUNT ? maccel_wcet.stats[path] : (maccel_wcet_stats_t){0};
+}
+
+maccel_path_t maccel_wcet_last(uint32_t *ticks) {
+    *ticks = maccel_wcet.last_ticks;
+    return maccel_wcet.last_path;
+}
+
+void maccel_wcet_reset(void) {
+    memset(&maccel_wcet, 0, sizeof(maccel_wcet));
+}
+
+#    ifdef MACCEL_DEBUG
+// print each new worst case, outside the timed report path
+static void maccel_wcet_task(void) {
+    for (uint8_t i = 0; i < MACCEL_PATH_COUNT; i++) {
+        const maccel_wcet_stats_t *const stats = &maccel_wcet.stats[i];
+        if (stats->max_ticks > maccel_wcet.printed_ticks[i]) {
+            maccel_wcet.printed_ticks[i] = stats->max_ticks;
+            printf("MACCEL: wcet path %u: max %lu ticks, %lu of %lu reports over budget\n", i, stats->max_ticks, stats->over_budget, stats->calls);
+        }
+    }
+}
+#    endif
+#else
+#    define MACCEL_WCET_PATH(val)
+#endif // MACCEL_WCET_ENABLE
+
+#if defined(MACCEL_USE_FIXED_POINT) && defined(MACCEL_DEBUG)
+#    define MACCEL_SELFCHECK_SAMPLES 1024
+
+static bool maccel_selfcheck_pending; // set by the first report, so that a console is attached by then
+
+// Once per boot, print how far the fixed-point curve strays from the float one, and what each costs.
+static void maccel_fixed_selfcheck(void) {
+    static bool done = false;
+    if (done || !maccel_selfcheck_pending) {
+        return;
+    }
+    done = true;
+
+    float            max_error = 0, max_error_velocity = 0;
+    volatile float   sink_float;
+    volatile fix16_t sink_fixed;
+    for (uint16_t i = 0; i < MACCEL_SELFCHECK_SAMPLES; i++) {
+        const fix16_t velocity = (fix16_t)i << 10; // 0..64 in 1/64 steps
+        const float   error    = fabsf(FIX16_TO_FLOAT(maccel_fixed_factor(maccel_active, velocity)) - maccel_float_factor(maccel_active, FIX16_TO_FLOAT(velocity)));
+        if (error > max_error) {
+            max_error          = error;
+            max_error_velocity = FIX16_TO_FLOAT(velocity);
         }
-        // calculate dpi correction factor (for normalizing velocity range across different user dpi settings)
-        const float dpi_correction = (float)100.0f / (DEVICE_CPI_PARAM * device_cpi);
+    }
+    uint32_t timer = timer_read32();
+    for (uint16_t i = 0; i < MACCEL_SELFCHECK_SAMPLES; i++) {
+        sink_float = maccel_float_factor(maccel_active, (float)i / 64);
+    }
+    const uint32_t float_ms = timer_elapsed32(timer);
+    timer                   = timer_read32();
+    for (uint16_t i = 0; i < MACCEL_SELFCHECK_SAMPLES; i++) {
+        sink_fixed = maccel_fixed_factor(maccel_active, (fix16_t)i << 10);
+    }
+    const uint32_t fixed_ms = timer_elapsed32(timer);
+    (void)sink_float;
+    (void)sink_fixed;
+    printf("MACCEL: fixed-point max err: %.5f @v=%.3f | %d evals: float %lums, fixed %lums\n", max_error, max_error_velocity, MACCEL_SELFCHECK_SAMPLES, float_ms, fixed_ms);
+}
+#endif // MACCEL_USE_FIXED_POINT && MACCEL_DEBUG
+
+void housekeeping_task_maccel(void) {
+    if (maccel_cache.cpi_stale) {
+        maccel_cpi_refresh();
+    }
+    for (uint8_t i = 0; i < MACCEL_PROFILE_COUNT; i++) {
+        if (maccel_profiles[i].dirty) {
+            maccel_profile_refresh(&maccel_profiles[i], &g_maccel_profiles[i]);
+        }
+    }
+#ifdef MACCEL_USE_LUT
+    // rebuild tables in the background, a batch at a time, the active profile's first
+    maccel_profile_t *profile = maccel_active;
+    for (uint8_t i = 0; profile->lut_filled == MACCEL_LUT_SIZE && i < MACCEL_PROFILE_COUNT; i++) {
+        profile = &maccel_profiles[i];
+    }
+    maccel_lut_fill(profile, MACCEL_LUT_REBUILD_BATCH);
+#endif
+#ifdef MACCEL_VIA_ENABLE
+    maccel_config_save_task(timer_elapsed32(maccel_window.timer) >= MACCEL_VELOCITY_IDLE_MS);
+#endif
+#ifdef MACCEL_TRACE_ENABLE
+    maccel_trace_task();
+#endif
+#ifdef MACCEL_TELEMETRY_ENABLE
+    maccel_telemetry_task();
+#endif
+#if defined(MACCEL_WCET_ENABLE) && defined(MACCEL_DEBUG)
+    maccel_wcet_task();
+#endif
+#if defined(MACCEL_USE_FIXED_POINT) && defined(MACCEL_DEBUG)
+    maccel_fixed_selfcheck();
+#endif
+}
+
+static report_mouse_t maccel_task(report_mouse_t mouse_report) {
+#ifdef MACCEL_USE_DRAGSCROLL
+    if (maccel_dragscroll.active) { // scrolls whether pointer acceleration is enabled or not
+        MACCEL_WCET_PATH(MACCEL_PATH_DRAGSCROLL);
+        return maccel_dragscroll_task(mouse_report);
+    }
+#endif
+    if (mouse_report.x != 0 || mouse_report.y != 0) {
+        if (!g_maccel_profiles[maccel_profile_index].enabled) { // do nothing if not enabled
+            MACCEL_WCET_PATH(MACCEL_PATH_DISABLED);
+            return mouse_report;
+        }
+        // time since last mouse report, in us:
+        const uint16_t elapsed = maccel_window_elapsed();
+        MACCEL_WCET_PATH(elapsed >= MACCEL_VELOCITY_IDLE_US ? MACCEL_PATH_PAUSE : MACCEL_PATH_MOTION);
+        // a stale cpi is left to housekeeping, reading the sensor here only if it never ran yet
+        if (maccel_cache.cpi == 0) {
+            MACCEL_WCET_PATH(MACCEL_PATH_CPI_READ);
+            maccel_cpi_refresh();
+        }
+#ifdef MACCEL_TRACE_ENABLE
+        maccel_trace_record(mouse_report.x, mouse_report.y, elapsed, maccel_cache.cpi);
+#endif
+#ifdef MACCEL_TELEMETRY_ENABLE
+        // each movement starts with the curve it is accelerated on, for readers joining late
+        if (elapsed >= MACCEL_VELOCITY_IDLE_US) {
+            maccel_telemetry_params(maccel_profile_index, &g_maccel_profiles[maccel_profile_index]);
+        }
+#endif
+        // normally done by housekeeping already, unless the profile changed moments ago
+        maccel_profile_t *const profile = maccel_active;
+        if (profile->dirty) {
+            MACCEL_WCET_PATH(MACCEL_PATH_REFRESH);
+            maccel_profile_refresh(profile, &g_maccel_profiles[maccel_profile_index]);
+        }
+#ifdef MACCEL_USE_LUT
+        // finish a table rebuild the housekeeping task has not completed yet
+        MACCEL_WCET_PATH(profile->lut_filled < MACCEL_LUT_SIZE ? MACCEL_PATH_LUT_FILL : MACCEL_PATH_MOTION);
+        maccel_lut_fill(profile, MACCEL_LUT_SIZE);
+#endif
+#ifdef MACCEL_USE_FIXED_POINT
+        maccel_window_push(fix16_norm_q8(mouse_report.x, mouse_report.y), elapsed);
+        const fix16_t velocity_fixed = maccel_fixed_velocity();
+#    ifdef MACCEL_USE_LUT
+        const uint16_t maccel_factor_q12 = maccel_lut_factor(profile, ((uint32_t)velocity_fixed * MACCEL_LUT_RESOLUTION) >> 8);
+#    else
+        const uint16_t maccel_factor_q12 = maccel_fixed_factor(profile, velocity_fixed) >> 4;
+#    endif
+        const mouse_xy_report_t x = maccel_scale_report(mouse_report.x, maccel_factor_q12);
+        const mouse_xy_report_t y = maccel_scale_report(mouse_report.y, maccel_factor_q12);
+#else
         // calculate euclidean distance moved (sqrt(x^2 + y^2))
-        const float distance = sqrtf(mouse_report.x * mouse_report.x + mouse_report.y * mouse_report.y);
-        // calculate delta velocity: dv = distance/dt
-        const float velocity_raw = distance / delta_time;
+        const float distance = sqrtf((float)mouse_report.x * mouse_report.x + (float)mouse_report.y * mouse_report.y);
+        // calculate delta velocity over the window: dv = distance/dt (per ms)
+        maccel_window_push((uint32_t)(distance * 256), elapsed);
+        const float velocity_raw = maccel_window_velocity() / 256.0f;
         // correct raw velocity for dpi
-        const float velocity = dpi_correction * velocity_raw;
+        const float velocity = maccel_cache.dpi_correction * velocity_raw;
+#    ifdef MACCEL_USE_LUT
+        // look up mouse acceleration factor, table index plus fraction in Q8
+        const uint16_t maccel_factor_q12 = maccel_lut_factor(profile, velocity < (float)MACCEL_LUT_SIZE / MACCEL_LUT_RESOLUTION ? (uint32_t)(velocity * (MACCEL_LUT_RESOLUTION * 256.0f)) : UINT32_MAX);
+        const mouse_xy_report_t x        = maccel_scale_report(mouse_report.x, maccel_factor_q12);
+        const mouse_xy_report_t y        = maccel_scale_report(mouse_report.y, maccel_factor_q12);
+#    else
         // calculate mouse acceleration factor: f(dv) = c - ((c-1) / ((1 + e^(x(x - b)) * a/z)))
-        const float maccel_factor = g_maccel_config.limit - (g_maccel_config.limit - 1) / powf(1 + expf(g_maccel_config.takeoff * (velocity - g_maccel_config.limit)), g_maccel_config.growth_rate / g_maccel_config.takeoff);
+        const float maccel_factor = maccel_float_factor(profile, velocity);
         // calculate accelerated delta X and Y values and clamp:
         const mouse_xy_report_t x = CONSTRAIN_REPORT(mouse_report.x * maccel_factor);
         const mouse_xy_report_t y = CONSTRAIN_REPORT(mouse_report.y * maccel_factor);
+#    endif // MACCEL_USE_LUT
+#endif     // MACCEL_USE_FIXED_POINT
 
-// console output for debugging (enable/disable in config.h)
-#ifdef MACCEL_DEBUG
-        const float distance_out = sqrtf(x * x + y * y);
-        const float velocity_out = velocity * maccel_factor;
-        printf("MACCEL: DPI:%4i Tko: %.3f Grw: %.3f Ofs: %.3f Lmt: %.3f | Fct: %.3f v.in: %.3f v.out: %.3f d.in: %3i d.out: %3i\n", device_cpi, g_maccel_config.takeoff, g_maccel_config.growth_rate, g_maccel_config.offset, g_maccel_config.limit, maccel_factor, velocity, velocity_out, CONSTRAIN_REPORT(distance), CONSTRAIN_REPORT(distance_out));
-#endif // MACCEL_DEBUG
+#ifdef MACCEL_TELEMETRY_ENABLE
+        // what this report was accelerated with, for the drain to send on later
+        maccel_telemetry_record_t *const record = maccel_telemetry_claim(MACCEL_TELEMETRY_REPORT, maccel_profile_index);
+        if (record) {
+            record->report.cpi        = maccel_cache.cpi;
+            record->report.elapsed_us = elapsed;
+#    ifdef MACCEL_USE_FIXED_POINT
+            record->report.velocity_q16 = velocity_fixed;
+#    else
+            record->report.velocity_q16 = velocity < 65536.0f ? (uint32_t)(velocity * 65536.0f) : UINT32_MAX;
+#    endif
+#    if defined(MACCEL_USE_FIXED_POINT) || defined(MACCEL_USE_LUT)
+            record->report.factor_q16 = (uint32_t)maccel_factor_q12 << 4;
+#    else
+            record->report.factor_q16 = (uint32_t)(maccel_factor * 65536.0f);
+#    endif
+            record->report.in_x  = mouse_report.x;
+            record->report.in_y  = mouse_report.y;
+            record->report.out_x = x;
+            record->report.out_y = y;
+            maccel_telemetry_commit();
+        }
+#endif
+#if defined(MACCEL_USE_FIXED_POINT) && defined(MACCEL_DEBUG)
+        maccel_selfcheck_pending = true;
+#endif
 
         // report back accelerated values
         mouse_report.x = x;
@@ -176,6 +950,18 @@ report_mouse_t pointing_device_task_maccel(report_mouse_t mouse_report) {
     return mouse_report;
 }
 
+report_mouse_t pointing_device_task_maccel(report_mouse_t mouse_report) {
+#ifdef MACCEL_WCET_ENABLE
+    maccel_wcet.path     = MACCEL_PATH_IDLE;
+    const uint32_t start = MACCEL_WCET_TICKS();
+    mouse_report         = maccel_task(mouse_report);
+    maccel_wcet_record(MACCEL_WCET_TICKS() - start);
+    return mouse_report;
+#else
+    return maccel_task(mouse_report);
+#endif
+}
+
 #ifdef MACCEL_USE_KEYCODES
 static inline float get_mod_step(float step) {
     const uint8_t mod_mask = get_mods();
@@ -192,24 +978,20 @@ bool process_record_maccel(uint16_t keycode, keyrecord_t *record, uint16_t takeo
     if (record->event.pressed) {
         if (keycode == takeoff) {
             maccel_set_takeoff(maccel_get_takeoff() + get_mod_step(MACCEL_TAKEOFF_STEP));
-            printf("MACCEL:keycode: TKO: %.3f gro: %.3f ofs: %.3f lmt: %.3f\n", g_maccel_config.takeoff, g_maccel_config.growth_rate, g_maccel_config.limit, g_maccel_config.limit);
-            return false;
-        }
-        if (keycode == growth_rate) {
+        } else if (keycode == growth_rate) {
             maccel_set_growth_rate(maccel_get_growth_rate() + get_mod_step(MACCEL_GROWTH_RATE_STEP));
-            printf("MACCEL:keycode: tko: %.3f GRO: %.3f ofs: %.3f lmt: %.3f\n", g_maccel_config.takeoff, g_maccel_config.growth_rate, g_maccel_config.limit, g_maccel_config.limit);
-            return false;
-        }
-        if (keycode == offset) {
+        } else if (keycode == offset) {
             maccel_set_offset(maccel_get_offset() + get_mod_step(MACCEL_OFFSET_STEP));
-            printf("MACCEL:keycode: tko: %.3f gro: %.3f OFS: %.3f lmt: %.3f\n", g_maccel_config.takeoff, g_maccel_config.growth_rate, g_maccel_config.limit, g_maccel_config.limit);
-            return false;
-        }
-        if (keycode == limit) {
+        } else if (keycode == limit) {
             maccel_set_limit(maccel_get_limit() + get_mod_step(MACCEL_LIMIT_STEP));
-            printf("MACCEL:keycode: tko: %.3f gro: %.3f ofs: %.3f LMT: %.3f\n", g_maccel_config.takeoff, g_maccel_config.growth_rate, g_maccel_config.limit, g_maccel_config.limit);
-            return false;
+        } else {
+            return true;
         }
+        // the new curve shows in telemetry once housekeeping has derived it
+#ifdef MACCEL_VIA_ENABLE
+        maccel_config_save();
+#endif
+        return false;
     }
     return true;
 }
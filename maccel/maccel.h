@@ -30,7 +30,26 @@ typedef struct _maccel_config_t {
     bool  enabled;
 } maccel_config_t;
 
-extern maccel_config_t g_maccel_config;
+#ifndef MACCEL_PROFILE_COUNT
+#    define MACCEL_PROFILE_COUNT 1 // curves to switch between, see `maccel_profile_select()`
+#endif
+#define MACCEL_PROFILE_NONE 0xFF
+
+// a profile in `MACCEL_PROFILES`, e.g. `[1] = MACCEL_CONFIG(1.2, 0.5, 5.0, 4.0)`
+#define MACCEL_CONFIG(tko, grw, ofs, lmt) {.growth_rate = (grw), .offset = (ofs), .limit = (lmt), .takeoff = (tko), .enabled = true}
+
+extern maccel_config_t g_maccel_profiles[MACCEL_PROFILE_COUNT];
+
+// the active profile, which the getters, setters, keycodes and VIA work on
+maccel_config_t *maccel_profile_config(void);
+#define g_maccel_config (*maccel_profile_config())
+
+// the profile in use when not overridden, e.g. picked by layer or pointer mode
+void maccel_profile_select(uint8_t profile);
+// use this profile regardless of the selection, MACCEL_PROFILE_NONE to stop
+void    maccel_profile_override(uint8_t profile);
+uint8_t maccel_profile_get(void);
+uint8_t maccel_profile_get_override(void);
 
 void maccel_enabled(bool enable);
 bool maccel_get_enabled(void);
@@ -40,9 +59,152 @@ float maccel_get_takeoff(void);
 float maccel_get_growth_rate(void);
 float maccel_get_offset(void);
 float maccel_get_limit(void);
-void  maccel_set_growth_rate(float val);
+void  maccel_set_takeoff(float val);
 void  maccel_set_growth_rate(float val);
 void  maccel_set_offset(float val);
 void  maccel_set_limit(float val);
 
+// call after writing `g_maccel_config` (the active profile) directly, so derived values get recomputed
+void maccel_config_changed(void);
+// same, after writing any of `g_maccel_profiles`
+void maccel_profiles_changed(void);
+// call whenever the sensor CPI changes (DPI keys, sniping, drag-scroll...), so it gets read again
+void maccel_cpi_changed(void);
+// the next report with motion was read this long after the one before, on the half with the
+// sensor (see `split_motion.h`): its velocity is measured with that instead of with the time
+// between the two reports arriving here
+void maccel_report_elapsed(uint16_t elapsed_us);
+
+#ifdef MACCEL_USE_DRAGSCROLL
+void maccel_dragscroll_enable(bool enable);
+bool maccel_dragscroll_is_enabled(void);
+void maccel_dragscroll_toggle(void);
+// wheel steps per detent the host takes: by default the HID resolution multiplier with
+// POINTING_DEVICE_HIRES_SCROLL_ENABLE, else 1; override for hosts that do not negotiate it
+uint16_t maccel_dragscroll_resolution(void);
+#endif
+
+/* High-resolution timebase
+ *
+ * `timer_read32()` counts milliseconds, so at 1 kHz the time between two reports reads as 0 or 1
+ * and the velocity jumps accordingly. Where the MCU has a faster free-running counter, report
+ * intervals (and EEPROM write stalls) are measured with it instead: the keymap's shared
+ * timebase (see `timebase.h`). Override both macros for other counters.
+ */
+#ifndef MACCEL_TIMER_TICKS
+#    include "timebase.h"
+#    define MACCEL_TIMER_TICKS() TIMEBASE_TICKS()
+#    define MACCEL_TIMER_TICKS_PER_US TIMEBASE_TICKS_PER_US
+#endif
+
+#ifdef MACCEL_WCET_ENABLE
+/* Worst-case timing of `pointing_device_task_maccel()`
+ *
+ * Each report is timed with MACCEL_WCET_TICKS (the DWT cycle counter on Cortex-M3 and up, the
+ * microsecond timer otherwise) and counted against the code path it took: the longest time seen,
+ * and how many reports took more than MACCEL_WCET_BUDGET_US. With MACCEL_DEBUG, each new
+ * maximum is printed from housekeeping. `host/maccel_wcet` drives adversarial input through it.
+ */
+#    ifndef MACCEL_WCET_TICKS
+#        define MACCEL_WCET_TICKS() MACCEL_TIMER_TICKS()
+#        define MACCEL_WCET_TICKS_PER_US MACCEL_TIMER_TICKS_PER_US
+#    endif
+#    ifndef MACCEL_WCET_BUDGET_US
+#        define MACCEL_WCET_BUDGET_US 1000 // one USB frame at 1 kHz
+#    endif
+
+typedef enum {
+    MACCEL_PATH_IDLE,       // no motion
+    MACCEL_PATH_DISABLED,   // motion, acceleration off
+    MACCEL_PATH_DRAGSCROLL, // anything while drag-scrolling
+    MACCEL_PATH_MOTION,     // the usual accelerated report
+    MACCEL_PATH_PAUSE,      // the first after a pause, restarting the velocity window
+    MACCEL_PATH_REFRESH,    // the profile changed moments ago and is derived again
+    MACCEL_PATH_LUT_FILL,   // its table is refilled too
+    MACCEL_PATH_CPI_READ,   // the CPI is read from the sensor, housekeeping never having run
+    MACCEL_PATH_COUNT,
+} maccel_path_t;
+
+typedef struct {
+    uint32_t calls;
+    uint32_t over_budget;
+    uint32_t max_ticks;
+} maccel_wcet_stats_t;
+
+maccel_wcet_stats_t maccel_wcet_stats(maccel_path_t path);
+// the path and time of the latest report
+maccel_path_t maccel_wcet_last(uint32_t *ticks);
+void          maccel_wcet_reset(void);
+#endif
+
 void keyboard_post_init_maccel(void);
+void housekeeping_task_maccel(void);
+
+#ifdef MACCEL_VIA_ENABLE
+typedef struct {
+    uint16_t writes;       // EEPROM writes since boot
+    uint16_t rejected;     // stored blocks rejected at boot (bad CRC or version)
+    uint32_t stall_us;     // total time spent writing
+    uint32_t stall_max_us; // longest single write
+} maccel_eeconfig_stats_t;
+
+// persist `g_maccel_config`, once no change and no pointer motion happened for a while
+void                    maccel_config_save(void);
+void                    maccel_config_save_task(bool pointer_idle);
+maccel_eeconfig_stats_t maccel_eeconfig_stats(void);
+#endif
+
+#ifdef MACCEL_TRACE_ENABLE
+void    maccel_trace_start(void);
+void    maccel_trace_stop(void);
+void    maccel_trace_toggle(void);
+bool    maccel_trace_is_recording(void);
+uint8_t maccel_trace_read(uint8_t *data, uint8_t length);
+void    maccel_trace_record(int16_t x, int16_t y, uint16_t elapsed_us, uint16_t cpi);
+void    maccel_trace_task(void);
+#endif
+
+#ifdef MACCEL_TELEMETRY_ENABLE
+/* Telemetry: what each report was accelerated with, as fixed-size binary records.
+ *
+ * A record is claimed in a RAM ring, filled in place and committed, a few dozen cycles per
+ * report; the ring is drained outside the report path (see `maccel_telemetry.c`), and
+ * `host/maccel_trace_decode -x` turns the records into CSV.  Little endian, 24 bytes each.
+ */
+typedef enum {
+    MACCEL_TELEMETRY_REPORT = 1,
+    MACCEL_TELEMETRY_PARAMS = 2,
+} maccel_telemetry_kind_t;
+
+typedef struct {
+    uint8_t  kind;    // maccel_telemetry_kind_t
+    uint8_t  profile; // the record's profile
+    uint16_t dropped; // records lost to a full ring just before this one
+    union {
+        struct {
+            uint16_t cpi;
+            uint16_t elapsed_us;   // since the previous report
+            uint32_t velocity_q16; // counts/ms, CPI-corrected, Q16
+            uint32_t factor_q16;   // acceleration factor, Q16
+            int16_t  in_x, in_y;   // sensor deltas
+            int16_t  out_x, out_y; // accelerated deltas
+        } report;
+        struct {
+            float takeoff;
+            float growth_rate;
+            float offset;
+            float limit;
+        } params;
+    };
+} maccel_telemetry_record_t;
+
+_Static_assert(sizeof(maccel_telemetry_record_t) == 24, "maccel_telemetry_record_t layout changed");
+
+// a free record in the ring, or NULL when it is full; `maccel_telemetry_commit()` publishes it
+maccel_telemetry_record_t *maccel_telemetry_claim(maccel_telemetry_kind_t kind, uint8_t profile);
+void                       maccel_telemetry_commit(void);
+void                       maccel_telemetry_params(uint8_t profile, const maccel_config_t *config);
+// whole records, as many as fit into `length` bytes; the number of bytes copied
+uint8_t maccel_telemetry_read(uint8_t *data, uint8_t length);
+void    maccel_telemetry_task(void);
+#endif
@@ -0,0 +1,101 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "quantum.h" // IWYU pragma: keep
+#include "maccel.h"
+
+/* Telemetry ring
+ *
+ * One writer, the report path, and one reader, the drain (console dump or VIA): the writer
+ * only moves the head, the reader only the tail, each a single byte store, so neither ever
+ * waits for the other nor sees a record half written.  When the ring is full, reports are
+ * dropped, and the number dropped goes out with the next record that fits.
+ */
+
+#ifndef MACCEL_TELEMETRY_RECORDS
+#    define MACCEL_TELEMETRY_RECORDS 64
+#endif
+_Static_assert((MACCEL_TELEMETRY_RECORDS & (MACCEL_TELEMETRY_RECORDS - 1)) == 0 && MACCEL_TELEMETRY_RECORDS <= 128, "MACCEL_TELEMETRY_RECORDS must be a power of two, at most 128");
+
+#define TELEMETRY_MASK (MACCEL_TELEMETRY_RECORDS - 1)
+
+static maccel_telemetry_record_t telemetry_ring[MACCEL_TELEMETRY_RECORDS];
+static uint8_t                   telemetry_head; // free-running, moved by the writer
+static uint8_t                   telemetry_tail; // free-running, moved by the reader
+static uint16_t                  telemetry_dropped;
+
+maccel_telemetry_record_t *maccel_telemetry_claim(maccel_telemetry_kind_t kind, uint8_t profile) {
+    const uint8_t head = telemetry_head;
+    if ((uint8_t)(head - __atomic_load_n(&telemetry_tail, __ATOMIC_ACQUIRE)) == MACCEL_TELEMETRY_RECORDS) {
+        if (telemetry_dropped < UINT16_MAX) {
+            telemetry_dropped++;
+        }
+        return NULL;
+    }
+    maccel_telemetry_record_t *const record = &telemetry_ring[head & TELEMETRY_MASK];
+    record->kind                            = kind;
+    record->profile                         = profile;
+    record->dropped                         = telemetry_dropped;
+    telemetry_dropped                       = 0;
+    return record;
+}
+
+void maccel_telemetry_commit(void) {
+    __atomic_store_n(&telemetry_head, (uint8_t)(telemetry_head + 1), __ATOMIC_RELEASE);
+}
+
+void maccel_telemetry_params(uint8_t profile, const maccel_config_t *config) {
+    maccel_telemetry_record_t *const record = maccel_telemetry_claim(MACCEL_TELEMETRY_PARAMS, profile);
+    if (record) {
+        record->params.takeoff     = config->takeoff;
+        record->params.growth_rate = config->growth_rate;
+        record->params.offset      = config->offset;
+        record->params.limit       = config->limit;
+        maccel_telemetry_commit();
+    }
+}
+
+uint8_t maccel_telemetry_read(uint8_t *data, uint8_t length) {
+    const uint8_t head   = __atomic_load_n(&telemetry_head, __ATOMIC_ACQUIRE);
+    uint8_t       tail   = telemetry_tail;
+    uint8_t       copied = 0;
+    while (tail != head && copied + sizeof(maccel_telemetry_record_t) <= length) {
+        memcpy(&data[copied], &telemetry_ring[tail & TELEMETRY_MASK], sizeof(maccel_telemetry_record_t));
+        copied += sizeof(maccel_telemetry_record_t);
+        tail++;
+        __atomic_store_n(&telemetry_tail, tail, __ATOMIC_RELEASE);
+    }
+    return copied;
+}
+
+void maccel_telemetry_task(void) {
+#ifdef CONSOLE_ENABLE
+    // one record per call, as an `MX:` hex line
+    static const char hex[] = "0123456789ABCDEF";
+    uint8_t           record[sizeof(maccel_telemetry_record_t)];
+    char              line[sizeof(record) * 2 + 1];
+    if (maccel_telemetry_read(record, sizeof(record)) == 0) {
+        return;
+    }
+    for (uint8_t i = 0; i < sizeof(record); i++) {
+        line[i * 2]     = hex[record[i] >> 4];
+        line[i * 2 + 1] = hex[record[i] & 0x0F];
+    }
+    line[sizeof(line) - 1] = '\0';
+    printf("MX:%s\n", line);
+#endif // CONSOLE_ENABLE
+}
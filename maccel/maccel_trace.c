@@ -0,0 +1,186 @@
+/* Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h" // IWYU pragma: keep
+#include "maccel.h"
+
+/* Motion trace recorder
+ *
+ * Raw sensor deltas are appended to a RAM ring as variable-length records, with the time since
+ * the previous report in ticks of TRACE_TICK_US (the remainder carries over to the next record). Recording is a few byte stores per report; the
+ * buffer is read out later (console dump or VIA), off the report path.
+ *
+ * Record encoding, tag in the top two bits of the first byte:
+ *   00dddddd xxxxyyyy                 dt 0..63 ticks, x and y in -8..7
+ *   01dddddd x:i8 y:i8                dt 0..63 ticks, x and y in -128..127
+ *   10000000 dt:u16 x:i16 y:i16       anything else (little endian, dt saturates)
+ *   11kkkkkk value:u16                marker: k=0 cpi, k=1 start (value = tick length in us),
+ *                                     k=2 records dropped since the last one (buffer was full)
+ */
+
+#ifndef MACCEL_TRACE_BUFFER_SIZE
+#    define MACCEL_TRACE_BUFFER_SIZE 4096
+#endif
+_Static_assert((MACCEL_TRACE_BUFFER_SIZE & (MACCEL_TRACE_BUFFER_SIZE - 1)) == 0 && MACCEL_TRACE_BUFFER_SIZE <= 32768, "MACCEL_TRACE_BUFFER_SIZE must be a power of two, at most 32768");
+
+#define TRACE_MASK (MACCEL_TRACE_BUFFER_SIZE - 1)
+#define TRACE_TICK_US 32 // 1 kHz reports fit the short records, with room for jitter
+
+enum {
+    TRACE_MARKER_CPI     = 0,
+    TRACE_MARKER_START   = 1,
+    TRACE_MARKER_DROPPED = 2,
+};
+
+static uint8_t  trace_buffer[MACCEL_TRACE_BUFFER_SIZE];
+static uint16_t trace_head; // free-running write index
+static uint16_t trace_tail; // free-running read index
+static uint32_t trace_pending_us; // time not yet written out, since the last record
+static uint16_t trace_cpi;
+static uint16_t trace_dropped;
+static bool     trace_recording;
+static bool     trace_dumping;
+
+static bool trace_put(const uint8_t *record, uint8_t length) {
+    if ((uint16_t)(MACCEL_TRACE_BUFFER_SIZE - (uint16_t)(trace_head - trace_tail)) < length) {
+        if (trace_dropped < UINT16_MAX) {
+            trace_dropped++;
+        }
+        return false;
+    }
+    for (uint8_t i = 0; i < length; i++) {
+        trace_buffer[(trace_head + i) & TRACE_MASK] = record[i];
+    }
+    trace_head += length;
+    return true;
+}
+
+static bool trace_put_marker(uint8_t kind, uint16_t value) {
+    const uint8_t record[3] = {0xC0 | kind, value & 0xFF, value >> 8};
+    return trace_put(record, sizeof(record));
+}
+
+void maccel_trace_record(int16_t x, int16_t y, uint16_t elapsed_us, uint16_t cpi) {
+    if (!trace_recording) {
+        return;
+    }
+    trace_pending_us += elapsed_us;
+    if (trace_dropped) {
+        if (!trace_put_marker(TRACE_MARKER_DROPPED, trace_dropped)) {
+            return;
+        }
+        trace_dropped = 0;
+    }
+    if (cpi != trace_cpi) {
+        if (!trace_put_marker(TRACE_MARKER_CPI, cpi)) {
+            return;
+        }
+        trace_cpi = cpi;
+    }
+
+    const uint32_t dt = trace_pending_us / TRACE_TICK_US;
+    uint8_t        record[7];
+    uint8_t        length;
+    if (dt < 64 && x >= -8 && x <= 7 && y >= -8 && y <= 7) {
+        record[0] = dt;
+        record[1] = ((x & 0x0F) << 4) | (y & 0x0F);
+        length    = 2;
+    } else if (dt < 64 && x >= INT8_MIN && x <= INT8_MAX && y >= INT8_MIN && y <= INT8_MAX) {
+        record[0] = 0x40 | dt;
+        record[1] = x;
+        record[2] = y;
+        length    = 3;
+    } else {
+        const uint16_t dt16 = dt < UINT16_MAX ? dt : UINT16_MAX;
+        record[0]           = 0x80;
+        record[1]           = dt16 & 0xFF;
+        record[2]           = dt16 >> 8;
+        record[3]           = x & 0xFF;
+        record[4]           = (uint16_t)x >> 8;
+        record[5]           = y & 0xFF;
+        record[6]           = (uint16_t)y >> 8;
+        length              = 7;
+    }
+    if (trace_put(record, length)) {
+        trace_pending_us = dt < UINT16_MAX ? trace_pending_us % TRACE_TICK_US : 0;
+    }
+}
+
+void maccel_trace_start(void) {
+    trace_head       = 0;
+    trace_tail       = 0;
+    trace_dropped    = 0;
+    trace_cpi        = 0;
+    trace_dumping    = false;
+    trace_pending_us = 0;
+    trace_put_marker(TRACE_MARKER_START, TRACE_TICK_US);
+    trace_recording = true;
+}
+
+void maccel_trace_stop(void) {
+    trace_recording = false;
+#ifdef CONSOLE_ENABLE
+    trace_dumping = true;
+#endif
+}
+
+bool maccel_trace_is_recording(void) {
+    return trace_recording;
+}
+
+void maccel_trace_toggle(void) {
+    if (trace_recording) {
+        maccel_trace_stop();
+    } else {
+        maccel_trace_start();
+    }
+}
+
+uint8_t maccel_trace_read(uint8_t *data, uint8_t length) {
+    const uint16_t available = trace_head - trace_tail;
+    if (length > available) {
+        length = available;
+    }
+    for (uint8_t i = 0; i < length; i++) {
+        data[i] = trace_buffer[(trace_tail + i) & TRACE_MASK];
+    }
+    trace_tail += length;
+    return length;
+}
+
+void maccel_trace_task(void) {
+#ifdef CONSOLE_ENABLE
+    // after recording stops, dump the buffer as hex, one console line per call
+    if (!trace_dumping) {
+        return;
+    }
+    static const char hex[] = "0123456789ABCDEF";
+    uint8_t           chunk[32];
+    char              line[sizeof(chunk) * 2 + 1];
+    const uint8_t     length = maccel_trace_read(chunk, sizeof(chunk));
+    if (length == 0) {
+        printf("MT:END\n");
+        trace_dumping = false;
+        return;
+    }
+    for (uint8_t i = 0; i < length; i++) {
+        line[i * 2]     = hex[chunk[i] >> 4];
+        line[i * 2 + 1] = hex[chunk[i] & 0x0F];
+    }
+    line[length * 2] = '\0';
+    printf("MT:%s\n", line);
+#endif // CONSOLE_ENABLE
+}
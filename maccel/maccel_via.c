@@ -14,13 +14,83 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stddef.h>
+#include <string.h>
 #include "maccel.h"
 #include "via.h"
 #ifdef MACCEL_DEBUG
 #    include "debug.h" // IWYU pragma: keep
 #endif
 
-_Static_assert(sizeof(maccel_config_t) == EECONFIG_USER_DATA_SIZE, "Mismatch in keyboard EECONFIG stored data");
+/* EEPROM user block
+ *
+ * A header, then every profile as the same number of 16-bit fields, little endian:
+ *   [ version, profiles, fields, crc:u16 ] [ flags, takeoff, growth_rate, offset, limit ] per profile
+ * Parameters are fixed-point, in thousandths: 0..65.535, the offset -32..33.535. The CRC-16/CCITT
+ * covers all profiles. A block with fewer profiles or fields than this firmware has leaves the
+ * rest at their defaults, and any more are ignored, so that profiles and parameters can be added
+ * (at the end) without losing stored configs; only a different encoding bumps the version. A
+ * block that fails the checks, e.g. one left by another firmware, is replaced by the defaults.
+ * It is decoded once at boot; everything else works on `g_maccel_profiles`.
+ */
+#define MACCEL_EECONFIG_VERSION 2
+#define MACCEL_EECONFIG_HEADER 5
+
+enum maccel_eeconfig_fields {
+    MACCEL_FIELD_FLAGS,
+    MACCEL_FIELD_PARAMS, // the parameters, in `maccel_param_offsets` order
+    MACCEL_EECONFIG_FIELDS = MACCEL_FIELD_PARAMS + 4,
+};
+#define MACCEL_FLAG_ENABLED (1 << 0)
+#define MACCEL_EECONFIG_SIZE (MACCEL_EECONFIG_HEADER + MACCEL_PROFILE_COUNT * MACCEL_EECONFIG_FIELDS * 2)
+
+_Static_assert(MACCEL_EECONFIG_SIZE <= EECONFIG_USER_DATA_SIZE, "EECONFIG_USER_DATA_SIZE too small: maccel needs 5 + 10 per profile");
+
+// parameters of maccel_config_t in the order of their VIA value ids and EEPROM fields
+static const uint8_t maccel_param_offsets[] = {offsetof(maccel_config_t, takeoff), offsetof(maccel_config_t, growth_rate), offsetof(maccel_config_t, offset), offsetof(maccel_config_t, limit)};
+#define MACCEL_PARAMS (sizeof(maccel_param_offsets) / sizeof(maccel_param_offsets[0]))
+
+_Static_assert(MACCEL_PARAMS == MACCEL_EECONFIG_FIELDS - MACCEL_FIELD_PARAMS, "every parameter needs its EEPROM field");
+
+static float *maccel_param(maccel_config_t *config, uint8_t param) {
+    return (float *)((uint8_t *)config + maccel_param_offsets[param]);
+}
+
+// a parameter as uint16: value * scale + zero, rounded and saturated; decoding subtracts the
+// (integral) zero before dividing, so that values with as many decimals come back exactly
+typedef struct {
+    float zero;
+    float scale;
+} maccel_codec_t;
+
+static const maccel_codec_t maccel_eeconfig_codecs[MACCEL_PARAMS] = {{0, 1000}, {0, 1000}, {32000, 1000}, {0, 1000}};
+// VIA sliders span 0..60k: takeoff 0.5..6.5, growth rate 0..6, offset -3..3, limit 1..13
+static const maccel_codec_t maccel_via_codecs[MACCEL_PARAMS] = {{-5000, 10000}, {0, 10000}, {30000, 10000}, {-5000, 5000}};
+
+static uint16_t maccel_encode(float value, const maccel_codec_t *codec) {
+    const float raw = value * codec->scale + codec->zero + 0.5f;
+    if (!(raw >= 0)) { // NaN too
+        return 0;
+    }
+    return raw < UINT16_MAX ? (uint16_t)raw : UINT16_MAX;
+}
+
+static float maccel_decode(uint16_t raw, const maccel_codec_t *codec) {
+    return (raw - codec->zero) / codec->scale;
+}
+
+static uint16_t maccel_get_u16(const uint8_t *data) {
+    return data[0] | data[1] << 8;
+}
+
+static void maccel_put_u16(uint8_t *data, uint16_t value) {
+    data[0] = value & 0xFF;
+    data[1] = value >> 8;
+}
+
+#ifndef MACCEL_EECONFIG_DELAY_MS
+#    define MACCEL_EECONFIG_DELAY_MS 3000 // quiet time after the last change before it is written
+#endif
 
 enum via_maccel_channel {
     // clang-format off
@@ -33,12 +103,75 @@ enum via_maccel_ids {
     id_maccel_growth_rate = 2,
     id_maccel_offset      = 3,
     id_maccel_limit       = 4,
-    id_maccel_enabled     = 5
+    id_maccel_enabled     = 5,
+    id_maccel_trace       = 6,
+    id_maccel_config      = 7,
+    id_maccel_profile     = 8,
+    id_maccel_telemetry   = 9
     // clang-format on
 };
 
 #define COMBINE_UINT8(one, two) (two | (one << 8))
 
+/* Whole config in one packet (value id 7), get and set alike:
+ *   [ version, flags, growth_rate:f32, offset:f32, limit:f32, takeoff:f32, enabled ]
+ * Floats are IEEE-754 binary32, little endian, so values survive the round-trip bit for bit.
+ * A set with a different version is ignored; the reply always carries the current config. */
+#define MACCEL_VIA_CONFIG_VERSION 1
+#define MACCEL_VIA_CONFIG_SIZE 19
+#define MACCEL_VIA_FLAG_APPLY_ONLY (1 << 0) // set: apply, but do not write EEPROM
+
+// value bytes per VIA packet: 32-byte packet minus command, channel and value id
+_Static_assert(MACCEL_VIA_CONFIG_SIZE <= 29, "maccel config does not fit a VIA packet");
+
+static void maccel_via_put_float(uint8_t *data, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    data[0] = bits & 0xFF;
+    data[1] = (bits >> 8) & 0xFF;
+    data[2] = (bits >> 16) & 0xFF;
+    data[3] = bits >> 24;
+}
+
+static float maccel_via_get_float(const uint8_t *data) {
+    const uint32_t bits = (uint32_t)data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+    float          value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void maccel_via_config_write(uint8_t *data) {
+    data[0] = MACCEL_VIA_CONFIG_VERSION;
+    data[1] = 0;
+    maccel_via_put_float(&data[2], g_maccel_config.growth_rate);
+    maccel_via_put_float(&data[6], g_maccel_config.offset);
+    maccel_via_put_float(&data[10], g_maccel_config.limit);
+    maccel_via_put_float(&data[14], g_maccel_config.takeoff);
+    data[18] = g_maccel_config.enabled;
+}
+
+static void maccel_via_config_read(uint8_t *data) {
+    if (data[0] == MACCEL_VIA_CONFIG_VERSION) {
+        const bool save             = !(data[1] & MACCEL_VIA_FLAG_APPLY_ONLY);
+        g_maccel_config.growth_rate = maccel_via_get_float(&data[2]);
+        g_maccel_config.offset      = maccel_via_get_float(&data[6]);
+        g_maccel_config.limit       = maccel_via_get_float(&data[10]);
+        g_maccel_config.takeoff     = maccel_via_get_float(&data[14]);
+        g_maccel_config.enabled     = data[18];
+        maccel_config_changed();
+        if (save) {
+            maccel_config_save();
+        }
+#ifdef MACCEL_DEBUG
+        printf("MACCEL:via: tko: %.3f grw: %.3f ofs: %.3f lmt: %.3f%s\n", g_maccel_config.takeoff, g_maccel_config.growth_rate, g_maccel_config.offset, g_maccel_config.limit, save ? "" : " (not saved)");
+#endif
+    }
+    maccel_via_config_write(data);
+}
+
+// trace or telemetry bytes per VIA reply: 32-byte packet minus command, channel, value id and count
+#define MACCEL_TRACE_VIA_CHUNK 28
+
 // Handle the data received by the keyboard from the VIA menus
 void maccel_config_set_value(uint8_t *data) {
     // data = [ value_id, value_data ]
@@ -46,51 +179,44 @@ void maccel_config_set_value(uint8_t *data) {
     uint8_t *value_data = &(data[1]);
 
     switch (*value_id) {
-        case id_maccel_takeoff: {
-            uint16_t takeoff = COMBINE_UINT8(value_data[0], value_data[1]);
-
-            // calc uint16 to float: takeoff moves comma and shifts by 0.5, so that 0.5..6.5 fits into 0..60k
-            g_maccel_config.takeoff = (takeoff / 10000.0f) + 0.5;
+        case id_maccel_takeoff:
+        case id_maccel_growth_rate:
+        case id_maccel_offset:
+        case id_maccel_limit: {
+            // slider positions, rounded when read back so that a get returns what was set
+            const uint8_t param                    = *value_id - id_maccel_takeoff;
+            *maccel_param(&g_maccel_config, param) = maccel_decode(COMBINE_UINT8(value_data[0], value_data[1]), &maccel_via_codecs[param]);
 #ifdef MACCEL_DEBUG
-            printf("MACCEL:via: TKO: %.3f grw: %.3f ofs: %.3f lmt: %.3f\n", g_maccel_config.takeoff, g_maccel_config.growth_rate, g_maccel_config.offset, g_maccel_config.limit);
+            printf("MACCEL:via: tko: %.3f grw: %.3f ofs: %.3f lmt: %.3f\n", g_maccel_config.takeoff, g_maccel_config.growth_rate, g_maccel_config.offset, g_maccel_config.limit);
 #endif
             break;
         }
-        case id_maccel_growth_rate: {
-            uint16_t growth_rate = COMBINE_UINT8(value_data[0], value_data[1]);
-
-            // calc uint16 to float: growth_rate only moves the comma
-            g_maccel_config.growth_rate = growth_rate / 10000.0f;
-#ifdef MACCEL_DEBUG
-            printf("MACCEL:via: tko: %.3f GRW: %.3f ofs: %.3f lmt: %.3f\n", g_maccel_config.takeoff, g_maccel_config.growth_rate, g_maccel_config.offset, g_maccel_config.limit);
-#endif
+        case id_maccel_enabled: {
+            maccel_enabled(value_data[0]);
             break;
         }
-        case id_maccel_offset: {
-            uint16_t offset = COMBINE_UINT8(value_data[0], value_data[1]);
-
-            // calc uint16 to float: offset moves comma and shifts by 3, so that -3..3 fits into 0..60k
-            g_maccel_config.offset = (offset / 10000.0f) - 3;
-#ifdef MACCEL_DEBUG
-            printf("MACCEL:via: tko: %.3f grw: %.3f OFS: %.3f lmt: %.3f\n", g_maccel_config.takeoff, g_maccel_config.growth_rate, g_maccel_config.offset, g_maccel_config.limit);
-#endif
-            break;
+        case id_maccel_profile: {
+            // profile the other values apply to, MACCEL_PROFILE_NONE (0xFF) to follow the selection again
+            maccel_profile_override(value_data[0]);
+            return;
         }
-        case id_maccel_limit: {
-            uint16_t limit = COMBINE_UINT8(value_data[0], value_data[1]);
-
-            // calc uint16 to float: offset moves comma, divides by 2 and shifts by 1, so that 1..14 fits into 0..60k
-            g_maccel_config.limit = (limit / 5000.0f) + 1;
-#ifdef MACCEL_DEBUG
-            printf("MACCEL:via: tko: %.3f grw: %.3f ofs: %.3f LMT: %.3f\n", g_maccel_config.takeoff, g_maccel_config.growth_rate, g_maccel_config.offset, g_maccel_config.limit);
-#endif
-            break;
+#ifdef MACCEL_TRACE_ENABLE
+        case id_maccel_trace: {
+            // 1 starts a new recording, 0 stops it
+            if (value_data[0]) {
+                maccel_trace_start();
+            } else {
+                maccel_trace_stop();
+            }
+            return;
         }
-        case id_maccel_enabled: {
-            g_maccel_config.enabled = value_data[0];
-            break;
+#endif
+        case id_maccel_config: {
+            maccel_via_config_read(value_data);
+            return;
         }
     }
+    maccel_config_changed();
 }
 
 // Handle the data sent by the keyboard to the VIA menus
@@ -100,40 +226,109 @@ void maccel_config_get_value(uint8_t *data) {
     uint8_t *value_data = &(data[1]);
 
     switch (*value_id) {
-        case id_maccel_takeoff: {
-            uint16_t takeoff = (g_maccel_config.takeoff - 0.5) * 5000;
-            value_data[0]    = takeoff >> 8;
-            value_data[1]    = takeoff & 0xFF;
+        case id_maccel_takeoff:
+        case id_maccel_growth_rate:
+        case id_maccel_offset:
+        case id_maccel_limit: {
+            const uint8_t  param = *value_id - id_maccel_takeoff;
+            const uint16_t value = maccel_encode(*maccel_param(&g_maccel_config, param), &maccel_via_codecs[param]);
+            value_data[0]        = value >> 8;
+            value_data[1]        = value & 0xFF;
             break;
         }
-        case id_maccel_growth_rate: {
-            uint16_t growth_rate = g_maccel_config.growth_rate * 10000;
-            value_data[0]        = growth_rate >> 8;
-            value_data[1]        = growth_rate & 0xFF;
+        case id_maccel_enabled: {
+            value_data[0] = g_maccel_config.enabled;
             break;
         }
-        case id_maccel_offset: {
-            uint16_t offset = (g_maccel_config.offset + 3) * 10000;
-            value_data[0]   = offset >> 8;
-            value_data[1]   = offset & 0xFF;
+#ifdef MACCEL_TRACE_ENABLE
+        case id_maccel_trace: {
+            // drain the recording: [ byte count, bytes... ], 0 once it is empty
+            value_data[0] = maccel_trace_read(&value_data[1], MACCEL_TRACE_VIA_CHUNK);
             break;
         }
-        case id_maccel_limit: {
-            uint16_t limit = (g_maccel_config.limit - 1) * 5000;
-            value_data[0]  = limit >> 8;
-            value_data[1]  = limit & 0xFF;
+#endif
+#ifdef MACCEL_TELEMETRY_ENABLE
+        case id_maccel_telemetry: {
+            // drain telemetry: [ byte count, one record ], 0 once it is empty
+            value_data[0] = maccel_telemetry_read(&value_data[1], MACCEL_TRACE_VIA_CHUNK);
             break;
         }
-        case id_maccel_enabled: {
-            value_data[0] = g_maccel_config.enabled;
+#endif
+        case id_maccel_config: {
+            maccel_via_config_write(value_data);
             break;
         }
+        case id_maccel_profile: {
+            // [ active profile, override (0xFF if none), profile count ]
+            value_data[0] = maccel_profile_get();
+            value_data[1] = maccel_profile_get_override();
+            value_data[2] = MACCEL_PROFILE_COUNT;
+            break;
+        }
+    }
+}
+
+static struct {
+    bool                    dirty;
+    uint32_t                timer; // last change
+    maccel_eeconfig_stats_t stats;
+} maccel_eeconfig;
+
+static uint16_t maccel_eeconfig_crc(const uint8_t *data, uint16_t length) {
+    uint16_t crc = 0xFFFF;
+    while (length--) {
+        crc ^= (uint16_t)*data++ << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static void maccel_eeconfig_write(void) {
+    uint8_t block[EECONFIG_USER_DATA_SIZE] = {MACCEL_EECONFIG_VERSION, MACCEL_PROFILE_COUNT, MACCEL_EECONFIG_FIELDS};
+    uint8_t *field                         = &block[MACCEL_EECONFIG_HEADER];
+    for (uint8_t i = 0; i < MACCEL_PROFILE_COUNT; i++) {
+        maccel_put_u16(field, g_maccel_profiles[i].enabled ? MACCEL_FLAG_ENABLED : 0);
+        field += 2;
+        for (uint8_t param = 0; param < MACCEL_PARAMS; param++, field += 2) {
+            maccel_put_u16(field, maccel_encode(*maccel_param(&g_maccel_profiles[i], param), &maccel_eeconfig_codecs[param]));
+        }
+    }
+    maccel_put_u16(&block[3], maccel_eeconfig_crc(&block[MACCEL_EECONFIG_HEADER], MACCEL_EECONFIG_SIZE - MACCEL_EECONFIG_HEADER));
+
+    // only changed bytes are written, but on flash-emulated EEPROM even that can take milliseconds
+    const uint32_t ticks = MACCEL_TIMER_TICKS();
+    eeconfig_update_user_datablock(block);
+    const uint32_t stall = (MACCEL_TIMER_TICKS() - ticks) / MACCEL_TIMER_TICKS_PER_US;
+
+    maccel_eeconfig.dirty = false;
+    maccel_eeconfig.stats.writes++;
+    maccel_eeconfig.stats.stall_us += stall;
+    if (stall > maccel_eeconfig.stats.stall_max_us) {
+        maccel_eeconfig.stats.stall_max_us = stall;
     }
+#ifdef MACCEL_DEBUG
+    printf("MACCEL:eeconfig: write %u took %luus (max %luus)\n", maccel_eeconfig.stats.writes, (unsigned long)stall, (unsigned long)maccel_eeconfig.stats.stall_max_us);
+#endif
 }
 
-// Save the data to persistent memory after changes are made
+// Save the data to persistent memory after changes are made: only marks it, repeated saves
+// (VIA sliders, held keycodes) restart the quiet period and end up as a single write
 void maccel_config_save(void) {
-    eeconfig_update_user_datablock(&g_maccel_config);
+    maccel_eeconfig.dirty = true;
+    maccel_eeconfig.timer = timer_read32();
+}
+
+// called from housekeeping; writes never happen while the pointer is moving
+void maccel_config_save_task(bool pointer_idle) {
+    if (maccel_eeconfig.dirty && pointer_idle && timer_elapsed32(maccel_eeconfig.timer) >= MACCEL_EECONFIG_DELAY_MS) {
+        maccel_eeconfig_write();
+    }
+}
+
+maccel_eeconfig_stats_t maccel_eeconfig_stats(void) {
+    return maccel_eeconfig.stats;
 }
 
 void via_custom_value_command_kb(uint8_t *data, uint8_t length) {
@@ -159,16 +354,44 @@ void via_custom_value_command_kb(uint8_t *data, uint8_t length) {
         return;
     }
 
-    *command_id = id_unhandled;
+    // other channels are the keymap's, as without maccel (QMK's default marks them unhandled)
+    via_custom_value_command_user(data, length);
 }
 
 void eeconfig_init_user(void) {
     // Write default value to EEPROM now
-    eeconfig_update_user_datablock(&g_maccel_config);
+    maccel_eeconfig_write();
+}
+
+static bool maccel_eeconfig_decode(const uint8_t *block) {
+    const uint8_t  profiles = block[1], fields = block[2];
+    const uint16_t length   = profiles * fields * 2;
+    if (length == 0 || length > EECONFIG_USER_DATA_SIZE - MACCEL_EECONFIG_HEADER || maccel_get_u16(&block[3]) != maccel_eeconfig_crc(&block[MACCEL_EECONFIG_HEADER], length)) {
+        return false;
+    }
+    for (uint8_t i = 0; i < profiles && i < MACCEL_PROFILE_COUNT; i++) {
+        const uint8_t *const record = &block[MACCEL_EECONFIG_HEADER + i * fields * 2];
+        g_maccel_profiles[i].enabled = maccel_get_u16(record) & MACCEL_FLAG_ENABLED;
+        for (uint8_t param = 0; param < MACCEL_PARAMS && MACCEL_FIELD_PARAMS + param < fields; param++) {
+            *maccel_param(&g_maccel_profiles[i], param) = maccel_decode(maccel_get_u16(&record[(MACCEL_FIELD_PARAMS + param) * 2]), &maccel_eeconfig_codecs[param]);
+        }
+    }
+    return true;
 }
 
 // On Keyboard startup
 void keyboard_post_init_maccel(void) {
-    // Read custom menu variables from memory
-    eeconfig_read_user_datablock(&g_maccel_config);
+    // Read custom menu variables from memory, unless they were not written by this version
+    uint8_t block[EECONFIG_USER_DATA_SIZE];
+    eeconfig_read_user_datablock(block);
+    const uint8_t version = block[0];
+    if (version != MACCEL_EECONFIG_VERSION || !maccel_eeconfig_decode(block)) {
+        // keep the compiled-in defaults, and put them in place of the bad block later
+        maccel_eeconfig.stats.rejected++;
+        maccel_config_save();
+#ifdef MACCEL_DEBUG
+        printf("MACCEL:eeconfig: stored config rejected (version %u), using defaults\n", version);
+#endif
+    }
+    maccel_profiles_changed();
 }
@@ -3,7 +3,16 @@ ifeq ($(strip $(MACCEL_ENABLE)), yes)
 	ifeq ($(strip $(VIA_ENABLE)), yes)
 		ifeq ($(strip $(MACCEL_VIA_ENABLE)), yes)
 			SRC += $(USER_PATH)/features/maccel/maccel_via.c
+			OPT_DEFS += -DMACCEL_VIA_ENABLE
 		endif
 	endif
+	ifeq ($(strip $(MACCEL_TRACE_ENABLE)), yes)
+		SRC += $(USER_PATH)/features/maccel/maccel_trace.c
+		OPT_DEFS += -DMACCEL_TRACE_ENABLE
+	endif
+	ifeq ($(strip $(MACCEL_TELEMETRY_ENABLE)), yes)
+		SRC += $(USER_PATH)/features/maccel/maccel_telemetry.c
+		OPT_DEFS += -DMACCEL_TELEMETRY_ENABLE
+	endif
 	OPT_DEFS += -DMACCEL_ENABLE
 endif
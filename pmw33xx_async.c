@@ -0,0 +1,173 @@
+/**
+ * Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "quantum.h"
+#include "spi_master.h"
+#include "pmw33xx_async.h"
+#include "timebase.h"
+
+/**
+ * Microsecond timebase for tSRAD_MOTBR, the keymap's shared one (see `timebase.h`) when it
+ * is finer than the millisecond timer; override both macros for another counter.  Without
+ * one, bursts are only ever received at collect, after waiting out tSRAD_MOTBR in full.
+ */
+#if !defined(PMW33XX_ASYNC_TICKS) && defined(TIMEBASE_HIGH_RESOLUTION)
+#    define PMW33XX_ASYNC_TICKS() TIMEBASE_TICKS()
+#    define PMW33XX_ASYNC_TICKS_PER_US TIMEBASE_TICKS_PER_US
+#endif
+
+/**
+ * Receiving the burst: start it, and wait for it to complete.  ChibiOS's asynchronous receive
+ * goes on in the background; QMK's SPI config has no end callback, so the driver is back to
+ * ready once it is done.
+ */
+#ifndef PMW33XX_ASYNC_RECEIVE
+#    ifdef PROTOCOL_CHIBIOS
+#        define PMW33XX_ASYNC_RECEIVE(data, length) spiStartReceive(&SPI_DRIVER, (length), (data))
+#        define PMW33XX_ASYNC_RECEIVE_WAIT()                                 \
+            while (((volatile SPIDriver *)&SPI_DRIVER)->state != SPI_READY) { \
+            }
+#    else
+#        define PMW33XX_ASYNC_RECEIVE(data, length) spi_receive((data), (length))
+#        define PMW33XX_ASYNC_RECEIVE_WAIT()
+#    endif
+#endif
+
+#ifndef REG_Motion_Burst
+#    define REG_Motion_Burst 0x50
+#endif
+#define PMW33XX_ASYNC_TSRAD_MOTBR_US 35 // from the address to the first register clocked in
+#define PMW33XX_ASYNC_BURST_LENGTH 6    // Motion, Observation, Delta_X_L, _H, Delta_Y_L, _H
+
+typedef enum {
+    PMW33XX_ASYNC_IDLE,
+    PMW33XX_ASYNC_ADDRESSED, // waiting out tSRAD_MOTBR
+    PMW33XX_ASYNC_RECEIVING,
+} pmw33xx_async_state_t;
+
+#define PMW33XX_ASYNC_SMOOTHING 3 // exponential average over 2^3 bursts
+
+static struct {
+    pmw33xx_async_state_t state;
+    bool                  in_burst; // Motion_Burst written since any other register access
+    bool                  cpi_pending;
+    bool                  advanced; // during this burst
+    uint16_t              cpi;
+    uint32_t              addressed; // ticks
+    uint32_t              advance;   // ticks, the last advance
+    uint32_t              lead_q;    // advance to collect, in us scaled by 2^PMW33XX_ASYNC_SMOOTHING
+    uint8_t               data[PMW33XX_ASYNC_BURST_LENGTH];
+} burst;
+
+bool pmw33xx_async_init(void) {
+    const bool ok     = pmw33xx_init(0);
+    burst.state       = PMW33XX_ASYNC_IDLE;
+    burst.in_burst    = false;
+    burst.cpi_pending = false;
+    burst.cpi         = pmw33xx_get_cpi(0);
+    return ok;
+}
+
+bool pmw33xx_async_start(void) {
+    if (burst.state != PMW33XX_ASYNC_IDLE) {
+        return false;
+    }
+    if (burst.cpi_pending) {
+        pmw33xx_set_cpi(0, burst.cpi);
+        burst.cpi_pending = false;
+        burst.in_burst    = false;
+    }
+    if (!burst.in_burst) {
+        // any value, and the sensor stays in burst mode until another register is accessed
+        pmw33xx_write(0, REG_Motion_Burst, 0x00);
+        burst.in_burst = true;
+    }
+    if (!spi_start(PMW33XX_CS_PIN, false, 3, PMW33XX_SPI_DIVISOR)) {
+        return false;
+    }
+    spi_write(REG_Motion_Burst);
+#ifdef PMW33XX_ASYNC_TICKS
+    burst.addressed = PMW33XX_ASYNC_TICKS();
+#endif
+    burst.state = PMW33XX_ASYNC_ADDRESSED;
+    return true;
+}
+
+static void pmw33xx_async_receive(void) {
+    PMW33XX_ASYNC_RECEIVE(burst.data, sizeof(burst.data));
+    burst.state = PMW33XX_ASYNC_RECEIVING;
+}
+
+/* The motion is latched as the burst is received, so receiving long before the collect
+ * would hand over stale counts: advancing only starts the transfer while collects have come
+ * within PMW33XX_ASYNC_MAX_AGE_US of it, and otherwise leaves it to the collect. */
+void pmw33xx_async_advance(void) {
+#ifdef PMW33XX_ASYNC_TICKS
+    if (burst.state != PMW33XX_ASYNC_ADDRESSED) {
+        return;
+    }
+    const uint32_t now = PMW33XX_ASYNC_TICKS();
+    burst.advance      = now;
+    burst.advanced     = true;
+    if (now - burst.addressed >= PMW33XX_ASYNC_TSRAD_MOTBR_US * PMW33XX_ASYNC_TICKS_PER_US && (burst.lead_q >> PMW33XX_ASYNC_SMOOTHING) <= PMW33XX_ASYNC_MAX_AGE_US) {
+        pmw33xx_async_receive();
+    }
+#endif
+}
+
+bool pmw33xx_async_collect(pmw33xx_report_t *report) {
+    if (burst.state == PMW33XX_ASYNC_IDLE) {
+        return false;
+    }
+#ifdef PMW33XX_ASYNC_TICKS
+    if (burst.advanced) {
+        const uint32_t lead = (PMW33XX_ASYNC_TICKS() - burst.advance) / PMW33XX_ASYNC_TICKS_PER_US;
+        burst.lead_q += lead - (burst.lead_q >> PMW33XX_ASYNC_SMOOTHING);
+        burst.advanced = false;
+    }
+#endif
+    if (burst.state == PMW33XX_ASYNC_ADDRESSED) {
+#ifdef PMW33XX_ASYNC_TICKS
+        const uint32_t elapsed_us = (PMW33XX_ASYNC_TICKS() - burst.addressed) / PMW33XX_ASYNC_TICKS_PER_US;
+        if (elapsed_us < PMW33XX_ASYNC_TSRAD_MOTBR_US) {
+            wait_us(PMW33XX_ASYNC_TSRAD_MOTBR_US - elapsed_us);
+        }
+#else
+        wait_us(PMW33XX_ASYNC_TSRAD_MOTBR_US);
+#endif
+        pmw33xx_async_receive();
+    }
+    PMW33XX_ASYNC_RECEIVE_WAIT();
+    spi_stop();
+    burst.state      = PMW33XX_ASYNC_IDLE;
+    report->motion.w = burst.data[0];
+    report->delta_x  = (int16_t)(burst.data[2] | burst.data[3] << 8);
+    report->delta_y  = (int16_t)(burst.data[4] | burst.data[5] << 8);
+    // as QMK's driver recovers: these bits are never set in burst mode
+    if (report->motion.w & 0b111) {
+        burst.in_burst = false;
+    }
+    return true;
+}
+
+uint16_t pmw33xx_async_get_cpi(void) {
+    return burst.cpi;
+}
+
+void pmw33xx_async_set_cpi(uint16_t cpi) {
+    burst.cpi         = cpi;
+    burst.cpi_pending = true;
+}
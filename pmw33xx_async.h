@@ -0,0 +1,64 @@
+/**
+ * Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pmw33xx_common.h"
+
+/**
+ * \brief The PMW33xx motion burst in steps, for the rest of the main loop to run between.
+ *
+ * QMK's `pmw33xx_read_burst()` sends the Motion_Burst address, waits out tSRAD_MOTBR (35 us)
+ * and clocks the motion registers in, all in the pointing task.  Here the same transfer is
+ * split up:
+ *
+ * - `pmw33xx_async_start()` selects the sensor and sends the address, then returns;
+ * - `pmw33xx_async_advance()`, once tSRAD_MOTBR is over, starts receiving the registers,
+ *   with ChibiOS's asynchronous SPI receive, i.e. by DMA where the MCU's SPI driver has it,
+ *   unless collects come more than `PMW33XX_ASYNC_MAX_AGE_US` after it: the motion is
+ *   latched as it is received, and would be that much older when reported;
+ * - `pmw33xx_async_collect()` waits for whatever is left of that, if anything, deselects
+ *   the sensor and hands over the report.
+ *
+ * The bus stays selected from start to collect, so nothing else may use that SPI bus in
+ * between (QMK's `spi_start()` then refuses to).  Without ChibiOS the registers are received
+ * in one go when advancing, and without a microsecond counter tSRAD_MOTBR is waited out in
+ * full at collect; either way the result is the same as QMK's, only less of it overlaps.
+ *
+ * Register accesses other than the burst wait for none to be in flight: the CPI is answered
+ * from what was last set, and setting it is put off until the next start.  Transport and
+ * timing are QMK's SPI master, `wait_us()` and the macros below, which host builds replace
+ * with a model of the sensor (see `host/pmw3360_mock.c`).
+ */
+
+#ifndef PMW33XX_ASYNC_MAX_AGE_US
+#    define PMW33XX_ASYNC_MAX_AGE_US 200 // motion latched no earlier before the collect, on average
+#endif
+
+/** From `pointing_device_driver_init()`, in place of `pmw33xx_init()`. */
+bool pmw33xx_async_init(void);
+/** Start a motion burst; false if one is in flight already. Writes a pending CPI first. */
+bool pmw33xx_async_start(void);
+/** Anywhere in between: the next step of a burst in flight, if it is due, without waiting. */
+void pmw33xx_async_advance(void);
+/** Finish the burst in flight, waiting for as much as is left; false if none was started. */
+bool pmw33xx_async_collect(pmw33xx_report_t *report);
+/** The CPI as last set, read from the sensor only at init. */
+uint16_t pmw33xx_async_get_cpi(void);
+/** Set the CPI before the next burst starts. */
+void pmw33xx_async_set_cpi(uint16_t cpi);
@@ -0,0 +1,304 @@
+/**
+ * Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "quantum.h"
+#include "pointing_scheduler.h"
+#include "timebase.h"
+#ifdef MACCEL_ENABLE
+#    include "maccel/maccel.h"
+#endif
+#ifdef SPLIT_MOTION_ENABLE
+#    include "split_motion.h"
+#endif
+
+/**
+ * Timebase, the keymap's shared one (see `timebase.h`).  All state is kept in ticks and
+ * compared as differences, which stay correct across wrap-arounds because the scheduler
+ * runs on every pass, far more often than the counter wraps.
+ */
+#ifndef POINTING_SCHEDULER_TICKS
+#    define POINTING_SCHEDULER_TICKS() TIMEBASE_TICKS()
+#    define POINTING_SCHEDULER_TICKS_PER_US TIMEBASE_TICKS_PER_US
+#endif
+
+#define SCHEDULER_US(us) ((uint32_t)(us) * POINTING_SCHEDULER_TICKS_PER_US)
+#define SCHEDULER_LOOP_SMOOTHING 3 // loop periods: exponential averages over 2^3 passes
+#define SCHEDULER_BACKOFF_STEP (POINTING_SCHEDULER_LOOP_BUDGET_US / 4)
+#if defined(PMW33XX_ASYNC_ENABLE) || defined(SPLIT_MOTION_ENABLE)
+// reads (or polls of the other half) are decided on at the end of the pass before theirs,
+// about a loop period ahead
+#    define SCHEDULER_READ_LEAD() SCHEDULER_US(scheduler.loop_q >> SCHEDULER_LOOP_SMOOTHING)
+#else
+#    define SCHEDULER_READ_LEAD() 0
+#endif
+
+_Static_assert(POINTING_SCHEDULER_BACKOFF_MAX_US <= POINTING_SCHEDULER_IDLE_INTERVAL_US, "POINTING_SCHEDULER_BACKOFF_MAX_US beyond the idle interval");
+_Static_assert(POINTING_SCHEDULER_REPORT_INTERVAL_US <= 32000, "POINTING_SCHEDULER_REPORT_INTERVAL_US out of range");
+
+static struct {
+    bool     started;
+    bool     idle;
+    bool     did_read;    // on the previous pass
+    bool     synced;      // reads are timed for the other half's polls, see `pointing_scheduler_sync()`
+    bool     sync_read;   // and one was done for the next poll
+    uint32_t last_call;   // ticks, previous pointing task
+    uint32_t last_read;   // ticks, previous sensor read
+    uint32_t last_motion; // ticks, previous read with motion
+    uint32_t loop_q;      // main loop period, in us scaled by 2^SCHEDULER_LOOP_SMOOTHING
+    uint32_t loop_skip_q; // the same, of passes that did not read the sensor
+    uint32_t backoff_us;
+    uint32_t reads;
+    uint32_t skipped;
+} scheduler = {.idle = true};
+
+/*
+ * Report coalescing: reports go out on a grid of POINTING_SCHEDULER_REPORT_INTERVAL_US,
+ * started again from the current pass when the loop falls a whole frame behind or a
+ * button changes.  Only the half that coalesces, or is synced to the other's polls, has
+ * a grid; without one every frame is due, for reads as for reports.
+ */
+static struct {
+    bool     gridded;    // `next_frame` is set
+    uint32_t next_frame; // ticks
+    int32_t  x;
+    int32_t  y;
+    int32_t  h;
+    int32_t  v;
+    uint8_t  buttons;
+} coalescer;
+
+static inline bool coalescer_frame_due(uint32_t now) {
+    return POINTING_SCHEDULER_REPORT_INTERVAL_US == 0 || !coalescer.gridded || (int32_t)(now - coalescer.next_frame) >= 0;
+}
+
+// as much of a pending amount as fits in a report, leaving the rest
+static int32_t coalescer_take(int32_t *pending, int32_t min, int32_t max) {
+    const int32_t amount = *pending < min ? min : *pending > max ? max : *pending;
+    *pending -= amount;
+    return amount;
+}
+
+bool pointing_scheduler_coalesce(report_mouse_t *report) {
+    const uint32_t now = POINTING_SCHEDULER_TICKS();
+    coalescer.x += report->x;
+    coalescer.y += report->y;
+    coalescer.h += report->h;
+    coalescer.v += report->v;
+    const bool buttons = report->buttons != coalescer.buttons;
+    if (!buttons && !coalescer_frame_due(now)) {
+        report->x = 0;
+        report->y = 0;
+        report->h = 0;
+        report->v = 0;
+        return false;
+    }
+    coalescer.next_frame += SCHEDULER_US(POINTING_SCHEDULER_REPORT_INTERVAL_US);
+    if (buttons || coalescer_frame_due(now)) {
+        coalescer.next_frame = now + SCHEDULER_US(POINTING_SCHEDULER_REPORT_INTERVAL_US);
+    }
+    coalescer.gridded = true;
+    report->x         = coalescer_take(&coalescer.x, XY_REPORT_MIN, XY_REPORT_MAX);
+    report->y         = coalescer_take(&coalescer.y, XY_REPORT_MIN, XY_REPORT_MAX);
+    report->h         = coalescer_take(&coalescer.h, -HV_REPORT_MAX, HV_REPORT_MAX);
+    report->v         = coalescer_take(&coalescer.v, -HV_REPORT_MAX, HV_REPORT_MAX);
+    coalescer.buttons = report->buttons;
+    return true;
+}
+
+/*
+ * Spacing out reads only helps when it is the reads that push the loop over budget:
+ * if passes without one are over budget too, they would just get fewer reports.
+ */
+static void scheduler_adjust_backoff(void) {
+    const uint32_t loop_us      = scheduler.loop_q >> SCHEDULER_LOOP_SMOOTHING;
+    const uint32_t loop_skip_us = scheduler.loop_skip_q >> SCHEDULER_LOOP_SMOOTHING;
+    if (loop_us > POINTING_SCHEDULER_LOOP_BUDGET_US && loop_skip_us < POINTING_SCHEDULER_LOOP_BUDGET_US) {
+        scheduler.backoff_us += SCHEDULER_BACKOFF_STEP;
+        if (scheduler.backoff_us > POINTING_SCHEDULER_BACKOFF_MAX_US) {
+            scheduler.backoff_us = POINTING_SCHEDULER_BACKOFF_MAX_US;
+        }
+    } else if (loop_us < POINTING_SCHEDULER_LOOP_BUDGET_US * 3 / 4 || loop_skip_us >= POINTING_SCHEDULER_LOOP_BUDGET_US) {
+        // under budget with some margin, so it does not flap around the limit
+        scheduler.backoff_us = scheduler.backoff_us > SCHEDULER_BACKOFF_STEP ? scheduler.backoff_us - SCHEDULER_BACKOFF_STEP : 0;
+    }
+}
+
+bool pointing_scheduler_poll(void) {
+    const uint32_t now = POINTING_SCHEDULER_TICKS();
+    if (!scheduler.started) {
+        scheduler.started   = true;
+        scheduler.last_call = now;
+        scheduler.last_read = now;
+        scheduler.did_read  = true;
+        scheduler.reads++;
+        return true;
+    }
+    const uint32_t period = (now - scheduler.last_call) / POINTING_SCHEDULER_TICKS_PER_US;
+    scheduler.loop_q += period - (scheduler.loop_q >> SCHEDULER_LOOP_SMOOTHING);
+    if (!scheduler.did_read) {
+        scheduler.loop_skip_q += period - (scheduler.loop_skip_q >> SCHEDULER_LOOP_SMOOTHING);
+    }
+    scheduler.last_call = now;
+
+    if (!scheduler.idle && now - scheduler.last_motion >= SCHEDULER_US(POINTING_SCHEDULER_IDLE_TIMEOUT_MS * 1000UL)) {
+        scheduler.idle       = true;
+        scheduler.backoff_us = 0;
+    }
+    const uint32_t interval = scheduler.idle ? POINTING_SCHEDULER_IDLE_INTERVAL_US : scheduler.backoff_us;
+    scheduler.did_read      = !interval || now - scheduler.last_read >= SCHEDULER_US(interval);
+    if (scheduler.synced) {
+        // once ahead of each poll, however far apart the other half spaces those
+        scheduler.did_read = !scheduler.sync_read && coalescer_frame_due(now + SCHEDULER_READ_LEAD());
+    } else if (!scheduler.idle) {
+        // more than one read per report would only be added up again
+        scheduler.did_read = scheduler.did_read && coalescer_frame_due(now + SCHEDULER_READ_LEAD());
+    }
+    if (!scheduler.did_read) {
+        scheduler.skipped++;
+        return false;
+    }
+    if (!scheduler.idle && !scheduler.synced) {
+        scheduler_adjust_backoff();
+    }
+    scheduler.last_read = now;
+    scheduler.sync_read = scheduler.synced;
+    scheduler.reads++;
+    return true;
+}
+
+void pointing_scheduler_motion(bool motion) {
+    if (motion) {
+        scheduler.last_motion = scheduler.last_read;
+        scheduler.idle        = false;
+    }
+}
+
+/* The frame grid is the other half's polls from now on; it comes from the split transport,
+ * between passes, and each store is a single word. */
+void pointing_scheduler_sync(uint16_t next_us) {
+    coalescer.next_frame = POINTING_SCHEDULER_TICKS() + SCHEDULER_US(next_us) - SCHEDULER_READ_LEAD();
+    coalescer.gridded    = true;
+    scheduler.sync_read  = false;
+    scheduler.synced     = true;
+}
+
+pointing_scheduler_stats_t pointing_scheduler_stats(void) {
+    return (pointing_scheduler_stats_t){
+        .reads      = scheduler.reads,
+        .skipped    = scheduler.skipped,
+        .loop_us    = scheduler.loop_q >> SCHEDULER_LOOP_SMOOTHING,
+        .backoff_us = scheduler.backoff_us,
+        .idle       = scheduler.idle,
+    };
+}
+
+#ifdef POINTING_DEVICE_DRIVER_custom
+#    include "pmw33xx_common.h"
+#    ifdef PMW33XX_ASYNC_ENABLE
+#        include "pmw33xx_async.h"
+#    endif
+
+/* QMK's PMW33xx driver (`pmw33xx_get_report()`), behind the scheduler.  Reads after a
+ * longer gap can exceed the report range; the excess goes out with the following ones.
+ * With `PMW33XX_ASYNC_ENABLE`, the read is decided on and its burst started at the end of
+ * the pass before, and collected here. */
+
+static struct {
+    bool     ready; // initialized, on the half with the sensor
+    uint16_t cpi;   // on the other half, as set, for `split_motion.c` to pass on
+    int32_t  x;     // read, not reported yet
+    int32_t  y;
+} driver;
+
+static void driver_add(const pmw33xx_report_t *report) {
+    const bool motion = report->motion.b.is_motion && !report->motion.b.is_lifted;
+    pointing_scheduler_motion(motion);
+    if (motion) {
+        driver.x += report->delta_x;
+        driver.y += report->delta_y;
+    }
+}
+
+#    ifdef PMW33XX_ASYNC_ENABLE
+void pointing_scheduler_prefetch(void) {
+    if (driver.ready && pointing_scheduler_poll()) {
+        pmw33xx_async_start();
+    }
+}
+
+void pointing_scheduler_advance(void) {
+    pmw33xx_async_advance();
+}
+#    endif // PMW33XX_ASYNC_ENABLE
+
+void pointing_device_driver_init(void) {
+#    ifdef SPLIT_MOTION_ENABLE
+    if (!SPLIT_MOTION_SENSOR_HERE()) {
+        // no sensor on this half, its motion comes over `split_motion.c`
+        return;
+    }
+#    endif
+#    ifdef PMW33XX_ASYNC_ENABLE
+    pmw33xx_async_init();
+#    else
+    pmw33xx_init(0);
+#    endif
+    driver.ready = true;
+}
+
+report_mouse_t pointing_device_driver_get_report(report_mouse_t mouse_report) {
+    if (!driver.ready) {
+        return mouse_report;
+    }
+#    ifdef PMW33XX_ASYNC_ENABLE
+    pmw33xx_report_t report;
+    if (pmw33xx_async_collect(&report)) {
+        driver_add(&report);
+    }
+#    else
+    if (pointing_scheduler_poll()) {
+        const pmw33xx_report_t report = pmw33xx_read_burst(0);
+        driver_add(&report);
+    }
+#    endif
+    mouse_report.x = coalescer_take(&driver.x, XY_REPORT_MIN, XY_REPORT_MAX);
+    mouse_report.y = coalescer_take(&driver.y, XY_REPORT_MIN, XY_REPORT_MAX);
+    return mouse_report;
+}
+
+uint16_t pointing_device_driver_get_cpi(void) {
+    if (!driver.ready) {
+        return driver.cpi;
+    }
+#    ifdef PMW33XX_ASYNC_ENABLE
+    return pmw33xx_async_get_cpi();
+#    else
+    return pmw33xx_get_cpi(0);
+#    endif
+}
+
+void pointing_device_driver_set_cpi(uint16_t cpi) {
+    if (!driver.ready) {
+        driver.cpi = cpi;
+        return;
+    }
+#    ifdef PMW33XX_ASYNC_ENABLE
+    pmw33xx_async_set_cpi(cpi);
+#    else
+    pmw33xx_set_cpi(0, cpi);
+#    endif
+}
+#endif // POINTING_DEVICE_DRIVER_custom
@@ -0,0 +1,111 @@
+/**
+ * Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "report.h"
+
+/**
+ * \brief Adaptive sensor polling, in place of `POINTING_DEVICE_TASK_THROTTLE_MS`.
+ *
+ * A custom pointing device driver around QMK's PMW33xx one decides on every pointing
+ * task whether to do the SPI motion burst or to report no motion right away:
+ *
+ * - at rest, the sensor is read every `POINTING_SCHEDULER_IDLE_INTERVAL_US`; it keeps
+ *   accumulating motion in between, so nothing is lost, and the first movement is seen
+ *   at most one interval late;
+ * - from the first motion on, it is read on every pass, until there was none for
+ *   `POINTING_SCHEDULER_IDLE_TIMEOUT_MS`;
+ * - only while the smoothed main loop period is over `POINTING_SCHEDULER_LOOP_BUDGET_US`,
+ *   and passes without a read would fit it, are reads during motion spaced out, by up to
+ *   `POINTING_SCHEDULER_BACKOFF_MAX_US`, and brought back to every pass once under budget.
+ *
+ * Reads during motion are therefore as frequent as the loop allows, and each report's
+ * interval, which maccel measures, is one loop pass or a fixed backoff instead of a
+ * millisecond-quantized throttle.
+ *
+ * With `POINTING_SCHEDULER_REPORT_INTERVAL_US`, one USB frame by default, reports are also
+ * coalesced: `pointing_scheduler_coalesce()` holds motion and scroll back between frames,
+ * so QMK sends nothing, and hands them to maccel in one report per frame, whose elapsed
+ * time is then the true one.  Reads during motion are kept to one per frame as well, on
+ * the half that coalesces or is synced to the other's polls; elsewhere there are no frames.
+ * Button changes go out right away.
+ *
+ * With `PMW33XX_ASYNC_ENABLE`, the motion burst does not hold up the pointing task: whether
+ * to read is decided at the end of the pass before, by `pointing_scheduler_prefetch()`, which
+ * starts the burst, `pointing_scheduler_advance()` moves it along after the matrix scan, and
+ * the driver collects it (see `pmw33xx_async.h`).  The CPI is then answered without the
+ * sensor, and set before its next burst.
+ *
+ * With `SPLIT_MOTION_ENABLE`, the half without the sensor uses the scheduler to poll the
+ * other one over the split transport instead, and that half reads its sensor once ahead of
+ * each poll (see `split_motion.h`).
+ */
+
+#ifndef POINTING_SCHEDULER_IDLE_INTERVAL_US
+#    define POINTING_SCHEDULER_IDLE_INTERVAL_US 4000 // sensor read period at rest
+#endif
+#ifndef POINTING_SCHEDULER_IDLE_TIMEOUT_MS
+#    define POINTING_SCHEDULER_IDLE_TIMEOUT_MS 200 // no motion for this long slows reads down
+#endif
+#ifndef POINTING_SCHEDULER_LOOP_BUDGET_US
+#    define POINTING_SCHEDULER_LOOP_BUDGET_US 1000 // main loop pass, one USB frame
+#endif
+#ifndef POINTING_SCHEDULER_BACKOFF_MAX_US
+#    define POINTING_SCHEDULER_BACKOFF_MAX_US 4000 // reads during motion are never further apart
+#endif
+#ifndef POINTING_SCHEDULER_REPORT_INTERVAL_US
+#    ifdef USB_POLLING_INTERVAL_MS
+#        define POINTING_SCHEDULER_REPORT_INTERVAL_US (USB_POLLING_INTERVAL_MS * 1000)
+#    else
+#        define POINTING_SCHEDULER_REPORT_INTERVAL_US 1000 // one report per host poll, 0 for one per pass
+#    endif
+#endif
+
+typedef struct {
+    uint32_t reads;      // motion bursts done
+    uint32_t skipped;    // pointing tasks answered without one
+    uint32_t loop_us;    // smoothed main loop period
+    uint32_t backoff_us; // current spacing of reads during motion, 0 for every pass
+    bool     idle;
+} pointing_scheduler_stats_t;
+
+/** Once per pointing task: whether to read the sensor this time. */
+bool pointing_scheduler_poll(void);
+/** After each read: whether it saw motion. */
+void pointing_scheduler_motion(bool motion);
+#ifdef PMW33XX_ASYNC_ENABLE
+/** From `housekeeping_task_user()`, in place of the pointing task's poll: start the next pass's read, if due. */
+void pointing_scheduler_prefetch(void);
+/** From `matrix_scan_user()`: the read's next step, while key events and RGB run. */
+void pointing_scheduler_advance(void);
+#endif
+/**
+ * On the half with the sensor, from `split_motion.c` when the other half polls it for the
+ * motion: reads are then timed for its polls, one ahead of each, and the next may come as
+ * soon as `next_us` after this one.
+ */
+void pointing_scheduler_sync(uint16_t next_us);
+/**
+ * In `pointing_device_task_user()`, before maccel: whether a report is due on this pass.
+ * If not, its motion and scroll are kept and `report` is left with none; if so, `report`
+ * carries all that was kept, as much as fits in one report, and the rest waits a frame.
+ */
+bool pointing_scheduler_coalesce(report_mouse_t *report);
+
+pointing_scheduler_stats_t pointing_scheduler_stats(void);
@@ -0,0 +1,221 @@
+/**
+ * Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "quantum.h"
+#include "profiler.h"
+#include "timebase.h"
+#ifdef VIA_ENABLE
+#    include "via.h"
+#endif
+
+#ifdef PROFILER_ENABLE
+
+/**
+ * Tick source, the keymap's shared timebase (see `timebase.h`); override both macros for
+ * another counter.
+ */
+#ifndef PROFILER_TICKS
+#    define PROFILER_TICKS() TIMEBASE_TICKS()
+#    define PROFILER_TICKS_PER_US TIMEBASE_TICKS_PER_US
+#    ifdef TIMEBASE_DWT
+#        define PROFILER_DWT
+#    endif
+#endif
+
+#ifndef PROFILER_HISTOGRAM_SHIFT
+#    if PROFILER_TICKS_PER_US > 1
+#        define PROFILER_HISTOGRAM_SHIFT 8 // cycles: bucket 0 below 256
+#    else
+#        define PROFILER_HISTOGRAM_SHIFT 3 // microseconds: bucket 0 below 8
+#    endif
+#endif
+_Static_assert(PROFILER_HISTOGRAM_BUCKETS >= 2 && PROFILER_HISTOGRAM_BUCKETS <= 13, "PROFILER_HISTOGRAM_BUCKETS out of range, a VIA reply holds 13");
+
+static profiler_stats_t profiler_data[PROFILE_STAGES];
+
+static struct {
+    uint8_t  stage; // the one being timed, PROFILE_STAGES before the first mark
+    uint32_t since; // its entry
+    uint32_t loop;  // last SCAN mark
+    bool     looped;
+    uint8_t  dumping; // next stage to print, PROFILE_STAGES when not dumping
+} profiler = {.stage = PROFILE_STAGES, .dumping = PROFILE_STAGES};
+
+#ifdef CONSOLE_ENABLE
+static const char *const profiler_names[PROFILE_STAGES] = {
+    [PROFILE_SCAN]         = "SCAN",
+    [PROFILE_KEYS]         = "KEYS",
+    [PROFILE_RGB]          = "RGB",
+    [PROFILE_OTHER]        = "OTHER",
+    [PROFILE_POINTING]     = "POINT",
+    [PROFILE_SEND]         = "SEND",
+    [PROFILE_SPLIT]        = "SPLIT",
+    [PROFILE_HOUSEKEEPING] = "HOUSE",
+    [PROFILE_LOOP]         = "LOOP",
+};
+#endif
+
+void profiler_init(void) {
+#ifdef PROFILER_DWT
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    profiler_reset();
+}
+
+void profiler_reset(void) {
+    memset(profiler_data, 0, sizeof(profiler_data));
+    profiler.looped = false;
+}
+
+uint8_t profiler_histogram_bucket(uint32_t ticks) {
+    ticks >>= PROFILER_HISTOGRAM_SHIFT;
+    const uint8_t bucket = ticks ? 32 - __builtin_clz(ticks) : 0;
+    return bucket < PROFILER_HISTOGRAM_BUCKETS ? bucket : PROFILER_HISTOGRAM_BUCKETS - 1;
+}
+
+static void profiler_add(profiler_stats_t *stats, uint32_t ticks) {
+    if (stats->count == 0 || ticks < stats->min) {
+        stats->min = ticks;
+    }
+    if (ticks > stats->max) {
+        stats->max = ticks;
+    }
+    stats->count++;
+    stats->sum += ticks;
+    uint16_t *bucket = &stats->histogram[profiler_histogram_bucket(ticks)];
+    if (*bucket < UINT16_MAX) {
+        (*bucket)++;
+    }
+}
+
+void profiler_mark(profile_stage_t stage) {
+    const uint32_t now = PROFILER_TICKS();
+    if (profiler.stage < PROFILE_STAGES) {
+        profiler_add(&profiler_data[profiler.stage], now - profiler.since);
+    }
+    if (stage == PROFILE_SCAN) {
+        if (profiler.looped) {
+            profiler_add(&profiler_data[PROFILE_LOOP], now - profiler.loop);
+        }
+        profiler.loop   = now;
+        profiler.looped = true;
+    }
+    profiler.stage = stage;
+    profiler.since = now;
+}
+
+const profiler_stats_t *profiler_stats(profile_stage_t stage) {
+    return &profiler_data[stage];
+}
+
+static inline uint32_t profiler_average(const profiler_stats_t *stats) {
+    return stats->count ? stats->sum / stats->count : 0;
+}
+
+void profiler_dump(void) {
+    profiler.dumping = 0;
+}
+
+void profiler_task(void) {
+#ifdef CONSOLE_ENABLE
+    // one line per call, so a dump never stalls the loop it measures
+    if (profiler.dumping >= PROFILE_STAGES) {
+        return;
+    }
+    const profiler_stats_t *stats = &profiler_data[profiler.dumping];
+    printf("PF:%-5s n:%lu min:%lu avg:%lu max:%lu ticks/us:%u |", profiler_names[profiler.dumping], (unsigned long)stats->count, (unsigned long)stats->min, (unsigned long)profiler_average(stats), (unsigned long)stats->max, (unsigned)PROFILER_TICKS_PER_US);
+    for (uint8_t i = 0; i < PROFILER_HISTOGRAM_BUCKETS; i++) {
+        printf(" %u", stats->histogram[i]);
+    }
+    printf("\n");
+    profiler.dumping++;
+#else
+    profiler.dumping = PROFILE_STAGES;
+#endif // CONSOLE_ENABLE
+}
+
+#ifdef VIA_ENABLE
+enum via_profiler_channel {
+    // clang-format off
+    id_profiler = 25
+    // clang-format on
+};
+enum via_profiler_ids {
+    // clang-format off
+    id_profiler_stats     = 1,
+    id_profiler_histogram = 2,
+    id_profiler_reset     = 3,
+    id_profiler_dump      = 4
+    // clang-format on
+};
+
+static uint8_t *profiler_put_u32(uint8_t *data, uint32_t value) {
+    data[0] = value & 0xFF;
+    data[1] = (value >> 8) & 0xFF;
+    data[2] = (value >> 16) & 0xFF;
+    data[3] = value >> 24;
+    return data + 4;
+}
+
+// data = [ command, channel, value_id, value_data... ], true if it was for the profiler
+bool profiler_via_command(uint8_t *data, uint8_t length) {
+    if (data[1] != id_profiler) {
+        return false;
+    }
+    uint8_t *value = &data[3];
+    switch (data[0]) {
+        case id_custom_get_value: {
+            if (value[0] >= PROFILE_STAGES) {
+                value[0] = 0xFF; // no such stage
+                break;
+            }
+            const profiler_stats_t *stats = &profiler_data[value[0]];
+            if (data[2] == id_profiler_stats) {
+                value[1] = PROFILER_TICKS_PER_US;
+                uint8_t *next = profiler_put_u32(&value[2], stats->count);
+                next          = profiler_put_u32(next, stats->min);
+                next          = profiler_put_u32(next, profiler_average(stats));
+                profiler_put_u32(next, stats->max);
+            } else if (data[2] == id_profiler_histogram) {
+                value[1] = PROFILER_HISTOGRAM_BUCKETS;
+                for (uint8_t i = 0; i < PROFILER_HISTOGRAM_BUCKETS; i++) {
+                    value[2 + i * 2] = stats->histogram[i] & 0xFF;
+                    value[3 + i * 2] = stats->histogram[i] >> 8;
+                }
+            } else {
+                data[0] = id_unhandled;
+            }
+            break;
+        }
+        case id_custom_set_value:
+            if (data[2] == id_profiler_reset) {
+                profiler_reset();
+            } else if (data[2] == id_profiler_dump) {
+                profiler_dump();
+            } else {
+                data[0] = id_unhandled;
+            }
+            break;
+        default:
+            data[0] = id_unhandled;
+            break;
+    }
+    return true;
+}
+#endif // VIA_ENABLE
+
+#endif // PROFILER_ENABLE
@@ -0,0 +1,92 @@
+/**
+ * Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * \brief Where the time of each main loop iteration goes.
+ *
+ * The keymap's hooks mark where the loop enters each stage; the time until the next
+ * mark is counted to that stage.  QMK calls the hooks in this order on every pass:
+ *
+ *     SCAN   housekeeping end -> `matrix_scan_user()`: matrix scan, debounce, split
+ *            matrix exchange, the USB driver's own task
+ *     KEYS   -> next hook: tap-hold engine, `process_record_user()`, quantum tasks and,
+ *            on passes without an RGB frame, the sensor read
+ *     RGB    `rgb_matrix_indicators_advanced_user()`
+ *     OTHER  -> `pointing_device_task_user()`: LED flush, sensor read
+ *     POINT  `pointing_device_task_user()`, i.e. maccel
+ *     SEND   -> `housekeeping_task_user()`: report sent over USB, led task
+ *     SPLIT  `user_state_task()`, the split state sync
+ *     HOUSE  rest of housekeeping (maccel CPI, EEPROM, LUT)
+ *
+ * LOOP is the whole iteration, SCAN mark to SCAN mark.  A stage without its hook
+ * on a pass (no RGB frame, throttled pointing task) is simply not entered.
+ *
+ * Ticks are CPU cycles where the MCU has a cycle counter (Cortex-M3 and up), else
+ * microseconds; `PROFILER_TICKS_PER_US` converts.  Per stage, count, min, max, sum
+ * and a log2 histogram are kept in RAM.  Without `PROFILER_ENABLE` every mark
+ * compiles out.
+ *
+ * Reading out, on demand:
+ * - console: `profiler_dump()` prints a `PF:` line per stage, one per housekeeping call;
+ * - VIA, channel `id_profiler` (25): get-value of id 1 with the stage in the first value
+ *   byte returns `[stage, ticks/us, count:u32, min:u32, avg:u32, max:u32]`, id 2 returns
+ *   `[stage, buckets, count:u16 ...]`, set-value of id 3 resets, id 4 dumps to the console.
+ *   Multi-byte values are little endian.
+ */
+typedef enum {
+    PROFILE_SCAN = 0,
+    PROFILE_KEYS,
+    PROFILE_RGB,
+    PROFILE_OTHER,
+    PROFILE_POINTING,
+    PROFILE_SEND,
+    PROFILE_SPLIT,
+    PROFILE_HOUSEKEEPING,
+    PROFILE_LOOP,
+    PROFILE_STAGES,
+} profile_stage_t;
+
+#ifndef PROFILER_HISTOGRAM_BUCKETS
+#    define PROFILER_HISTOGRAM_BUCKETS 12 // bucket 0 below 2^SHIFT ticks, then one per doubling
+#endif
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint16_t histogram[PROFILER_HISTOGRAM_BUCKETS]; // saturating
+} profiler_stats_t;
+
+#ifdef PROFILER_ENABLE
+#    define PROFILE_MARK(stage) profiler_mark(stage)
+
+void                    profiler_init(void);
+void                    profiler_mark(profile_stage_t stage);
+void                    profiler_reset(void);
+const profiler_stats_t *profiler_stats(profile_stage_t stage);
+uint8_t                 profiler_histogram_bucket(uint32_t ticks);
+void                    profiler_dump(void);
+void                    profiler_task(void);
+bool                    profiler_via_command(uint8_t *data, uint8_t length);
+#else
+#    define PROFILE_MARK(stage) ((void)0)
+#endif // PROFILER_ENABLE
@@ -3,14 +3,77 @@ REPEAT_KEY_ENABLE = yes
 CAPS_WORD_ENABLE = yes
 COMBO_ENABLE = no
 CONSOLE_ENABLE = no
+# high-resolution drag-scroll only for hosts that support it (see `config.h`)
+OS_DETECTION_ENABLE = yes
 
 # MACCEL
 MACCEL_ENABLE = yes
 ;MACCEL_VIA_ENABLE = yes
+MACCEL_TRACE_ENABLE = no
+MACCEL_TELEMETRY_ENABLE = no
 ifeq ($(strip $(VIA_ENABLE)), yes)
    	OPT_DEFS += -DMACCEL_ENABLE
 	SRC += ./maccel/maccel.c
 	ifeq ($(strip $(MACCEL_VIA_ENABLE)), yes)
 		SRC += ./maccel/maccel_via.c
+		OPT_DEFS += -DMACCEL_VIA_ENABLE
 	endif
+	ifeq ($(strip $(MACCEL_TRACE_ENABLE)), yes)
+		SRC += ./maccel/maccel_trace.c
+		OPT_DEFS += -DMACCEL_TRACE_ENABLE
+	endif
+	ifeq ($(strip $(MACCEL_TELEMETRY_ENABLE)), yes)
+		SRC += ./maccel/maccel_telemetry.c
+		OPT_DEFS += -DMACCEL_TELEMETRY_ENABLE
+	endif
+endif
+
+# RGB indicators (no-op without RGB_MATRIX_ENABLE)
+SRC += ./indicators.c
+
+# Layer-lock chords of a layer-tap thumb and a pinky key, in place of combos (see `lock_chords.h`)
+LOCK_CHORDS_ENABLE = yes
+ifeq ($(strip $(LOCK_CHORDS_ENABLE)), yes)
+	SRC += ./lock_chords.c
+	OPT_DEFS += -DLOCK_CHORDS_ENABLE
+endif
+
+# Keycodes resolved once per layer change, overlay layers read sparsely from RAM (see `keycode_cache.h`);
+# off until measured on the keyboard: with the keymap in RAM, as on RP2040, the host bench has it slower
+KEYCODE_CACHE_ENABLE = no
+ifeq ($(strip $(KEYCODE_CACHE_ENABLE)), yes)
+	SRC += ./keycode_cache.c
+	OPT_DEFS += -DKEYCODE_CACHE_ENABLE
+endif
+
+# Adaptive sensor polling, in place of POINTING_DEVICE_TASK_THROTTLE_MS (see `pointing_scheduler.h`):
+# QMK's PMW3360 driver is built in as a custom one, with the scheduler in front.
+POINTING_SCHEDULER_ENABLE = yes
+PMW33XX_ASYNC_ENABLE = yes
+SPLIT_MOTION_ENABLE = no
+ifeq ($(strip $(POINTING_SCHEDULER_ENABLE)), yes)
+	POINTING_DEVICE_DRIVER = custom
+	VPATH += drivers/sensors
+	SRC += drivers/sensors/pmw33xx_common.c drivers/sensors/pmw3360.c
+	QUANTUM_LIB_SRC += spi_master.c
+	SRC += ./pointing_scheduler.c
+	OPT_DEFS += -DPOINTING_SCHEDULER_ENABLE
+	# the motion burst started at the end of a pass and collected in the next (see `pmw33xx_async.h`)
+	ifeq ($(strip $(PMW33XX_ASYNC_ENABLE)), yes)
+		SRC += ./pmw33xx_async.c
+		OPT_DEFS += -DPMW33XX_ASYNC_ENABLE
+	endif
+	# with USB on the other half, maccel runs on the trackball one and the master polls
+	# its motion over one RPC, instead of QMK's split pointing (see `split_motion.h`)
+	ifeq ($(strip $(SPLIT_MOTION_ENABLE)), yes)
+		SRC += ./split_motion.c
+		OPT_DEFS += -DSPLIT_MOTION_ENABLE
+	endif
+endif
+
+# Per-stage timing of the main loop, read over VIA or the console (see `profiler.h`)
+PROFILER_ENABLE = no
+ifeq ($(strip $(PROFILER_ENABLE)), yes)
+	SRC += ./profiler.c
+	OPT_DEFS += -DPROFILER_ENABLE
 endif
@@ -0,0 +1,353 @@
+/**
+ * Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stddef.h>
+#include "quantum.h"
+#include "transactions.h"
+#include "atomic_util.h"
+#include "pointing_scheduler.h"
+#include "split_motion.h"
+#include "timebase.h"
+#ifdef MACCEL_ENABLE
+#    include "maccel/maccel.h"
+#endif
+
+/**
+ * Timebase of the elapsed times, the keymap's shared one (see `timebase.h`).  Pauses longer
+ * than the counter's wrap-around are caught on the millisecond timer.
+ */
+#ifndef SPLIT_MOTION_TICKS
+#    define SPLIT_MOTION_TICKS() TIMEBASE_TICKS()
+#    define SPLIT_MOTION_TICKS_PER_US TIMEBASE_TICKS_PER_US
+#endif
+
+enum split_motion_packet_flags {
+    SPLIT_MOTION_ACCELERATED = 1 << 0, // the motion is maccel's output
+    SPLIT_MOTION_RESYNC      = 1 << 1, // the sensor half has not had a request and every profile since it started
+};
+
+enum split_motion_request_flags {
+    SPLIT_MOTION_SEND_RAW = 1 << 0, // leave acceleration to the master
+};
+
+/* The reply to every poll, with or without motion: RPC replies are of the size the master
+ * asks for, so there is no shorter one for nothing to report. */
+typedef struct __attribute__((packed)) {
+    uint8_t  flags;
+    uint16_t elapsed_us; // sensor time from the previous packet's last motion to this one's
+    int16_t  x;
+    int16_t  y;
+} split_motion_packet_t;
+
+/* Sent only when it differs from the previous one, or with a profile; otherwise polls go
+ * with an empty request, which QMK's RPC sends in one transaction less. */
+typedef struct __attribute__((packed)) {
+    uint16_t cpi;
+    uint16_t next_poll_us; // from this poll to the next
+    uint8_t  profile;      // maccel's active one
+    uint8_t  flags;
+#ifdef MACCEL_ENABLE
+    // only when a profile is not on the other half as it is here
+    uint8_t         index;
+    maccel_config_t config;
+#endif
+} split_motion_request_t;
+
+#ifdef MACCEL_ENABLE
+#    define SPLIT_MOTION_REQUEST_SHORT offsetof(split_motion_request_t, index)
+#    define SPLIT_MOTION_PROFILES_ALL ((uint8_t)((1U << MACCEL_PROFILE_COUNT) - 1))
+_Static_assert(MACCEL_PROFILE_COUNT <= 8, "split_motion keeps maccel profiles in a byte of flags");
+#else
+#    define SPLIT_MOTION_REQUEST_SHORT sizeof(split_motion_request_t)
+#endif
+#ifdef RPC_M2S_BUFFER_SIZE
+_Static_assert(sizeof(split_motion_request_t) <= RPC_M2S_BUFFER_SIZE, "split_motion request over RPC_M2S_BUFFER_SIZE");
+_Static_assert(sizeof(split_motion_packet_t) <= RPC_S2M_BUFFER_SIZE, "split_motion packet over RPC_S2M_BUFFER_SIZE");
+#endif
+
+#define SPLIT_MOTION_POLL_STEP_US 250 // of the margin for when polls come
+
+// as much of a pending amount as fits in `min`..`max`, leaving the rest
+static int32_t split_motion_clamp(int32_t *pending, int32_t min, int32_t max) {
+    const int32_t amount = *pending < min ? min : *pending > max ? max : *pending;
+    *pending -= amount;
+    return amount;
+}
+
+/*
+ * The sensor half: motion not polled yet, and what the master sent with its last poll.  Polls
+ * are handled by the split transport between any two instructions of the main loop, which
+ * therefore only touches this in atomic blocks.
+ */
+static struct {
+    int32_t  x;
+    int32_t  y;
+    uint32_t elapsed_us;     // from the last motion polled to the latest
+    uint32_t last_motion;    // ticks
+    uint32_t last_motion_ms; // timer
+    bool     accelerated;
+    bool     polled;
+    uint16_t cpi;
+    uint16_t next_poll_us;
+    uint8_t  profile;
+    uint8_t  flags;
+#ifdef MACCEL_ENABLE
+    maccel_config_t profiles[MACCEL_PROFILE_COUNT];
+    uint8_t         incoming; // of those, not taken on yet
+    uint8_t         received; // since startup
+#endif
+} sensor;
+
+static void split_motion_slave_handler(uint8_t in_buflen, const void *in_data, uint8_t out_buflen, void *out_data) {
+    const split_motion_request_t *const request = in_data;
+    split_motion_packet_t *const        packet  = out_data;
+    if ((in_buflen != 0 && in_buflen < SPLIT_MOTION_REQUEST_SHORT) || out_buflen != sizeof(*packet)) {
+        return;
+    }
+    if (in_buflen != 0) {
+        sensor.cpi          = request->cpi;
+        sensor.next_poll_us = request->next_poll_us;
+        sensor.profile      = request->profile;
+        sensor.flags        = request->flags;
+        sensor.polled       = true;
+    }
+    if (sensor.polled) {
+        pointing_scheduler_sync(sensor.next_poll_us);
+    }
+    packet->flags = sensor.accelerated ? SPLIT_MOTION_ACCELERATED : 0;
+    if (!sensor.polled) {
+        packet->flags |= SPLIT_MOTION_RESYNC;
+    }
+#ifdef MACCEL_ENABLE
+    if (in_buflen == sizeof(*request) && request->index < MACCEL_PROFILE_COUNT) {
+        memcpy(&sensor.profiles[request->index], &request->config, sizeof(maccel_config_t));
+        sensor.incoming |= 1 << request->index;
+        sensor.received |= 1 << request->index;
+    }
+    if (sensor.received != SPLIT_MOTION_PROFILES_ALL) {
+        packet->flags |= SPLIT_MOTION_RESYNC;
+    }
+#endif
+    packet->elapsed_us = sensor.elapsed_us < UINT16_MAX ? sensor.elapsed_us : UINT16_MAX;
+    packet->x          = split_motion_clamp(&sensor.x, INT16_MIN, INT16_MAX);
+    packet->y          = split_motion_clamp(&sensor.y, INT16_MIN, INT16_MAX);
+    sensor.elapsed_us  = 0;
+}
+
+report_mouse_t split_motion_send(report_mouse_t mouse_report) {
+    if (mouse_report.x == 0 && mouse_report.y == 0) {
+        return mouse_report;
+    }
+    const uint32_t now        = SPLIT_MOTION_TICKS();
+    uint32_t       elapsed_us = (now - sensor.last_motion) / SPLIT_MOTION_TICKS_PER_US;
+    if (timer_elapsed32(sensor.last_motion_ms) > UINT16_MAX / 1000) {
+        elapsed_us = UINT16_MAX;
+    }
+    sensor.last_motion    = now;
+    sensor.last_motion_ms = timer_read32();
+#ifdef MACCEL_ENABLE
+    const bool accelerate = !(sensor.flags & SPLIT_MOTION_SEND_RAW);
+    if (accelerate) {
+        mouse_report = pointing_device_task_maccel(mouse_report);
+    }
+#else
+    const bool accelerate = false;
+#endif
+    ATOMIC_BLOCK_FORCEON {
+        sensor.x += mouse_report.x;
+        sensor.y += mouse_report.y;
+        sensor.elapsed_us += elapsed_us;
+        sensor.accelerated = accelerate;
+    }
+    // this half sends no reports of its own
+    mouse_report.x = 0;
+    mouse_report.y = 0;
+    return mouse_report;
+}
+
+// what the last poll sent, for the main loop to apply
+static void split_motion_apply(void) {
+    uint16_t cpi;
+    bool     polled;
+#ifdef MACCEL_ENABLE
+    uint8_t profile;
+    uint8_t incoming;
+#endif
+    ATOMIC_BLOCK_FORCEON {
+        cpi    = sensor.cpi;
+        polled = sensor.polled;
+#ifdef MACCEL_ENABLE
+        profile  = sensor.profile;
+        incoming = sensor.incoming;
+        for (uint8_t i = 0; i < MACCEL_PROFILE_COUNT; i++) {
+            if (incoming & (1 << i)) {
+                g_maccel_profiles[i] = sensor.profiles[i];
+            }
+        }
+        sensor.incoming = 0;
+#endif
+    }
+    if (!polled) {
+        return;
+    }
+    if (cpi && cpi != pointing_device_get_cpi()) {
+        pointing_device_set_cpi(cpi);
+#ifdef MACCEL_ENABLE
+        maccel_cpi_changed();
+#endif
+    }
+#ifdef MACCEL_ENABLE
+    if (incoming) {
+        maccel_profiles_changed();
+    }
+    if (profile != maccel_profile_get()) {
+        maccel_profile_select(profile);
+    }
+#endif
+}
+
+/* The master: motion polled and not reported yet, and what the other half has of its settings. */
+static struct {
+    int32_t                x;
+    int32_t                y;
+    uint32_t               elapsed_us; // sensor time the motion was read over
+    bool                   accelerated;
+    bool                   requested; // `request` is on the other half
+    split_motion_request_t request;
+#ifdef MACCEL_ENABLE
+    maccel_config_t sent[MACCEL_PROFILE_COUNT];
+    uint8_t         synced; // of those, the ones the other half has
+#endif
+} remote;
+
+// the earliest the scheduler may poll next, for the other half to have read its sensor by:
+// polls come in the first pass due, so up to about a loop period either side of where they
+// are due
+static uint16_t split_motion_next_poll_us(void) {
+    const pointing_scheduler_stats_t stats    = pointing_scheduler_stats();
+    uint32_t                         interval = stats.backoff_us > POINTING_SCHEDULER_REPORT_INTERVAL_US ? stats.backoff_us : POINTING_SCHEDULER_REPORT_INTERVAL_US;
+    if (stats.idle) {
+        interval = POINTING_SCHEDULER_IDLE_INTERVAL_US;
+    }
+    // in steps, so the request stays the same from one poll to the next
+    const uint32_t early = (stats.loop_us * 3 / 4 + SPLIT_MOTION_POLL_STEP_US / 2) / SPLIT_MOTION_POLL_STEP_US * SPLIT_MOTION_POLL_STEP_US;
+    return interval > early ? interval - early : 0;
+}
+
+#ifdef MACCEL_ENABLE
+// a profile the other half may not have as it is here, if any
+static uint8_t split_motion_stale_profile(void) {
+    for (uint8_t i = 0; i < MACCEL_PROFILE_COUNT; i++) {
+        if (!(remote.synced & (1 << i)) || memcmp(&remote.sent[i], &g_maccel_profiles[i], sizeof(maccel_config_t)) != 0) {
+            return i;
+        }
+    }
+    return MACCEL_PROFILE_NONE;
+}
+#endif
+
+static void split_motion_poll(void) {
+    split_motion_request_t request = {
+        .cpi          = pointing_device_get_cpi(),
+        .next_poll_us = split_motion_next_poll_us(),
+    };
+#ifdef SPLIT_MOTION_RAW
+    request.flags = SPLIT_MOTION_SEND_RAW;
+#endif
+#ifdef MACCEL_ENABLE
+    request.profile = maccel_profile_get();
+#    ifdef MACCEL_USE_DRAGSCROLL
+    if (maccel_dragscroll_is_enabled()) {
+        request.flags = SPLIT_MOTION_SEND_RAW;
+    }
+#    endif
+#endif
+    uint8_t length = 0;
+    if (!remote.requested || memcmp(&request, &remote.request, SPLIT_MOTION_REQUEST_SHORT) != 0) {
+        length = SPLIT_MOTION_REQUEST_SHORT;
+    }
+#ifdef MACCEL_ENABLE
+    const uint8_t stale = split_motion_stale_profile();
+    if (stale != MACCEL_PROFILE_NONE) {
+        request.index  = stale;
+        request.config = g_maccel_profiles[stale];
+        length         = sizeof(request);
+    }
+#endif
+    split_motion_packet_t packet;
+    if (!transaction_rpc_exec(SPLIT_MOTION_SYNC, length, &request, sizeof(packet), &packet)) {
+        return;
+    }
+    bool synced = remote.requested;
+    if (length != 0) {
+        remote.request   = request;
+        remote.requested = true;
+    }
+#ifdef MACCEL_ENABLE
+    if (stale != MACCEL_PROFILE_NONE) {
+        remote.sent[stale] = request.config;
+        remote.synced |= 1 << stale;
+    }
+    synced = synced && remote.synced == SPLIT_MOTION_PROFILES_ALL;
+#endif
+    if ((packet.flags & SPLIT_MOTION_RESYNC) && synced) {
+        // it restarted since, so it gets everything again
+        remote.requested = false;
+#ifdef MACCEL_ENABLE
+        remote.synced = 0;
+#endif
+    }
+    const bool motion = packet.x != 0 || packet.y != 0;
+    pointing_scheduler_motion(motion);
+    if (motion) {
+        remote.x += packet.x;
+        remote.y += packet.y;
+        remote.elapsed_us += packet.elapsed_us;
+        remote.accelerated = packet.flags & SPLIT_MOTION_ACCELERATED;
+    }
+}
+
+bool split_motion_take(report_mouse_t *mouse_report) {
+    if (remote.x == 0 && remote.y == 0) {
+        return false;
+    }
+    // the master has no sensor, so no motion of its own in the report
+    mouse_report->x = split_motion_clamp(&remote.x, XY_REPORT_MIN, XY_REPORT_MAX);
+    mouse_report->y = split_motion_clamp(&remote.y, XY_REPORT_MIN, XY_REPORT_MAX);
+    const uint32_t elapsed_us = remote.elapsed_us;
+    remote.elapsed_us         = 0;
+    if (remote.accelerated) {
+        return true;
+    }
+#ifdef MACCEL_ENABLE
+    maccel_report_elapsed(elapsed_us < UINT16_MAX ? elapsed_us : UINT16_MAX);
+#endif
+    return false;
+}
+
+void split_motion_task(void) {
+    if (!is_keyboard_master()) {
+        split_motion_apply();
+        return;
+    }
+    if (!SPLIT_MOTION_SENSOR_HERE() && is_transport_connected() && pointing_scheduler_poll()) {
+        split_motion_poll();
+    }
+}
+
+void split_motion_init(void) {
+    transaction_register_rpc(SPLIT_MOTION_SYNC, split_motion_slave_handler);
+}
@@ -0,0 +1,70 @@
+/**
+ * Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "quantum.h"
+
+/**
+ * \brief The trackball half's motion over one split transaction, accelerated where it is read.
+ *
+ * With QMK's `SPLIT_POINTING_ENABLE`, the master reads a checksum of the other half's latest
+ * report on every pass, and the report whenever that changed, then runs maccel on it, timed
+ * by when it arrived.  Instead, when USB is on the half without the sensor:
+ *
+ * - that half polls the other with one RPC, at the pace `pointing_scheduler.h` would read a
+ *   sensor: once per USB frame and a loop period ahead while moving, every
+ *   `POINTING_SCHEDULER_IDLE_INTERVAL_US` at rest, spaced out while its loop is over budget;
+ * - the sensor half reads its sensor once ahead of each poll, runs maccel on the motion with
+ *   its own timing, and adds it up until the poll takes it, as one fixed-size packet however
+ *   many reads it sums, with the sensor time from the previous packet's last motion to its own;
+ * - the master adds that to its next report as it is, without running maccel.
+ *
+ * While drag-scrolling, or always with `SPLIT_MOTION_RAW`, the counts go over unaccelerated
+ * and the master runs maccel on them, with the elapsed time measured on the sensor half (see
+ * `maccel_report_elapsed()`), so velocities come out the same whichever half is master.  The
+ * master sends what the other half needs, the CPI, the active profile and when it will poll
+ * next, with the polls where any of it changed, and, one per poll, any profile whose settings
+ * differ from what it last sent (all of it again after the other half restarted).
+ *
+ * When USB is on the sensor half, nothing goes over: it reads and accelerates as an unsplit
+ * keyboard would.  QMK's own split pointing is turned off in `config.h`.
+ */
+
+#ifndef POINTING_SCHEDULER_ENABLE
+#    error "SPLIT_MOTION_ENABLE needs POINTING_SCHEDULER_ENABLE, whose driver knows which half has the sensor"
+#endif
+
+#if defined(POINTING_DEVICE_LEFT)
+#    define SPLIT_MOTION_SENSOR_HERE() is_keyboard_left()
+#elif defined(POINTING_DEVICE_RIGHT)
+#    define SPLIT_MOTION_SENSOR_HERE() (!is_keyboard_left())
+#else
+#    error "SPLIT_MOTION_ENABLE needs POINTING_DEVICE_LEFT or POINTING_DEVICE_RIGHT"
+#endif
+
+/** From `keyboard_post_init_user()`. */
+void split_motion_init(void);
+/** From `housekeeping_task_user()`: the master polls the other half when due, that half takes on what it was sent. */
+void split_motion_task(void);
+/** On the half that is not master, in `pointing_device_task_user()`: keep the motion for the next poll, accelerated unless asked for raw counts. */
+report_mouse_t split_motion_send(report_mouse_t mouse_report);
+/**
+ * On the master, in `pointing_device_task_user()` once a report is due: the motion polled
+ * from the other half, as much as fits in `mouse_report`.  True if it is accelerated already,
+ * so maccel must not run on it; otherwise maccel is given its elapsed time.
+ */
+bool split_motion_take(report_mouse_t *mouse_report);
@@ -0,0 +1,46 @@
+/**
+ * Copyright 2024 Alyoxia (@alyoxia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/**
+ * \brief Free-running tick counter shared by maccel, the profiler, the sensor scheduler,
+ * the asynchronous sensor reads and split motion.
+ *
+ * `timer_read32()` counts milliseconds, too coarse for anything timed per report.  The
+ * RP2040 (M0+) has no DWT, but a 1 MHz system timer; Cortex-M3 and up have the DWT cycle
+ * counter, which ChibiOS starts for its realtime counter.  Elsewhere, the millisecond timer
+ * is all there is, and `TIMEBASE_HIGH_RESOLUTION` is left undefined.
+ *
+ * Ticks are 32 bits and wrap; compare differences only.  Override `TIMEBASE_TICKS()` and
+ * `TIMEBASE_TICKS_PER_US` (and `TIMEBASE_HIGH_RESOLUTION`) for another counter, as the
+ * host builds do; each module still takes its own override first.
+ */
+#ifndef TIMEBASE_TICKS
+#    if defined(PROTOCOL_CHIBIOS) && defined(MCU_RP)
+#        define TIMEBASE_TICKS() (TIMER->TIMERAWL) // RP2040 1 MHz system timer
+#        define TIMEBASE_TICKS_PER_US 1
+#        define TIMEBASE_HIGH_RESOLUTION
+#    elif defined(PROTOCOL_CHIBIOS) && PORT_SUPPORTS_RT
+#        define TIMEBASE_TICKS() chSysGetRealtimeCounterX() // DWT cycle counter on Cortex-M3 and up
+#        define TIMEBASE_TICKS_PER_US (CPU_CLOCK / 1000000)
+#        define TIMEBASE_HIGH_RESOLUTION
+#        define TIMEBASE_DWT
+#    else
+#        define TIMEBASE_TICKS() (timer_read32() * 1000) // no better source, millisecond steps
+#        define TIMEBASE_TICKS_PER_US 1
+#    endif
+#endif